@@ -0,0 +1,290 @@
+/**
+ * Distributed group by and distinct count on 64 bit keys, so counts per key come straight out of the cluster
+ * instead of a serial pass over a sorted output file.
+ *
+ * Keys in a small range, no wider than the number of values, never need sorting. Each rank builds a histogram
+ * of counts and payload sums over the whole range and one MPI_Reduce_scatter both sums them and hands every
+ * rank its own slice of the range, like the counting sort in dist_ops.c but without moving any values.
+ *
+ * Wide ranges go through the sort instead. Each rank sorts and combines its keys first, so duplicates
+ * collapse before anything is sent, then the rows are cut at splitters sampled from the distinct keys,
+ * exchanged once and combined again.
+ *
+ * When an estimate is enough the HyperLogLog counter needs a few KB per rank whatever the input,
+ * and merging all ranks' counters is a single max reduction.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "typed_ops.h"
+#include "agg_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * Increasing comparator of rows on their key, for qsort.
+ */
+static int agg_compare(const void *a, const void *b) {
+    const int64_t x = ((const agg_row_t *)a)->key, y = ((const agg_row_t *)b)->key;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * Sort rows on their key and fold rows of equal keys together in place. Returns the rows left.
+ */
+static int agg_merge(agg_row_t rows[], const int size) {
+    int n = 0;
+
+    qsort(rows, size, sizeof(agg_row_t), agg_compare);
+    for (int i = 0; i < size; ++i) {
+        if (n > 0 && rows[n-1].key == rows[i].key) {
+            rows[n-1].count += rows[i].count;
+            rows[n-1].sum += rows[i].sum;
+        } else {
+            rows[n++] = rows[i];
+        }
+    }
+
+    return n;
+}
+
+/*
+ * MPI_Op over lib_aggregate's bounds: the complemented min and the max take the larger, the value counts add up.
+ */
+static void agg_bounds_merge(void *in, void *inout, int *len, MPI_Datatype *type) {
+    const int64_t *src = (const int64_t *)in;
+    int64_t *dst = (int64_t *)inout;
+
+    (void)type;
+    for (int i = 0; i < 3 * *len; i += 3) {
+        dst[i] = src[i] > dst[i] ? src[i] : dst[i];
+        dst[i+1] = src[i+1] > dst[i+1] ? src[i+1] : dst[i+1];
+        dst[i+2] += src[i+2];
+    }
+}
+
+/*
+ * Histogram path of lib_aggregate for keys in [lo, lo + range), each rank gets the rows of its even slice.
+ */
+static int agg_histogram(MPI_Comm comm, const kv64_t vals[], const int size, const int64_t lo, const int range,
+        agg_row_t *out[]) {
+    int id = 0, world = 0, rows = 0, *counts = NULL;
+    int64_t *hist = NULL, *mine = NULL;
+    long offset = 0, share = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    /* Count and sum of each key interleaved, so one reduction carries both. */
+    hist = (int64_t *)calloc(2 * (long)range, sizeof(int64_t));
+    counts = (int *)malloc(world * sizeof(int));
+    if (hist == NULL || counts == NULL)
+        lib_error("AGG: Can't allocate histogram on heap.");
+    for (int i = 0; i < size; ++i) {
+        hist[2 * (vals[i].key - lo)] += 1;
+        hist[2 * (vals[i].key - lo) + 1] += vals[i].payload;
+    }
+
+    for (int r = 0; r < world; ++r) {
+        lib_gen_share(range, r, world, &offset, &share);
+        counts[r] = 2 * (int)share;
+    }
+    lib_gen_share(range, id, world, &offset, &share);
+    if ((mine = (int64_t *)malloc((share > 0 ? 2 * share : 1) * sizeof(int64_t))) == NULL)
+        lib_error("AGG: Can't allocate slice on heap.");
+    MPI_Reduce_scatter(hist, mine, counts, MPI_INT64_T, MPI_SUM, comm);
+
+    for (long k = 0; k < share; ++k)
+        rows += mine[2*k] > 0;
+    if ((*out = (agg_row_t *)malloc((rows > 0 ? rows : 1) * sizeof(agg_row_t))) == NULL)
+        lib_error("AGG: Can't allocate rows on heap.");
+    rows = 0;
+    for (long k = 0; k < share; ++k) {
+        if (mine[2*k] == 0)
+            continue;
+        (*out)[rows].key = lo + offset + k;
+        (*out)[rows].count = mine[2*k];
+        (*out)[rows].sum = mine[2*k + 1];
+        ++rows;
+    }
+
+    free(hist);
+    free(counts);
+    free(mine);
+
+    return rows;
+}
+
+/*
+ * Sort path of lib_aggregate, combine locally, exchange the distinct keys at splitters and combine again.
+ */
+static int agg_sort(MPI_Comm comm, kv64_t vals[], const int size, agg_row_t *out[]) {
+    int world = 0, rows = 0, taken = 0;
+    int64_t sample[AGG_OVERSAMPLE], *splitters = NULL;
+    MPI_Datatype type;
+
+    MPI_Comm_size(comm, &world);
+
+    lib_sort_kv64(vals, size);
+    *out = (agg_row_t *)malloc((size > 0 ? size : 1) * sizeof(agg_row_t));
+    splitters = (int64_t *)malloc(world * sizeof(int64_t));
+    if (*out == NULL || splitters == NULL)
+        lib_error("AGG: Can't allocate rows on heap.");
+    rows = lib_agg_combine(vals, size, *out);
+
+    /* Sampled from the distinct keys, so the ranks end with about as many rows each. */
+    taken = rows < AGG_OVERSAMPLE ? rows : AGG_OVERSAMPLE;
+    for (int i = 0; i < taken; ++i)
+        sample[i] = (*out)[(long)(2*i + 1) * rows / (2*taken)].key;
+    lib_key_splitters(comm, sample, taken, splitters);
+
+    MPI_Type_contiguous(3, MPI_INT64_T, &type);
+    MPI_Type_commit(&type);
+    lib_key_exchange(comm, splitters, type, sizeof(agg_row_t), (void **)out, &rows);
+    MPI_Type_free(&type);
+
+    free(splitters);
+
+    return agg_merge(*out, rows);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Collapse runs of equal keys of the key sorted vals into one row each, in key order. Returns the rows written
+ * to out, which must hold size rows.
+ */
+int lib_agg_combine(const kv64_t vals[], const int size, agg_row_t out[]) {
+    int n = 0;
+
+    for (int i = 0; i < size; ++i) {
+        if (n > 0 && out[n-1].key == vals[i].key) {
+            ++out[n-1].count;
+            out[n-1].sum += vals[i].payload;
+        } else {
+            out[n].key = vals[i].key;
+            out[n].count = 1;
+            out[n].sum = vals[i].payload;
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * Group by key over comm, one row per distinct key with its count and payload sum. Small key ranges, no wider
+ * than the number of values, are summed as histograms with MPI_Reduce_scatter, each rank getting an even
+ * slice of the range. Wider or sparser ones are sorted and combined locally, cut at sample splitters, exchanged and combined again, so only distinct
+ * keys cross the network. Either way every key ends on one rank and the ranks are in key order.
+ * Vals may be reordered. Out is malloced and must be freed. Returns the rows here. Collective over comm.
+ */
+int lib_aggregate(MPI_Comm comm, kv64_t vals[], const int size, agg_row_t *out[]) {
+    int64_t bounds[3] = {INT64_MIN, INT64_MIN, size}; /* Complemented min, max and count, ~x never overflows. */
+    int64_t lo = 0;
+    uint64_t width = 0;
+    MPI_Datatype type;
+    MPI_Op op;
+
+    /* Global min, max and count in one reduction, empty ranks add nothing. */
+    for (int i = 0; i < size; ++i) {
+        if (~vals[i].key > bounds[0])
+            bounds[0] = ~vals[i].key;
+        if (vals[i].key > bounds[1])
+            bounds[1] = vals[i].key;
+    }
+    MPI_Type_contiguous(3, MPI_INT64_T, &type);
+    MPI_Type_commit(&type);
+    MPI_Op_create(agg_bounds_merge, 1, &op);
+    MPI_Allreduce(MPI_IN_PLACE, bounds, 1, type, op, comm);
+    MPI_Op_free(&op);
+    MPI_Type_free(&type);
+    lo = ~bounds[0];
+
+    /* Nothing on any rank leaves the max below the min. */
+    if (bounds[1] < lo) {
+        if ((*out = (agg_row_t *)malloc(sizeof(agg_row_t))) == NULL)
+            lib_error("AGG: Can't allocate rows on heap.");
+        return 0;
+    }
+
+    /* A histogram wider than the values would cost more to sum than sorting them, range - 1 < count. */
+    width = (uint64_t)bounds[1] - (uint64_t)lo;
+    if (width < AGG_RANGE && width < (uint64_t)bounds[2])
+        return agg_histogram(comm, vals, size, lo, (int)(width + 1), out);
+
+    return agg_sort(comm, vals, size, out);
+}
+
+/*
+ * Empty counter.
+ */
+void lib_hll_init(hll_t *hll) {
+    memset(hll->regs, 0, sizeof(hll->regs));
+}
+
+/*
+ * Count key into the counter.
+ */
+void lib_hll_add(hll_t *hll, const int64_t key) {
+    const uint64_t h = lib_mix64((uint64_t)key);
+    uint64_t rest = h << HLL_BITS;
+    unsigned char rank = 1;
+
+    /* Position of the first one bit after the bucket bits, a run of zeros is 1 in 2^rank. */
+    while (rank <= 64 - HLL_BITS && (rest & (1ULL << 63)) == 0) {
+        ++rank;
+        rest <<= 1;
+    }
+    if (rank > hll->regs[h >> (64 - HLL_BITS)])
+        hll->regs[h >> (64 - HLL_BITS)] = rank;
+}
+
+/*
+ * Merge every rank's counter over comm with one MPI_Allreduce, a register wise max. Collective over comm.
+ */
+void lib_hll_allreduce(MPI_Comm comm, hll_t *hll) {
+    MPI_Allreduce(MPI_IN_PLACE, hll->regs, HLL_REGISTERS, MPI_UNSIGNED_CHAR, MPI_MAX, comm);
+}
+
+/*
+ * Estimated number of distinct keys counted, with the linear counting correction for small counts.
+ */
+double lib_hll_estimate(const hll_t *hll) {
+    const double m = HLL_REGISTERS, alpha = 0.7213 / (1.0 + 1.079 / m);
+    double sum = 0.0, estimate = 0.0;
+    int zeros = 0;
+
+    for (int i = 0; i < HLL_REGISTERS; ++i) {
+        sum += ldexp(1.0, -hll->regs[i]);
+        zeros += hll->regs[i] == 0;
+    }
+    estimate = alpha * m * m / sum;
+
+    /* Few keys leave many registers empty, counting those is more accurate. */
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+
+    return estimate;
+}
@@ -0,0 +1,72 @@
+#ifndef _AGG_OPS_H_
+#define _AGG_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "typed_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Output of qAggregate. */
+#define AGG_OUTPUT          "aggregate.bin"
+/* Widest key range (max - min + 1) aggregated through a histogram, wider or sparser ranges go through the sort. */
+#define AGG_RANGE           (1 << 20)
+/* Key samples each rank takes to pick the splitters of the sort path. */
+#define AGG_OVERSAMPLE      64
+/* Index bits of the HyperLogLog hash, 2^HLL_BITS registers, standard error 1.04 / sqrt(registers). */
+#define HLL_BITS            12
+#define HLL_REGISTERS       (1 << HLL_BITS)
+
+/******************* Type Declarations ********************/
+/* Everything the group by keeps of one key, how often it occurs and the sum of its payloads. */
+typedef struct agg_row_s {
+    int64_t key;
+    int64_t count;
+    int64_t sum;
+} agg_row_t;
+
+/* HyperLogLog distinct counter, register i holds the longest run of leading zeros seen for hash bucket i. */
+typedef struct hll_s {
+    unsigned char regs[HLL_REGISTERS];
+} hll_t;
+
+/********************** Prototypes ************************/
+/*
+ * Collapse runs of equal keys of the key sorted vals into one row each, in key order. Returns the rows written
+ * to out, which must hold size rows.
+ */
+int lib_agg_combine(const kv64_t vals[], const int size, agg_row_t out[]);
+
+/*
+ * Group by key over comm, one row per distinct key with its count and payload sum. Small key ranges, no wider
+ * than the number of values, are summed as histograms with MPI_Reduce_scatter, each rank getting an even
+ * slice of the range. Wider or sparser ones are sorted and combined locally, cut at sample splitters, exchanged and combined again, so only distinct
+ * keys cross the network. Either way every key ends on one rank and the ranks are in key order.
+ * Vals may be reordered. Out is malloced and must be freed. Returns the rows here. Collective over comm.
+ */
+int lib_aggregate(MPI_Comm comm, kv64_t vals[], const int size, agg_row_t *out[]);
+
+/*
+ * Empty counter.
+ */
+void lib_hll_init(hll_t *hll);
+
+/*
+ * Count key into the counter.
+ */
+void lib_hll_add(hll_t *hll, const int64_t key);
+
+/*
+ * Merge every rank's counter over comm with one MPI_Allreduce, a register wise max. Collective over comm.
+ */
+void lib_hll_allreduce(MPI_Comm comm, hll_t *hll);
+
+/*
+ * Estimated number of distinct keys counted, with the linear counting correction for small counts.
+ */
+double lib_hll_estimate(const hll_t *hll);
+
+#endif /* _AGG_OPS_H_ */
@@ -4,6 +4,9 @@
  */
 /********************* Header Files ***********************/
 /* C Headers */
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,16 +15,468 @@
 /* Project Headers */
 #include "array_ops.h"
 
-/******************* Constants/Macros *********************/
+/* Vector partition kernel is only built where gcc can target avx2 per function. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTITION_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
 
+/******************* Constants/Macros *********************/
+/* Size of the offset blocks used by the branchless partition, must fit in an unsigned char. */
+#define PARTITION_BLOCK_SIZE 128
+/* Arrays smaller than this are partitioned by the plain scan, kernels don't pay off below it. */
+#define PARTITION_MIN       256
+/* Width of an avx2 vector in ints. */
+#define VEC_WIDTH           8
+/* Ranges larger than this select with Floyd-Rivest sampling, smaller use introselect. */
+#define FLOYD_RIVEST_MIN    600
+/* Keys descending the splitter tree together in lib_classify. */
+#define CLASSIFY_UNROLL     8
+/* Most comparators of a merge exchange network up to NETWORK_MAX, 191 for 32. */
+#define NETWORK_PAIRS       256
+/* Branchless compare exchange, leaves the smaller of a and b in a. */
+#define CSWAP(a, b)         do { int lo_ = (a) < (b) ? (a) : (b); (b) = (a) < (b) ? (b) : (a); (a) = lo_; } while (0)
 
 /******************* Type Definitions *********************/
-
+/* A partition kernel, returns number of elements <= pivot now at front of vals. */
+typedef int (*partition_fn_t)(int pivot, int vals[], const int size);
 
 /**************** Static Data Definitions *****************/
+/* State of the local xorshift generator, never zero. */
+static uint64_t rand_state = MIX_GOLDEN;
+
+/* Kernel selected by lib_partition_init, NULL until first partition. */
+static partition_fn_t partition_kernel = NULL;
+
+#ifdef PARTITION_HAVE_AVX2
+/* For each 8 bit compare mask, lane order putting lanes <= pivot first and lanes > pivot last. */
+static int partition_perm[1<<VEC_WIDTH][VEC_WIDTH];
+#endif
 
+/* Comparators of the network for each size, built on first use. */
+static unsigned char network_pairs[NETWORK_MAX+1][NETWORK_PAIRS][2];
+static int network_size[NETWORK_MAX+1];
+static int network_built = 0;
 
 /****************** Static Functions **********************/
+/*
+ * Original Hoare style scan, used for small arrays and to finish off the block kernels.
+ * Returns number of elements <= pivot, which are at the front.
+ */
+static int partition_scan(int pivot, int vals[], const int size) {
+    int *left = vals, *right = vals + size-1;
+    int lt_size = 0;
+
+    if (size <= 0)
+        return 0;
+
+    /* Done when left and right cross makes difference negative. */
+    while (left < right) {
+        /* Scan until left points to larger than pivot and right points to less than pivot.  */
+        while (left < right && *left <= pivot) {
+            ++left;
+            ++lt_size;
+        }
+        while (left < right && *right > pivot) {
+            --right;
+        }
+        if (left < right)
+            lib_swap(left, right);
+    }
+
+    /* Scans stop when pointers meet, the element they meet on hasn't been counted yet. */
+    if (*left <= pivot)
+        ++lt_size;
+
+    return lt_size;
+}
+
+/*
+ * Branchless block partition (BlockQuicksort, Edelkamp & Weiss). Each side scans a block and
+ * records the offsets of misplaced elements without branching on the comparison, then the
+ * misplaced pairs are swapped. Leftover middle is finished with the plain scan.
+ */
+static int partition_block(int pivot, int vals[], const int size) {
+    unsigned char offs_l[PARTITION_BLOCK_SIZE], offs_r[PARTITION_BLOCK_SIZE];
+    int *left = vals, *right = vals + size-1, *a = NULL, *b = NULL;
+    int num_l = 0, num_r = 0, start_l = 0, start_r = 0, num = 0, temp = 0;
+
+    /* Left and right are inclusive, need two whole blocks between them. */
+    while (right - left + 1 > 2*PARTITION_BLOCK_SIZE) {
+        if (num_l == 0) {
+            start_l = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; ++i) {
+                offs_l[num_l] = i;
+                num_l += (left[i] > pivot);
+            }
+        }
+        if (num_r == 0) {
+            start_r = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; ++i) {
+                offs_r[num_r] = i;
+                num_r += (*(right - i) <= pivot);
+            }
+        }
+
+        /* Swap as many misplaced pairs as both blocks have. */
+        num = num_l < num_r ? num_l : num_r;
+        for (int j = 0; j < num; ++j) {
+            a = left + offs_l[start_l + j];
+            b = right - offs_r[start_r + j];
+            temp = *a;
+            *a = *b;
+            *b = temp;
+        }
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+
+        /* A block with no misplaced elements left is done. */
+        if (num_l == 0)
+            left += PARTITION_BLOCK_SIZE;
+        if (num_r == 0)
+            right -= PARTITION_BLOCK_SIZE;
+    }
+
+    /* Everything before left is <= pivot, everything after right is > pivot. */
+    return (left - vals) + partition_scan(pivot, left, right - left + 1);
+}
+
+/*
+ * Floyd-Rivest select on the inclusive index range [left, right] of vals, k is an absolute index.
+ * Recursively selects on a small sample to get two pivots that bracket k with high probability,
+ * so almost all elements are only compared once. See Floyd & Rivest, CACM 1975, algorithm 489.
+ */
+static void select_floyd_rivest(int vals[], int left, int right, const int k) {
+    double n = 0, i = 0, z = 0, s = 0, sd = 0;
+    int new_left = 0, new_right = 0, lo = 0, hi = 0, t = 0;
+
+    while (right > left) {
+        if (right - left > FLOYD_RIVEST_MIN) {
+            n = right - left + 1;
+            i = k - left + 1;
+            z = log(n);
+            s = 0.5 * exp(2*z/3);
+            sd = 0.5 * sqrt(z * s * (n - s)/n) * (i < n/2 ? -1 : 1);
+            new_left = k - i*s/n + sd;
+            new_right = k + (n - i)*s/n + sd;
+            select_floyd_rivest(vals, new_left > left ? new_left : left, new_right < right ? new_right : right, k);
+        }
+
+        /* Partition [left, right] around t = vals[k], sentinels at both ends keep the scans unguarded. */
+        t = vals[k];
+        lo = left;
+        hi = right;
+        lib_swap(vals+left, vals+k);
+        if (vals[right] > t)
+            lib_swap(vals+right, vals+left);
+        while (lo < hi) {
+            lib_swap(vals+lo, vals+hi);
+            ++lo;
+            --hi;
+            while (vals[lo] < t)
+                ++lo;
+            while (vals[hi] > t)
+                --hi;
+        }
+
+        if (vals[left] == t) {
+            lib_swap(vals+left, vals+hi);
+        } else {
+            ++hi;
+            lib_swap(vals+hi, vals+right);
+        }
+
+        /* Narrow to the side holding k. */
+        if (hi <= k)
+            left = hi + 1;
+        if (k <= hi)
+            right = hi - 1;
+    }
+}
+
+/*
+ * Introselect on [left, right], pivots are random until the range stops halving often enough,
+ * then median of medians guarantees linear time. Three way partitions finish as soon as kth lands among
+ * the keys equal to the pivot, so duplicates shrink the range instead of stalling it. Returns index of kth
+ * relative to left.
+ */
+static int select_intro(int kth, int *left, int *right) {
+    int *store_l = left;
+    int size = 0, budget = 0, pivot_index = 0, lt = 0, eq = 0, gt = 0;
+
+    for (size = right-left+1; size > 1; size >>= 1)
+        budget += 2;
+
+    while (1) {
+        size = right-left+1;
+        if (size == 1)
+            return left - store_l;
+
+        /* Out of random tries, pay for a pivot that is guaranteed near the middle. */
+        if (budget-- > 0 || size < 10)
+            pivot_index = lib_rand_range(size);
+        else
+            pivot_index = lib_median_of_medians(left, 0, size-1);
+
+        /* Kth among the smaller keys moves the right pointer left, among the larger the left pointer right. */
+        lib_partition3_by_pivot_val(left[pivot_index], left, size, &lt, &eq, &gt);
+        if (kth <= lt) {
+            right = left+lt-1;
+        } else if (kth <= lt+eq) {
+            return left+kth-1 - store_l;
+        } else {
+            kth -= lt+eq;
+            left += lt+eq;
+        }
+    }
+}
+
+#ifdef PARTITION_HAVE_AVX2
+/*
+ * Build the permutation table for the avx2 kernel, lanes <= pivot keep their order at the front.
+ */
+static void partition_build_perm(void) {
+    int lo = 0, hi = 0;
+
+    for (int mask = 0; mask < (1<<VEC_WIDTH); ++mask) {
+        lo = 0;
+        hi = VEC_WIDTH - __builtin_popcount(mask);
+        for (int lane = 0; lane < VEC_WIDTH; ++lane) {
+            if (mask & (1<<lane))
+                partition_perm[mask][hi++] = lane;
+            else
+                partition_perm[mask][lo++] = lane;
+        }
+    }
+}
+
+/*
+ * In place avx2 partition. The first and last vectors are held in registers to open a gap at each end,
+ * every vector read after that is compressed with the permute table and stored to both write fronts.
+ * The side with the smaller gap is read next so a store never clobbers unread data.
+ */
+__attribute__((target("avx2")))
+static int partition_avx2(int pivot, int vals[], const int size) {
+    const __m256i pv = _mm256_set1_epi32(pivot);
+    __m256i first, last, v, p, perm;
+    int tail[3*VEC_WIDTH];
+    int read_l = VEC_WIDTH, read_r = size - VEC_WIDTH, write_l = 0, write_r = size;
+    int mask = 0, num_gt = 0, num_tail = 0, x = 0;
+
+    first = _mm256_loadu_si256((__m256i *)vals);
+    last = _mm256_loadu_si256((__m256i *)(vals + size - VEC_WIDTH));
+
+    while (read_r - read_l >= VEC_WIDTH) {
+        if (read_l - write_l <= write_r - read_r) {
+            v = _mm256_loadu_si256((__m256i *)(vals + read_l));
+            read_l += VEC_WIDTH;
+        } else {
+            read_r -= VEC_WIDTH;
+            v = _mm256_loadu_si256((__m256i *)(vals + read_r));
+        }
+
+        mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pv)));
+        num_gt = __builtin_popcount(mask);
+        perm = _mm256_loadu_si256((__m256i *)partition_perm[mask]);
+        p = _mm256_permutevar8x32_epi32(v, perm);
+
+        /* Lanes <= pivot are at the front of p and lanes > pivot at the back, store to both ends. */
+        _mm256_storeu_si256((__m256i *)(vals + write_l), p);
+        write_l += VEC_WIDTH - num_gt;
+        _mm256_storeu_si256((__m256i *)(vals + write_r - VEC_WIDTH), p);
+        write_r -= num_gt;
+    }
+
+    /* Stash the unread middle with the two held vectors, then place them one by one into the gap. */
+    for (int i = read_l; i < read_r; ++i)
+        tail[num_tail++] = vals[i];
+    _mm256_storeu_si256((__m256i *)(tail + num_tail), first);
+    _mm256_storeu_si256((__m256i *)(tail + num_tail + VEC_WIDTH), last);
+    num_tail += 2*VEC_WIDTH;
+
+    for (int i = 0; i < num_tail; ++i) {
+        x = tail[i];
+        if (x <= pivot)
+            vals[write_l++] = x;
+        else
+            vals[--write_r] = x;
+    }
+
+    return write_l;
+}
+#endif
+
+/*
+ * Build the comparator lists of Batcher's merge exchange (Knuth 5.2.2 M) for every size up to NETWORK_MAX.
+ * Works for any size, not only powers of two.
+ */
+static void network_build(void) {
+    int t = 0, p = 0, q = 0, r = 0, d = 0, pairs = 0;
+
+    for (int n = 2; n <= NETWORK_MAX; ++n) {
+        t = 0;
+        while ((1 << t) < n)
+            ++t;
+        pairs = 0;
+        for (p = 1 << (t-1); p > 0; p >>= 1) {
+            q = 1 << (t-1);
+            r = 0;
+            d = p;
+            while (d > 0) {
+                for (int i = 0; i < n-d; ++i) {
+                    if ((i & p) == r) {
+                        network_pairs[n][pairs][0] = (unsigned char)i;
+                        network_pairs[n][pairs][1] = (unsigned char)(i+d);
+                        ++pairs;
+                    }
+                }
+                d = q - p;
+                q >>= 1;
+                r = p;
+            }
+        }
+        network_size[n] = pairs;
+    }
+    network_built = 1;
+}
+
+/*
+ * Sift vals[root] down the max heap of size values.
+ */
+static void sort_sift(int vals[], int root, const int size) {
+    int child = 0, val = vals[root];
+
+    while ((child = 2*root + 1) < size) {
+        if (child+1 < size && vals[child+1] > vals[child])
+            ++child;
+        if (vals[child] <= val)
+            break;
+        vals[root] = vals[child];
+        root = child;
+    }
+    vals[root] = val;
+}
+
+/*
+ * Heapsort, introsort's fallback once a range recursed too deep.
+ */
+static void sort_heap(int vals[], const int size) {
+    for (int i = size/2 - 1; i >= 0; --i)
+        sort_sift(vals, i, size);
+    for (int end = size-1; end > 0; --end) {
+        lib_swap(vals, vals+end);
+        sort_sift(vals, 0, end);
+    }
+}
+
+/*
+ * Introsort body, recurse into the smaller side and loop on the larger so the stack stays logarithmic.
+ */
+static void sort_intro(int vals[], int size, int depth) {
+    int lo = 0, mid = 0, hi = 0, lt = 0, eq = 0, gt = 0;
+
+    while (size > NETWORK_MAX) {
+        if (depth-- == 0) {
+            sort_heap(vals, size);
+            return;
+        }
+
+        /* Median of first, middle and last. */
+        lo = vals[0];
+        mid = vals[size/2];
+        hi = vals[size-1];
+        CSWAP(lo, mid);
+        CSWAP(mid, hi);
+        CSWAP(lo, mid);
+
+        /* Equal keys are done, duplicate heavy ranges shrink fast. */
+        lib_partition3_by_pivot_val(mid, vals, size, &lt, &eq, &gt);
+        if (lt < gt) {
+            sort_intro(vals, lt, depth);
+            vals += lt + eq;
+            size = gt;
+        } else {
+            sort_intro(vals+lt+eq, gt, depth);
+            size = lt;
+        }
+    }
+
+    lib_sort_small(vals, size);
+}
+
+/*
+ * Start of each natural run of vals in starts, counting stops once past limit. Returns the runs found,
+ * at most limit + 1. Starts must hold limit + 1 ints, or be NULL to only count.
+ */
+static int sort_runs(const int vals[], const int size, const int limit, int starts[]) {
+    int runs = size > 0;
+
+    if (starts != NULL && size > 0)
+        starts[0] = 0;
+    for (int i = 1; i < size && runs <= limit; ++i) {
+        if (vals[i] < vals[i-1]) {
+            if (starts != NULL)
+                starts[runs] = i;
+            ++runs;
+        }
+    }
+
+    return runs;
+}
+
+/*
+ * Merge the sorted a and b into out, ties taken from a first.
+ */
+static void sort_merge(const int a[], const int a_size, const int b[], const int b_size, int out[]) {
+    int i = 0, j = 0, k = 0;
+
+    while (i < a_size && j < b_size)
+        out[k++] = b[j] < a[i] ? b[j++] : a[i++];
+    while (i < a_size)
+        out[k++] = a[i++];
+    while (j < b_size)
+        out[k++] = b[j++];
+}
+
+/*
+ * Sort level h of the sketch and move every other item up a level, an odd one out stays.
+ */
+static void sketch_compact(quantile_sketch_t *sketch, const int h) {
+    int *items = sketch->items[h];
+    const int size = sketch->sizes[h], pairs = size / 2;
+
+    if (h+1 >= SKETCH_LEVELS)
+        lib_error("SKETCH: Too many values for the sketch.");
+
+    /* Make room above first. */
+    if (sketch->sizes[h+1] + pairs > SKETCH_K)
+        sketch_compact(sketch, h+1);
+
+    lib_sort(items, size);
+    for (int i = 0; i < pairs; ++i)
+        sketch->items[h+1][sketch->sizes[h+1]++] = items[2*i + sketch->flips[h]];
+    sketch->flips[h] ^= 1;
+
+    if (size % 2 == 1)
+        items[0] = items[size-1];
+    sketch->sizes[h] = size % 2;
+    if (sketch->levels < h+2)
+        sketch->levels = h+2;
+}
+
+/*
+ * Add one item of weight 2^h to the sketch, compacting its level first if full.
+ */
+static void sketch_push(quantile_sketch_t *sketch, const int h, const int val) {
+    if (sketch->sizes[h] == SKETCH_K)
+        sketch_compact(sketch, h);
+
+    sketch->items[h][sketch->sizes[h]++] = val;
+    if (sketch->levels < h+1)
+        sketch->levels = h+1;
+}
 
 
 /**************** Global Data Definitions *****************/
@@ -40,7 +495,10 @@ void lib_error(const char * const mesg) {
  * Standard increasing comparator for qsort.
  */
 int lib_compare (const void *a, const void *b) {
-    return *((int *)a) - *((int *)b);
+    int x = *((int *)a), y = *((int *)b);
+
+    /* Subtraction overflows once inputs span the full int range. */
+    return (x > y) - (x < y);
 }
 
 /*
@@ -61,7 +519,7 @@ int lib_select_pivot(int vals[], const int size) {
 //	const int start = 0, mid = size/2, end = size-1;
 //	int large, small, pivot;
 
-    qsort(vals, size, sizeof(int), lib_compare);
+    lib_sort(vals, size);
     return vals[size/2];
 }
 
@@ -74,27 +532,53 @@ void lib_swap(int *a, int *b) {
     *b = temp;
 }
 
+/*
+ * Select the partition kernel used for large arrays. PARTITION_AUTO picks avx2 when the cpu has it
+ * else the branchless block kernel. Returns the kernel actually chosen.
+ */
+partition_kernel_t lib_partition_init(partition_kernel_t kernel) {
+#ifdef PARTITION_HAVE_AVX2
+    __builtin_cpu_init();
+    if (kernel == PARTITION_AUTO)
+        kernel = __builtin_cpu_supports("avx2") ? PARTITION_AVX2 : PARTITION_BLOCK;
+    if (kernel == PARTITION_AVX2 && !__builtin_cpu_supports("avx2"))
+        kernel = PARTITION_BLOCK;
+#else
+    if (kernel == PARTITION_AUTO || kernel == PARTITION_AVX2)
+        kernel = PARTITION_BLOCK;
+#endif
+
+    switch (kernel) {
+#ifdef PARTITION_HAVE_AVX2
+    case PARTITION_AVX2:
+        partition_build_perm();
+        partition_kernel = partition_avx2;
+        break;
+#endif
+    case PARTITION_SCAN:
+        partition_kernel = partition_scan;
+        break;
+    default:
+        kernel = PARTITION_BLOCK;
+        partition_kernel = partition_block;
+        break;
+    }
+
+    return kernel;
+}
+
 /*
  * Partition the passed in array in place. All elements at the front will be less than or equal to pivot.
  * All elements at back will be strictly greater than pivot. Pivot value passed in, not necessarily present.
  */
 void lib_partition_by_pivot_val(int pivot, int vals[], const int vals_size, int *lt_size, int *gt_size) {
-    int *left = vals, *right = vals + vals_size-1;
-    *lt_size = 0;
+    if (partition_kernel == NULL)
+        lib_partition_init(PARTITION_AUTO);
 
-    /* Done when left and right cross makes difference negative. */
-    while (left < right) {
-        /* Scan until left points to larger than pivot and right points to less than pivot.  */
-        while (left < right && *left <= pivot) {
-            ++left;
-            ++*lt_size;
-        }
-        while (left < right && *right > pivot) {
-            --right;
-        }
-        if (left < right)
-            lib_swap(left, right);
-    }
+    if (vals_size < PARTITION_MIN)
+        *lt_size = partition_scan(pivot, vals, vals_size);
+    else
+        *lt_size = partition_kernel(pivot, vals, vals_size);
 
     *gt_size = vals_size - *lt_size;
 }
@@ -106,11 +590,21 @@ void lib_partition_by_pivot_val(int pivot, int vals[], const int vals_size, int
 int lib_partition_by_pivot_index(int pivot_index, int *left, int *right) {
     /* Store them starting at left and moving right. */
     int *store_l = left, *store_r = right;
-    int pivot_val = left[pivot_index];
+    int pivot_val = left[pivot_index], size = right - left + 1, lt_size = 0;
 
     /* Move pivot to farthest left value in array. */
     lib_swap(left+pivot_index, left);
 
+    /* Large ranges, partition everything after the pivot with the kernel then drop pivot in between. */
+    if (size >= PARTITION_MIN) {
+        if (partition_kernel == NULL)
+            lib_partition_init(PARTITION_AUTO);
+
+        lt_size = partition_kernel(pivot_val, left+1, size-1);
+        lib_swap(left, left+lt_size);
+        return lt_size;
+    }
+
     while (left < right) {
         /* Scan until left points to larger than pivot and right points to less than pivot.  */
         while (*left <= pivot_val && left != store_r)
@@ -129,33 +623,272 @@ int lib_partition_by_pivot_index(int pivot_index, int *left, int *right) {
     return right-store_l;
 }
 
+/*
+ * Three way partition in place: keys < pivot at the front, keys == pivot in the middle and keys > pivot at the back.
+ */
+void lib_partition3_by_pivot_val(int pivot, int vals[], const int vals_size, int *lt_size, int *eq_size, int *gt_size) {
+    int le_size = 0, unused = 0;
+
+    /* Two passes of the fast two way kernel, the second only over the front. Keys < pivot are keys <= pivot-1. */
+    lib_partition_by_pivot_val(pivot, vals, vals_size, &le_size, gt_size);
+    if (pivot == INT_MIN)
+        *lt_size = 0;
+    else
+        lib_partition_by_pivot_val(pivot-1, vals, le_size, lt_size, &unused);
+    *eq_size = le_size - *lt_size;
+}
+
+/*
+ * Hypercube partners hold three way partitioned arrays [lt | eq | gt], counts are {lt, eq, gt} of this side
+ * and of the partner, upper is non zero on the partner in the upper half of the dimension.
+ * Keys equal to the pivot may go to either partner, so the equal band is split to leave both with
+ * loads as even as possible. Sets the contiguous part of this array to keep and the part to send.
+ */
+void lib_split_equal(const int mine[3], const int theirs[3], const int upper,
+        int *keep_from, int *keep_size, int *send_from, int *send_size) {
+    const int *low = upper ? theirs : mine, *high = upper ? mine : theirs;
+    long lt = (long)low[0] + high[0], eq = (long)low[1] + high[1], gt = (long)low[2] + high[2];
+    long eq_low = (lt + eq + gt)/2 - lt, low_keeps = 0, high_gives = 0;
+    const int size = mine[0] + mine[1] + mine[2];
+
+    /* Equal keys the lower partner should end with, taken from its own band first. Both sides compute the same. */
+    eq_low = eq_low < 0 ? 0 : (eq_low > eq ? eq : eq_low);
+    low_keeps = eq_low < low[1] ? eq_low : low[1];
+    high_gives = eq_low - low_keeps;
+
+    if (upper) {
+        /* Send lt and the front of the equal band, keep the rest. */
+        *send_from = 0;
+        *send_size = mine[0] + high_gives;
+        *keep_from = *send_size;
+        *keep_size = size - *send_size;
+    } else {
+        /* Keep lt and the front of the equal band, send the rest. */
+        *keep_from = 0;
+        *keep_size = mine[0] + low_keeps;
+        *send_from = *keep_size;
+        *send_size = size - *keep_size;
+    }
+}
+
+/*
+ * Classify vals into 2^levels buckets in one pass. Tree holds the 2^levels - 1 sorted splitters as an implicit
+ * search tree in breadth first order, the children of node i at 2i+1 and 2i+2, as lib_select_pivots_from_medians
+ * lays them out. Bucket b gets the keys above its left splitter and at most its right one.
+ * Out receives vals grouped by bucket in bucket order, counts the size of each bucket.
+ */
+void lib_classify(const int tree[], const int levels, const int vals[], const int vals_size, int counts[], int out[]) {
+    const int buckets = 1 << levels, first_leaf = buckets - 1;
+    unsigned char *oracle = NULL;
+    int node[CLASSIFY_UNROLL], next[1 << CLASSIFY_MAX_LEVELS];
+    int i = 0;
+
+    if (levels < 0 || levels > CLASSIFY_MAX_LEVELS)
+        lib_error("CLASSIFY: Tree is too deep.");
+    if ((oracle = (unsigned char *)malloc(vals_size > 0 ? vals_size : 1)) == NULL)
+        lib_error("CLASSIFY: Can't allocate oracle on heap.");
+    memset(counts, 0, buckets * sizeof(int));
+
+    /*
+     * Descend the tree without branches, a comparison picks the child. Several keys go down together
+     * so their loads and compares overlap instead of waiting on each other. The bucket of every key is
+     * remembered so the second pass doesn't compare again.
+     */
+    for (; i + CLASSIFY_UNROLL <= vals_size; i += CLASSIFY_UNROLL) {
+        for (int j = 0; j < CLASSIFY_UNROLL; ++j)
+            node[j] = 0;
+        for (int l = 0; l < levels; ++l)
+            for (int j = 0; j < CLASSIFY_UNROLL; ++j)
+                node[j] = 2*node[j] + 1 + (vals[i+j] > tree[node[j]]);
+        for (int j = 0; j < CLASSIFY_UNROLL; ++j) {
+            oracle[i+j] = (unsigned char)(node[j] - first_leaf);
+            ++counts[node[j] - first_leaf];
+        }
+    }
+    for (; i < vals_size; ++i) {
+        node[0] = 0;
+        for (int l = 0; l < levels; ++l)
+            node[0] = 2*node[0] + 1 + (vals[i] > tree[node[0]]);
+        oracle[i] = (unsigned char)(node[0] - first_leaf);
+        ++counts[node[0] - first_leaf];
+    }
+
+    /* Each bucket writes into its own block of out. */
+    next[0] = 0;
+    for (int b = 1; b < buckets; ++b)
+        next[b] = next[b-1] + counts[b-1];
+    for (i = 0; i < vals_size; ++i)
+        out[next[oracle[i]]++] = vals[i];
+
+    free(oracle);
+}
+
+/*
+ * Splitmix64 finalizer, every bit of the result depends on every bit of z. The one mixer behind the seeds,
+ * the generated inputs and the hashes, so hashes compared across modules can't drift apart.
+ */
+uint64_t lib_mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Seed the local generator used for random pivots. Same seed gives the same pivots.
+ */
+void lib_rand_seed(const uint64_t seed) {
+    /* Scramble with splitmix64 so nearby seeds give unrelated streams, state must not be zero. */
+    rand_state = lib_mix64(seed + MIX_GOLDEN) | 1;
+}
+
+/*
+ * Next 64 bit value of the local xorshift64* generator, a few cycles instead of libc rand().
+ */
+uint64_t lib_rand_next(void) {
+    rand_state ^= rand_state >> 12;
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    return rand_state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * Uniform value in [0, bound) without a division, multiply and shift (Lemire).
+ */
+int lib_rand_range(const int bound) {
+    return (int)(((lib_rand_next() >> 32) * (uint64_t)bound) >> 32);
+}
+
 /*
  * Select the kth largest element from the range of values in the array, where 1 would be smallest and n the largest.
- * Starts at k = 1..N.
+ * Starts at k = 1..N. Large ranges use Floyd-Rivest, small ones introselect.
  */
 int lib_select_kth(int kth, int *left, int *right) {
-    int new_pivot_index = 0, rand_index = 0, pivot_dist = -1;
-    int *store_l = left;
+    if (right - left + 1 > FLOYD_RIVEST_MIN)
+        return lib_select_floyd_rivest(kth, left, right);
 
-    /* Until we get to kth, select a random index and partition. Then we get new pivot index. */
-    while (1) {
-        rand_index = rand() % (right-left+1);
-        new_pivot_index = lib_partition_by_pivot_index(rand_index, left, right);
-        pivot_dist = new_pivot_index+1;
+    return select_intro(kth, left, right);
+}
 
-        /* If pivot dist = kth, we are there. If > kth, we move right pointer left. Else left pointer goes right. */
-        if (pivot_dist == kth)
-            break;
-        else if (pivot_dist > kth)
-            right = left+new_pivot_index-1;
-        else {
-            kth -= pivot_dist;
-            left += new_pivot_index+1;
+/*
+ * Floyd-Rivest selection, same contract as lib_select_kth.
+ */
+int lib_select_floyd_rivest(int kth, int *left, int *right) {
+    select_floyd_rivest(left, 0, right-left, kth-1);
+    return kth-1;
+}
+
+/*
+ * Introselect, random pivots with a median of medians fallback. Same contract as lib_select_kth.
+ */
+int lib_introselect(int kth, int *left, int *right) {
+    return select_intro(kth, left, right);
+}
+
+/*
+ * Sort five values in place with an optimal nine comparator network, median ends up at vals[2].
+ */
+void lib_sort5(int vals[]) {
+    CSWAP(vals[0], vals[1]);
+    CSWAP(vals[3], vals[4]);
+    CSWAP(vals[2], vals[4]);
+    CSWAP(vals[2], vals[3]);
+    CSWAP(vals[0], vals[3]);
+    CSWAP(vals[0], vals[2]);
+    CSWAP(vals[1], vals[4]);
+    CSWAP(vals[1], vals[3]);
+    CSWAP(vals[1], vals[2]);
+}
+
+/*
+ * Sort up to NETWORK_MAX values in place with a sorting network, Batcher's merge exchange for size.
+ * Every comparator is a branchless min and max, the sequence doesn't depend on the values.
+ */
+void lib_sort_small(int vals[], const int size) {
+    if (size > NETWORK_MAX)
+        lib_error("SORT: Too many values for a network.");
+    if (size < 2)
+        return;
+    if (!network_built)
+        network_build();
+
+    for (int i = 0; i < network_size[size]; ++i)
+        CSWAP(vals[network_pairs[size][i][0]], vals[network_pairs[size][i][1]]);
+}
+
+/*
+ * Introsort of ints in place, the replacement for qsort with lib_compare. Median of three pivots and three way
+ * partitions with the partition kernels, a heapsort fallback bounds the depth and lib_sort_small finishes
+ * every part of NETWORK_MAX or fewer. No comparator calls.
+ */
+void lib_sort(int vals[], const int size) {
+    int depth = 0;
+
+    for (int n = size; n > 1; n >>= 1)
+        depth += 2;
+
+    sort_intro(vals, size, depth);
+}
+
+/*
+ * Number of natural runs in vals, maximal stretches that don't decrease. 1 means sorted, 0 empty.
+ */
+int lib_count_runs(const int vals[], const int size) {
+    return sort_runs(vals, size, INT_MAX - 1, NULL);
+}
+
+/*
+ * Sort of ints in place that pays for the disorder it finds. One pass counts the natural runs, sorted input
+ * ends there. Up to one run per ADAPT_MIN_RUN values are merged pairwise, O(n log runs), so a few appended
+ * runs or a mostly sorted array cost a few linear passes. More runs than that go to lib_sort.
+ */
+void lib_adaptive_sort(int vals[], const int size) {
+    const int limit = size / ADAPT_MIN_RUN > 1 ? size / ADAPT_MIN_RUN : 1;
+    int runs = 0, merged = 0, *starts = NULL, *buf = NULL, *src = vals, *dst = NULL, *swap = NULL;
+
+    if (size < 2)
+        return;
+    if ((starts = (int *)malloc((limit + 2) * sizeof(int))) == NULL)
+        lib_error("SORT: Can't allocate runs on heap.");
+
+    /* Counting gives up early, random input pays for a short scan only. */
+    runs = sort_runs(vals, size, limit, starts);
+    if (runs > limit) {
+        free(starts);
+        lib_sort(vals, size);
+        return;
+    }
+    if (runs == 1) {
+        free(starts);
+        return;
+    }
+
+    if ((buf = (int *)malloc(size * sizeof(int))) == NULL)
+        lib_error("SORT: Can't allocate merge buffer on heap.");
+    dst = buf;
+
+    /* Each pass merges neighbouring runs from src into dst, an odd one out is copied. */
+    starts[runs] = size;
+    while (runs > 1) {
+        merged = 0;
+        for (int r = 0; r < runs; r += 2) {
+            if (r + 1 < runs)
+                sort_merge(src + starts[r], starts[r+1] - starts[r], src + starts[r+1], starts[r+2] - starts[r+1],
+                        dst + starts[r]);
+            else
+                memcpy(dst + starts[r], src + starts[r], (starts[r+1] - starts[r]) * sizeof(int));
+            starts[merged++] = starts[r];
         }
+        starts[merged] = size;
+        runs = merged;
+        swap = src;
+        src = dst;
+        dst = swap;
     }
+    if (src != vals)
+        memcpy(vals, src, size * sizeof(int));
 
-    /* Return index of kth in original array, should be kth-1. */
-    return left+new_pivot_index - store_l;
+    free(buf);
+    free(starts);
 }
 
 /*
@@ -236,24 +969,20 @@ void lib_compress_array(int world, int root[], int root_size) {
  */
 int lib_select_medians(int *vals, const int left, const int right) {
     int num_medians = (right-left+1)/5;
-    int sub_left = 0, sub_right = 0, median_index = 0;
+    int sub_left = 0, median_index = 0;
 
-    /* For each group of five elements. */
+    /* For each group of five elements, num_medians rounds down so every group is whole. */
     for (int i = 0; i < num_medians; ++i) {
         sub_left = left+i*5;
-        sub_right = sub_left+4;
-
-        /* Bounds protection. */
-        if(sub_right > right)
-            sub_right = right;
 
-        /* Select the third largest element, the median. Swap to front. */
-        median_index = lib_select_kth(3, vals+sub_left, vals+sub_right);
+        /* Sort the group with the network, median is third. Swap to front. */
+        lib_sort5(vals+sub_left);
+        median_index = 2;
         lib_swap(vals+left+i, vals+sub_left+median_index);
     }
 
     /* Sort the new medians. */
-	qsort(vals, num_medians, sizeof(int), lib_compare);
+    lib_sort(vals, num_medians);
 
     return num_medians;
 }
@@ -303,23 +1032,96 @@ void lib_select_pivots_from_medians(const int dimension, int *pivots, const int
  */
 int lib_median_of_medians(int *vals, int left, int right) {
      int num_medians = (right+1-left)/5;
-     int sub_left, sub_right, median_index;
+     int sub_left, median_index;
 
      for (int i = 0; i < num_medians; ++i) {
          /* Get the median of the five-element subgroup. */
          sub_left = left + i*5;
-         sub_right = sub_left + 4;
 
-         /* Ensure we never leave bounds. */
-         if (sub_right > right)
-           sub_right = right;
-
-         median_index = lib_select_kth(3, vals+sub_left, vals+sub_right);
+         /* Groups are always whole, sort each with the network and the median is third. */
+         lib_sort5(vals+sub_left);
+         median_index = 2;
          /* Move the median to front of the list. */
          lib_swap(vals+left+i, vals+sub_left+median_index);
      }
 
-     /* Quick sort the small list of medians, then pick the middle median. */
-     qsort(vals, num_medians, sizeof(int), lib_compare);
-     return num_medians/2;
+     /* No full group, just use the first value. */
+     if (num_medians == 0)
+         return left;
+
+     /* Select the middle median in place, no need to sort them all. */
+     return left + lib_select_kth(num_medians/2 + 1, vals+left, vals+left+num_medians-1);
+}
+
+/*
+ * Start an empty quantile sketch.
+ */
+void lib_sketch_init(quantile_sketch_t *sketch) {
+    memset(sketch, 0, sizeof(*sketch));
+    sketch->levels = 1;
+}
+
+/*
+ * Add vals to the sketch in one streaming pass. A level that fills is sorted and every other item moves up
+ * a level at twice the weight, alternating which of each pair survives so the errors mostly cancel.
+ * Memory stays at SKETCH_LEVELS * SKETCH_K ints whatever the count, the rank error of a query is at most
+ * 2 * levels / SKETCH_K of the count and in practice far below that.
+ */
+void lib_sketch_update(quantile_sketch_t *sketch, const int vals[], const int vals_size) {
+    for (int i = 0; i < vals_size; ++i)
+        sketch_push(sketch, 0, vals[i]);
+
+    sketch->count += vals_size;
+}
+
+/*
+ * Fold src into dst, as if dst had also seen every value of src.
+ */
+void lib_sketch_merge(quantile_sketch_t *dst, const quantile_sketch_t *src) {
+    for (int h = 0; h < src->levels; ++h)
+        for (int i = 0; i < src->sizes[h]; ++i)
+            sketch_push(dst, h, src->items[h][i]);
+
+    dst->count += src->count;
+}
+
+/*
+ * Approximate value at each quantile of qs, 0 to 1, into out. An empty sketch answers 0.
+ */
+void lib_sketch_quantiles(const quantile_sketch_t *sketch, const double qs[], const int count, int out[]) {
+    int *pairs = NULL, items = 0;
+    long target = 0, acc = 0;
+
+    for (int h = 0; h < sketch->levels; ++h)
+        items += sketch->sizes[h];
+    if ((pairs = (int *)malloc(2 * (items > 0 ? items : 1) * sizeof(int))) == NULL)
+        lib_error("SKETCH: Can't allocate query array on heap.");
+
+    /* Every item as (value, level), sorted by value. lib_compare only looks at the first int. */
+    items = 0;
+    for (int h = 0; h < sketch->levels; ++h) {
+        for (int i = 0; i < sketch->sizes[h]; ++i) {
+            pairs[2*items] = sketch->items[h][i];
+            pairs[2*items+1] = h;
+            ++items;
+        }
+    }
+    qsort(pairs, items, 2 * sizeof(int), lib_compare);
+
+    /* First item whose running weight reaches the wanted rank. */
+    for (int q = 0; q < count; ++q) {
+        target = (long)ceil(qs[q] * sketch->count);
+        target = target < 1 ? 1 : target;
+        acc = 0;
+        out[q] = items > 0 ? pairs[2*(items-1)] : 0;
+        for (int i = 0; i < items; ++i) {
+            acc += 1L << pairs[2*i+1];
+            if (acc >= target) {
+                out[q] = pairs[2*i];
+                break;
+            }
+        }
+    }
+
+    free(pairs);
 }
@@ -3,6 +3,7 @@
 
 /********************* Header Files ***********************/
 /* C Headers */
+#include <stdint.h>
 
 /* Project Headers */
 
@@ -11,8 +12,20 @@
 #define GENERATE_FLAG       "gen"
 /* Max value of randomly generated numbers */
 #define MAX_VAL             10000
+/* Deepest splitter tree lib_classify takes, bucket ids must fit in a byte. */
+#define CLASSIFY_MAX_LEVELS 8
 /* Root ID */
 #define ROOT                0
+/* Largest array lib_sort_small sorts with a network, lib_sort's base case. */
+#define NETWORK_MAX         32
+/* Shortest average natural run lib_adaptive_sort still merges, shorter ones are sorted outright. */
+#define ADAPT_MIN_RUN       16
+/* Items a quantile sketch level holds before it compacts, the sketch's accuracy. */
+#define SKETCH_K            512
+/* Levels of a quantile sketch, level h items stand for 2^h values each. */
+#define SKETCH_LEVELS       32
+/* Increment of the splitmix64 sequence, odd so every index maps to a different state. */
+#define MIX_GOLDEN          0x9E3779B97F4A7C15ULL
 
 /******************* Type Declarations ********************/
 /* Struct contains information on a subgroup in a hypercube. */
@@ -24,6 +37,26 @@ typedef struct subgroup_info_s {
     int world_id; /* ID of this process in the MPI_COMM_WORLD group. */
 } subgroup_info_t;
 
+/* Kernels available to partition large arrays, see lib_partition_init. */
+typedef enum partition_kernel_e {
+    PARTITION_AUTO, /* Pick the fastest the cpu supports. */
+    PARTITION_SCAN, /* Original scalar scan with data dependent branches. */
+    PARTITION_BLOCK, /* Branchless block partition, portable fallback. */
+    PARTITION_AVX2 /* Vector compare and permute, x86 with avx2 only. */
+} partition_kernel_t;
+
+/*
+ * Mergeable quantile sketch, see lib_sketch_update. Fixed size without pointers so it can be sent as bytes
+ * and merged in a reduction.
+ */
+typedef struct quantile_sketch_s {
+    long count; /* Values summarized, also the total weight of the items. */
+    int levels; /* Levels in use. */
+    int sizes[SKETCH_LEVELS]; /* Items held at each level. */
+    int flips[SKETCH_LEVELS]; /* Which of each pair the next compaction of a level keeps, alternates. */
+    int items[SKETCH_LEVELS][SKETCH_K]; /* Items of level h each weigh 2^h. */
+} quantile_sketch_t;
+
 /********************** Prototypes ************************/
 /*
  * Generic error function, prints out the error and terminates execution.
@@ -51,6 +84,13 @@ int lib_select_pivot(int vals[], const int size);
  */
 void lib_swap(int *a, int *b);
 
+/*
+ * Select the partition kernel used for large arrays. PARTITION_AUTO picks avx2 when the cpu has it
+ * else the branchless block kernel. Returns the kernel actually chosen.
+ * Called automatically on first partition, only needed to force a kernel.
+ */
+partition_kernel_t lib_partition_init(partition_kernel_t kernel);
+
 /*
  * Partition the passed in array in place. All elements at the front will be less than or equal to pivot.
  * All elements at back will be strictly greater than pivot.
@@ -63,12 +103,98 @@ void lib_partition_by_pivot_val(int pivot, int vals[], const int vals_size, int
  */
 int lib_partition_by_pivot_index(int pivot_index, int *left, int *right);
 
+/*
+ * Three way partition in place: keys < pivot at the front, keys == pivot in the middle and keys > pivot at the back.
+ */
+void lib_partition3_by_pivot_val(int pivot, int vals[], const int vals_size, int *lt_size, int *eq_size, int *gt_size);
+
+/*
+ * Hypercube partners hold three way partitioned arrays [lt | eq | gt], counts are {lt, eq, gt} of this side
+ * and of the partner, upper is non zero on the partner in the upper half of the dimension.
+ * Keys equal to the pivot may go to either partner, so the equal band is split to leave both with
+ * loads as even as possible. Sets the contiguous part of this array to keep and the part to send.
+ */
+void lib_split_equal(const int mine[3], const int theirs[3], const int upper,
+        int *keep_from, int *keep_size, int *send_from, int *send_size);
+
+/*
+ * Classify vals into 2^levels buckets in one pass. Tree holds the 2^levels - 1 sorted splitters as an implicit
+ * search tree in breadth first order, the children of node i at 2i+1 and 2i+2, as lib_select_pivots_from_medians
+ * lays them out. Bucket b gets the keys above its left splitter and at most its right one.
+ * Out receives vals grouped by bucket in bucket order, counts the size of each bucket.
+ */
+void lib_classify(const int tree[], const int levels, const int vals[], const int vals_size, int counts[], int out[]);
+
+/*
+ * Splitmix64 finalizer, every bit of the result depends on every bit of z. The one mixer behind the seeds,
+ * the generated inputs and the hashes, so hashes compared across modules can't drift apart.
+ */
+uint64_t lib_mix64(uint64_t z);
+
+/*
+ * Seed the local generator used for random pivots. Same seed gives the same pivots.
+ */
+void lib_rand_seed(const uint64_t seed);
+
+/*
+ * Next 64 bit value of the local xorshift64* generator, a few cycles instead of libc rand().
+ */
+uint64_t lib_rand_next(void);
+
+/*
+ * Uniform value in [0, bound) from the local generator.
+ */
+int lib_rand_range(const int bound);
+
 /*
  * Select the kth largest element from the range of values in the array.
- * Starts at k = 1..N.
+ * Starts at k = 1..N. Returns index of kth relative to left, which is kth-1.
+ * Large ranges use Floyd-Rivest, small ones introselect.
  */
 int lib_select_kth(int kth, int *left, int *right);
 
+/*
+ * Floyd-Rivest selection, picks two pivots from a recursive sample that bracket kth
+ * so nearly all elements are compared once. Same contract as lib_select_kth.
+ */
+int lib_select_floyd_rivest(int kth, int *left, int *right);
+
+/*
+ * Introselect, random pivots with a median of medians fallback that bounds the worst case.
+ * Same contract as lib_select_kth.
+ */
+int lib_introselect(int kth, int *left, int *right);
+
+/*
+ * Sort five values in place with an optimal nine comparator network, median ends up at vals[2].
+ */
+void lib_sort5(int vals[]);
+
+/*
+ * Sort up to NETWORK_MAX values in place with a sorting network, Batcher's merge exchange for size.
+ * Every comparator is a branchless min and max, the sequence doesn't depend on the values.
+ */
+void lib_sort_small(int vals[], const int size);
+
+/*
+ * Introsort of ints in place, the replacement for qsort with lib_compare. Median of three pivots and three way
+ * partitions with the partition kernels, a heapsort fallback bounds the depth and lib_sort_small finishes
+ * every part of NETWORK_MAX or fewer. No comparator calls.
+ */
+void lib_sort(int vals[], const int size);
+
+/*
+ * Number of natural runs in vals, maximal stretches that don't decrease. 1 means sorted, 0 empty.
+ */
+int lib_count_runs(const int vals[], const int size);
+
+/*
+ * Sort of ints in place that pays for the disorder it finds. One pass counts the natural runs, sorted input
+ * ends there. Up to one run per ADAPT_MIN_RUN values are merged pairwise, O(n log runs), so a few appended
+ * runs or a mostly sorted array cost a few linear passes. More runs than that go to lib_sort.
+ */
+void lib_adaptive_sort(int vals[], const int size);
+
 /* This function groups values into blocks of five and then selects a median.
  * All such medians are collected at the front and the median of this group is selected as the true median.
  */
@@ -109,4 +235,27 @@ int lib_select_medians(int *vals, const int left, const int right);
  */
 void lib_select_pivots_from_medians(const int dimension, int *pivots, const int pivots_size, int *vals, const int vals_size);
 
+/*
+ * Start an empty quantile sketch.
+ */
+void lib_sketch_init(quantile_sketch_t *sketch);
+
+/*
+ * Add vals to the sketch in one streaming pass. A level that fills is sorted and every other item moves up
+ * a level at twice the weight, alternating which of each pair survives so the errors mostly cancel.
+ * Memory stays at SKETCH_LEVELS * SKETCH_K ints whatever the count, the rank error of a query is at most
+ * 2 * levels / SKETCH_K of the count and in practice far below that.
+ */
+void lib_sketch_update(quantile_sketch_t *sketch, const int vals[], const int vals_size);
+
+/*
+ * Fold src into dst, as if dst had also seen every value of src.
+ */
+void lib_sketch_merge(quantile_sketch_t *dst, const quantile_sketch_t *src);
+
+/*
+ * Approximate value at each quantile of qs, 0 to 1, into out. An empty sketch answers 0.
+ */
+void lib_sketch_quantiles(const quantile_sketch_t *sketch, const double qs[], const int count, int out[]);
+
 #endif /* _SHARED_H_ */
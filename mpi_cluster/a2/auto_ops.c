@@ -0,0 +1,244 @@
+/**
+ * Strategy selection for the sort driver. Which parallel sort is fastest depends on the input and the machine,
+ * so a few cheap measurements of both decide it instead of the user picking an executable.
+ *
+ * The measurements cost one pass over local and a handful of small reductions: sizes, the key range,
+ * a HyperLogLog estimate of distinct keys over a sample, how many neighbouring keys are out of order and how
+ * many ranks share a node. The rules in lib_auto_choose follow what each sort is good at, see dist_ops.c.
+ *
+ * The hypercube based sorts need a power of two ranks. Other counts fold the ranks past the largest power of two
+ * onto the cube, the classic way to run a hypercube algorithm on any machine.
+ *
+ * Appended logs and similar feeds arrive sorted or nearly so. A sorted layout is caught in one pass and
+ * only evened out, and every local sort merges natural runs when they are few. The bucket exchange keeps
+ * each sender's order, so nearly sorted input reaches its rank as a few runs.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "dist_ops.h"
+#include "typed_ops.h"
+#include "agg_ops.h"
+#include "auto_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Tag of the boundary keys. */
+#define AUTO_TAG            22
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+/* Command line names of each strategy, same order as auto_algo_t. */
+static const char *auto_names[] = {"local", "count", "bitonic", "sample", "hyper"};
+
+/****************** Static Functions **********************/
+/*
+ * Move every rank's keys to rank 0 of comm, which keeps them all. The others end empty.
+ */
+static void auto_gather(MPI_Comm comm, int *local[], int *local_size) {
+    int id = 0, world = 0, total = 0, *counts = NULL, *displs = NULL, *all = NULL;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    if (id == 0) {
+        counts = (int *)malloc(2 * world * sizeof(int));
+        if (counts == NULL)
+            lib_error("AUTO: Can't allocate counts on heap.");
+        displs = counts + world;
+    }
+    MPI_Gather(local_size, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (id == 0) {
+        for (int r = 0; r < world; ++r) {
+            displs[r] = total;
+            total += counts[r];
+        }
+    }
+    if ((all = (int *)malloc((total > 0 ? total : 1) * sizeof(int))) == NULL)
+        lib_error("AUTO: Can't allocate gather on heap.");
+    MPI_Gatherv(*local, *local_size, MPI_INT, all, counts, displs, MPI_INT, 0, comm);
+
+    free(*local);
+    *local = all;
+    *local_size = total;
+
+    free(counts);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Measure local over comm for lib_auto_choose: sizes and key range in two reductions, a HyperLogLog of up to
+ * AUTO_SAMPLE evenly spaced keys per rank, the descents of one pass over local plus each rank boundary, and
+ * the ranks per node from a shared memory split. O(local_size), local is untouched. Collective over comm.
+ */
+void lib_auto_stats(MPI_Comm comm, const int local[], const int local_size, auto_stats_t *stats) {
+    MPI_Comm node;
+    hll_t hll;
+    int id = 0, world = 0, node_size = 0, step = 1, mine[2] = {0, 0}, before[2] = {0, 0};
+    long sums[3] = {local_size, 0, 0}; /* Keys, descents and keys sampled. */
+    long maxes[5] = {local_size, -(long)local_size, LONG_MIN, LONG_MIN, 0}; /* Size, negated size, negated min, max, node. */
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+    MPI_Comm_size(node, &node_size);
+    MPI_Comm_free(&node);
+    maxes[4] = node_size;
+
+    /* One pass for the range and the descents. */
+    for (int i = 0; i < local_size; ++i) {
+        if (-(long)local[i] > maxes[2])
+            maxes[2] = -(long)local[i];
+        if (local[i] > maxes[3])
+            maxes[3] = local[i];
+        if (i > 0 && local[i] < local[i-1])
+            ++sums[1];
+    }
+
+    /* The previous rank's last key against my first, an empty rank leaves its boundary out. */
+    mine[0] = local_size > 0;
+    mine[1] = local_size > 0 ? local[local_size-1] : 0;
+    MPI_Sendrecv(mine, 2, MPI_INT, id < world-1 ? id+1 : MPI_PROC_NULL, AUTO_TAG,
+            before, 2, MPI_INT, id > 0 ? id-1 : MPI_PROC_NULL, AUTO_TAG, comm, MPI_STATUS_IGNORE);
+    if (before[0] && local_size > 0 && local[0] < before[1])
+        ++sums[1];
+
+    /* Evenly spaced keys into the distinct counter. */
+    lib_hll_init(&hll);
+    step = local_size > AUTO_SAMPLE ? local_size / AUTO_SAMPLE : 1;
+    for (int i = 0; i < local_size && sums[2] < AUTO_SAMPLE; i += step, ++sums[2])
+        lib_hll_add(&hll, local[i]);
+
+    MPI_Allreduce(MPI_IN_PLACE, sums, 3, MPI_LONG, MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, maxes, 5, MPI_LONG, MPI_MAX, comm);
+    lib_hll_allreduce(comm, &hll);
+
+    stats->total = sums[0];
+    stats->world = world;
+    stats->per_node = (int)maxes[4];
+    stats->even = maxes[0] == -maxes[1];
+    stats->range = sums[0] > 0 ? maxes[3] + maxes[2] + 1 : 0;
+    stats->sampled = sums[2];
+    stats->distinct = lib_hll_estimate(&hll);
+    stats->disorder = sums[0] > 1 ? (double)sums[1] / (sums[0] - 1) : 0.0;
+}
+
+/*
+ * Strategy for stats. One rank or a small total sorts locally, a small key range counts. Otherwise on a power
+ * of two ranks: bitonic for few even keys per rank, the hypercube when duplicates are heavy, one all to all
+ * (sample sort) across nodes or for nearly sorted input and the hypercube within a node. Other rank counts
+ * fold onto the largest power of two below them and never pick bitonic.
+ */
+auto_algo_t lib_auto_choose(const auto_stats_t *stats) {
+    const int cube = stats->world > 0 && (stats->world & (stats->world - 1)) == 0;
+
+    if (stats->world == 1 || stats->total <= AUTO_LOCAL_MAX)
+        return AUTO_LOCAL;
+    if (lib_count_fits(stats->range, stats->total))
+        return AUTO_COUNT;
+    if (cube && stats->even && stats->total / stats->world <= AUTO_BITONIC_MAX)
+        return AUTO_BITONIC;
+
+    /* Splitters from one sample pile a heavy key onto one rank, the hypercube picks and splits it per round. */
+    if (stats->distinct * AUTO_FEW_DISTINCT <= stats->sampled)
+        return AUTO_HYPER;
+
+    /* One exchange instead of d when the network is the cost or when most keys already sit on their rank. */
+    if (stats->per_node < stats->world || stats->disorder < AUTO_NEARLY_SORTED)
+        return AUTO_SAMPLE_SORT;
+
+    return AUTO_HYPER;
+}
+
+/*
+ * Strategy for a command line name: local, count, bitonic, sample or hyper. Returns -1 if unknown.
+ */
+int lib_auto_parse(const char *name) {
+    for (int a = 0; a < AUTO_ALGOS; ++a)
+        if (strcmp(name, auto_names[a]) == 0)
+            return a;
+
+    return -1;
+}
+
+/*
+ * Command line name of a strategy.
+ */
+const char *lib_auto_name(const auto_algo_t algo) {
+    return algo >= 0 && algo < AUTO_ALGOS ? auto_names[algo] : "unknown";
+}
+
+/*
+ * Sort over comm with algo, any number of ranks. Input already sorted over comm only has its shares evened
+ * out, except for local which always gathers. Bitonic, sample and hyper run on the largest power of two
+ * ranks, the others first hand their keys to rank id - 2^d and end empty. Count falls back to hyper when the
+ * range is too wide, bitonic needs the same count on every rank of a power of two. Afterwards local is sorted
+ * and the ranks are in order, sizes may differ. Local is replaced. Collective over comm.
+ */
+void lib_auto_sort(MPI_Comm comm, const auto_algo_t algo, int *local[], int *local_size) {
+    MPI_Comm cube_comm;
+    auto_algo_t run = algo;
+    int id = 0, world = 0, cube = 1, dimension = 0, sizes[2] = {*local_size, -*local_size}, *tree = NULL;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    while (cube * 2 <= world) {
+        cube *= 2;
+        ++dimension;
+    }
+
+    if (run == AUTO_LOCAL) {
+        auto_gather(comm, local, local_size);
+        lib_adaptive_sort(*local, *local_size);
+        return;
+    }
+    if (lib_dist_sorted(comm, *local, *local_size)) {
+        lib_equalize(comm, local, local_size);
+        return;
+    }
+    if (run == AUTO_COUNT && lib_count_sort(comm, local, local_size))
+        return;
+    if (run == AUTO_COUNT || (run == AUTO_SAMPLE_SORT && dimension > CLASSIFY_MAX_LEVELS))
+        run = AUTO_HYPER;
+    if (run == AUTO_BITONIC) {
+        MPI_Allreduce(MPI_IN_PLACE, sizes, 2, MPI_INT, MPI_MAX, comm);
+        if (cube != world || sizes[0] != -sizes[1])
+            lib_error("AUTO: Bitonic needs the same count on every rank of a power of two.");
+    }
+
+    /* Everything on the cube, the rest sit out empty. */
+    *local = lib_dist_fold(comm, cube, MPI_INT, sizeof(int), *local, local_size);
+    MPI_Comm_split(comm, id < cube ? 0 : MPI_UNDEFINED, id, &cube_comm);
+    if (id >= cube)
+        return;
+
+    if (dimension == 0) {
+        lib_adaptive_sort(*local, *local_size);
+    } else if (run == AUTO_BITONIC) {
+        lib_bitonic_sort(cube_comm, *local, *local_size);
+    } else if (run == AUTO_SAMPLE_SORT) {
+        if ((tree = (int *)malloc(((1 << dimension) - 1) * sizeof(int))) == NULL)
+            lib_error("AUTO: Can't allocate splitters on heap.");
+        lib_sketch_splitters(cube_comm, dimension, *local, *local_size, tree);
+        lib_bucket_exchange(cube_comm, tree, dimension, local, local_size);
+        lib_adaptive_sort(*local, *local_size);
+        free(tree);
+    } else {
+        lib_hyper_quicksort_i32(cube_comm, dimension, local, local_size);
+        lib_adaptive_sort(*local, *local_size);
+    }
+
+    MPI_Comm_free(&cube_comm);
+}
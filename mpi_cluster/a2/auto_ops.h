@@ -0,0 +1,80 @@
+#ifndef _AUTO_OPS_H_
+#define _AUTO_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+
+/* Project Headers */
+#include "mpi.h"
+
+/******************* Constants/Macros *********************/
+/* Most keys per rank hashed for the distinct estimate. */
+#define AUTO_SAMPLE         4096
+/* Totals up to this are sorted on one rank, the rounds of any parallel sort cost more. */
+#define AUTO_LOCAL_MAX      (1 << 15)
+/* Bitonic for at most this many keys per rank, its fixed schedule beats pivots when latency dominates. */
+#define AUTO_BITONIC_MAX    4096
+/* Heavy duplicates when the sample holds this many keys per distinct one, one up front sample splits them badly. */
+#define AUTO_FEW_DISTINCT   16
+/* Nearly sorted below this fraction of neighbouring pairs out of order. */
+#define AUTO_NEARLY_SORTED  0.01
+
+/******************* Type Declarations ********************/
+/* Strategies the driver picks from, names for the command line are in lib_auto_parse. */
+typedef enum auto_algo_e {
+    AUTO_LOCAL, /* Everything to rank 0 and one local sort. */
+    AUTO_COUNT, /* Global histogram, lib_count_sort. */
+    AUTO_BITONIC, /* Bitonic merge over the hypercube, lib_bitonic_sort. */
+    AUTO_SAMPLE_SORT, /* Sketch splitters and one all to all, lib_bucket_exchange. */
+    AUTO_HYPER, /* Hypercube quicksort, a pivot per round, lib_hyper_quicksort_i32. */
+    AUTO_ALGOS /* Number of strategies, not a strategy. */
+} auto_algo_t;
+
+/* What the choice is made on, the same on every rank. */
+typedef struct auto_stats_s {
+    long total; /* Keys over all ranks. */
+    int world; /* Ranks in the communicator. */
+    int per_node; /* Most ranks sharing one node. */
+    int even; /* 1 when every rank holds the same number of keys. */
+    long range; /* Max - min + 1 over all keys, 0 when there are none. */
+    long sampled; /* Keys that went into the distinct estimate. */
+    double distinct; /* Estimated distinct keys among the sampled ones. */
+    double disorder; /* Fraction of neighbouring pairs in rank order that are out of order. */
+} auto_stats_t;
+
+/********************** Prototypes ************************/
+/*
+ * Measure local over comm for lib_auto_choose: sizes and key range in two reductions, a HyperLogLog of up to
+ * AUTO_SAMPLE evenly spaced keys per rank, the descents of one pass over local plus each rank boundary, and
+ * the ranks per node from a shared memory split. O(local_size), local is untouched. Collective over comm.
+ */
+void lib_auto_stats(MPI_Comm comm, const int local[], const int local_size, auto_stats_t *stats);
+
+/*
+ * Strategy for stats. One rank or a small total sorts locally, a small key range counts. Otherwise on a power
+ * of two ranks: bitonic for few even keys per rank, the hypercube when duplicates are heavy, one all to all
+ * (sample sort) across nodes or for nearly sorted input and the hypercube within a node. Other rank counts
+ * fold onto the largest power of two below them and never pick bitonic.
+ */
+auto_algo_t lib_auto_choose(const auto_stats_t *stats);
+
+/*
+ * Strategy for a command line name: local, count, bitonic, sample or hyper. Returns -1 if unknown.
+ */
+int lib_auto_parse(const char *name);
+
+/*
+ * Command line name of a strategy.
+ */
+const char *lib_auto_name(const auto_algo_t algo);
+
+/*
+ * Sort over comm with algo, any number of ranks. Input already sorted over comm only has its shares evened
+ * out, except for local which always gathers. Bitonic, sample and hyper run on the largest power of two
+ * ranks, the others first hand their keys to rank id - 2^d and end empty. Count falls back to hyper when the
+ * range is too wide, bitonic needs the same count on every rank of a power of two. Afterwards local is sorted
+ * and the ranks are in order, sizes may differ. Local is replaced. Collective over comm.
+ */
+void lib_auto_sort(MPI_Comm comm, const auto_algo_t algo, int *local[], int *local_size);
+
+#endif /* _AUTO_OPS_H_ */
@@ -0,0 +1,204 @@
+/**
+ * Light integer compression for data on the wire. The inputs here are dense 32 bit ints from a small range
+ * (MAX_VAL fits in 14 bits) and the final shares are sorted, so most of every int sent is zero bits.
+ *
+ * A block is a small header followed by the values bit packed at one fixed width. Unsorted blocks store the
+ * distance from the block minimum (frame of reference), sorted blocks the gap to the previous value, which
+ * for a dense sorted share is a few bits. Whichever is narrowest is chosen per block, with raw ints
+ * as the fallback when neither would pay off. Decoding writes straight into the caller's array.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "array_ops.h"
+#include "codec_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Header layout: kind, bit width, two unused, count, base. */
+#define CODEC_KIND_AT       0
+#define CODEC_BITS_AT       1
+#define CODEC_COUNT_AT      4
+#define CODEC_BASE_AT       8
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * Bits needed to hold v, 0 for 0.
+ */
+static int codec_width(uint32_t v) {
+    int bits = 0;
+
+    while (v != 0) {
+        ++bits;
+        v >>= 1;
+    }
+
+    return bits;
+}
+
+/*
+ * Pack each value minus base, or minus its predecessor when delta, at bits bits each. Returns bytes written.
+ */
+static long codec_pack(const int vals[], const int count, const uint32_t base, const int bits,
+        const int delta, unsigned char out[]) {
+    uint64_t acc = 0;
+    uint32_t prev = base;
+    long n = 0;
+    int filled = 0;
+
+    for (int i = 0; i < count; ++i) {
+        acc |= (uint64_t)((uint32_t)vals[i] - prev) << filled;
+        filled += bits;
+        if (delta)
+            prev = (uint32_t)vals[i];
+
+        /* At most 7 bits stay behind, so a width up to 31 never overflows the accumulator. */
+        while (filled >= 8) {
+            out[n++] = (unsigned char)acc;
+            acc >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0)
+        out[n++] = (unsigned char)acc;
+
+    return n;
+}
+
+/*
+ * Reverse of codec_pack.
+ */
+static void codec_unpack(const unsigned char in[], const int count, const uint32_t base, const int bits,
+        const int delta, int out[]) {
+    const uint32_t mask = bits == 0 ? 0 : 0xFFFFFFFFu >> (32 - bits);
+    uint64_t acc = 0;
+    uint32_t prev = base;
+    long pos = 0;
+    int filled = 0;
+
+    for (int i = 0; i < count; ++i) {
+        while (filled < bits) {
+            acc |= (uint64_t)in[pos++] << filled;
+            filled += 8;
+        }
+        prev = (delta ? prev : base) + ((uint32_t)acc & mask);
+        out[i] = (int)prev;
+        acc >>= bits;
+        filled -= bits;
+    }
+}
+
+/*
+ * Write a 32 bit field of the header.
+ */
+static void codec_put(unsigned char out[], const int at, const uint32_t v) {
+    memcpy(out + at, &v, sizeof(v));
+}
+
+/*
+ * Read a 32 bit field of the header.
+ */
+static uint32_t codec_get(const unsigned char in[], const int at) {
+    uint32_t v = 0;
+
+    memcpy(&v, in + at, sizeof(v));
+    return v;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Most bytes lib_codec_encode can write for count ints.
+ */
+long lib_codec_bound(const int count) {
+    return CODEC_HEADER + (long)count * sizeof(int);
+}
+
+/*
+ * Encode count ints into out, which must hold lib_codec_bound(count) bytes. Picks whichever of raw, frame
+ * of reference or delta packs into the fewest bits, delta only when vals is sorted. Returns bytes written.
+ */
+long lib_codec_encode(const int vals[], const int count, unsigned char out[]) {
+    int min = count > 0 ? vals[0] : 0, max = min, sorted = 1, bits = 32, delta_bits = 0;
+    uint32_t max_gap = 0, base = 0;
+    codec_kind_t kind = CODEC_RAW;
+
+    /* One pass for the range and, while still sorted, the widest gap. */
+    for (int i = 1; i < count; ++i) {
+        min = vals[i] < min ? vals[i] : min;
+        max = vals[i] > max ? vals[i] : max;
+        if (sorted && vals[i] < vals[i-1])
+            sorted = 0;
+        else if (sorted && (uint32_t)vals[i] - (uint32_t)vals[i-1] > max_gap)
+            max_gap = (uint32_t)vals[i] - (uint32_t)vals[i-1];
+    }
+
+    /* Narrowest encoding, a full 32 bit width is no better than raw. */
+    if (codec_width((uint32_t)max - (uint32_t)min) < bits) {
+        kind = CODEC_FOR;
+        bits = codec_width((uint32_t)max - (uint32_t)min);
+        base = (uint32_t)min;
+    }
+    delta_bits = codec_width(max_gap);
+    if (sorted && count > 0 && delta_bits < bits) {
+        kind = CODEC_DELTA;
+        bits = delta_bits;
+        base = (uint32_t)vals[0];
+    }
+
+    memset(out, 0, CODEC_HEADER);
+    out[CODEC_KIND_AT] = (unsigned char)kind;
+    out[CODEC_BITS_AT] = (unsigned char)bits;
+    codec_put(out, CODEC_COUNT_AT, (uint32_t)count);
+    codec_put(out, CODEC_BASE_AT, base);
+
+    if (kind == CODEC_RAW) {
+        memcpy(out + CODEC_HEADER, vals, (long)count * sizeof(int));
+        return lib_codec_bound(count);
+    }
+
+    return CODEC_HEADER + codec_pack(vals, count, base, bits, kind == CODEC_DELTA, out + CODEC_HEADER);
+}
+
+/*
+ * Number of ints in an encoded block, read from its header.
+ */
+int lib_codec_count(const unsigned char in[]) {
+    return (int)codec_get(in, CODEC_COUNT_AT);
+}
+
+/*
+ * Kind the block was encoded with, read from its header.
+ */
+codec_kind_t lib_codec_kind(const unsigned char in[]) {
+    return (codec_kind_t)in[CODEC_KIND_AT];
+}
+
+/*
+ * Decode a block straight into out, which must hold lib_codec_count(in) ints. Returns the count.
+ */
+int lib_codec_decode(const unsigned char in[], int out[]) {
+    const int count = lib_codec_count(in), bits = in[CODEC_BITS_AT];
+    const codec_kind_t kind = lib_codec_kind(in);
+
+    if (kind == CODEC_RAW)
+        memcpy(out, in + CODEC_HEADER, (long)count * sizeof(int));
+    else if (kind == CODEC_FOR || kind == CODEC_DELTA)
+        codec_unpack(in + CODEC_HEADER, count, codec_get(in, CODEC_BASE_AT), bits, kind == CODEC_DELTA, out);
+    else
+        lib_error("CODEC: Unknown block kind.");
+
+    return count;
+}
@@ -0,0 +1,49 @@
+#ifndef _CODEC_OPS_H_
+#define _CODEC_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+
+/******************* Constants/Macros *********************/
+/* Bytes of the header in front of every encoded block. */
+#define CODEC_HEADER        12
+
+/******************* Type Declarations ********************/
+/* How a block was encoded, chosen per block by lib_codec_encode. */
+typedef enum codec_kind_e {
+    CODEC_RAW, /* Plain 32 bit ints, nothing to gain. */
+    CODEC_FOR, /* Frame of reference, value minus the block minimum, bit packed. */
+    CODEC_DELTA /* Sorted blocks, difference to the previous value, bit packed. */
+} codec_kind_t;
+
+/********************** Prototypes ************************/
+/*
+ * Most bytes lib_codec_encode can write for count ints.
+ */
+long lib_codec_bound(const int count);
+
+/*
+ * Encode count ints into out, which must hold lib_codec_bound(count) bytes. Picks whichever of raw, frame
+ * of reference or delta packs into the fewest bits, delta only when vals is sorted. Returns bytes written.
+ */
+long lib_codec_encode(const int vals[], const int count, unsigned char out[]);
+
+/*
+ * Number of ints in an encoded block, read from its header.
+ */
+int lib_codec_count(const unsigned char in[]);
+
+/*
+ * Kind the block was encoded with, read from its header.
+ */
+codec_kind_t lib_codec_kind(const unsigned char in[]);
+
+/*
+ * Decode a block straight into out, which must hold lib_codec_count(in) ints. Returns the count.
+ */
+int lib_codec_decode(const unsigned char in[], int out[]);
+
+#endif /* _CODEC_OPS_H_ */
@@ -0,0 +1,1017 @@
+/**
+ * Distributed sorts that don't go through the hypercube. Each is collective over a communicator and
+ * leaves every rank with a sorted, contiguous part of the global order.
+ *
+ * The counting sort is for keys known to sit in a small range, like the MAX_VAL inputs of this assignment.
+ * A comparison sort then spends log p rounds finding pivots for values a histogram already places exactly.
+ *
+ * The bucket exchange is the one pass version of the hypercube. All splitters are chosen up front, every value
+ * is classified once against all of them and a single all to all replaces the d partition and exchange rounds.
+ *
+ * The bitonic sort trades the data dependent pivots for a fixed schedule. Every step swaps equal sized
+ * arrays with a partner known in advance, so the requests are persistent and set up once.
+ *
+ * The top k skips the sort altogether when only the k smallest or largest values are wanted. Each rank
+ * selects its own k in linear time, one reduction finds a threshold no answer can lie beyond and only the
+ * values inside it travel to root.
+ *
+ * The distributed select finds exact order statistics without moving any values. All ranks agree on a pivot,
+ * partition around it in place and sum the counts, which says on which side every wanted rank lies.
+ * A batch of ranks shares the partitions, each side only carries on with the ranks that fell into it.
+ *
+ * Quantile sketches (see lib_sketch_update) reduce with a user MPI_Op, one reduction gives every rank a summary
+ * of all values. Splitters read off it cost O(sketch) instead of a pass over local.
+ *
+ * The equalize pass evens out any globally sorted layout. Ranks only trade the slices where their current
+ * range and the even shares overlap, for most sorts those are a neighbour's boundary and nothing else moves.
+ * It is lib_dist_place with even targets, which takes any targets and element type. Hypercube sorts on other
+ * rank counts first lib_dist_fold the ranks past the largest power of two onto the cube.
+ *
+ * Records with a leading 64 bit key (kv64_t, join and aggregate rows) share one splitter and exchange path,
+ * and the binary read and write helpers give every rank its slice of a file without going through root.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "typed_ops.h"
+#include "gen_ops.h"
+#include "prof_ops.h"
+#include "dist_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * Write the keys counted in hist, starting at key lo, into vals in increasing order.
+ */
+static void dist_unpack(const int hist[], const long range, const long lo, int vals[]) {
+    long n = 0;
+
+    for (long k = 0; k < range; ++k)
+        for (int c = 0; c < hist[k]; ++c)
+            vals[n++] = (int)(lo + k);
+}
+
+/*
+ * Partition vals so its k smallest, or k largest, are together and return where they start.
+ */
+static int *dist_extreme(int vals[], const int size, const int k, const int largest) {
+    if (k > 0 && k < size)
+        lib_select_kth(largest ? size-k+1 : k, vals, vals+size-1);
+
+    return largest ? vals+size-k : vals;
+}
+
+/*
+ * Pivot every rank agrees on, the median of the ranks' medians weighted by their sizes. At least a quarter
+ * of the values lie on either side of it. Pairs is scratch for two ints per rank. Collective over comm.
+ */
+static int dist_weighted_median(MPI_Comm comm, int vals[], const int size, int pairs[]) {
+    int world = 0, mine[2] = {0, size};
+    long total = 0, acc = 0;
+
+    MPI_Comm_size(comm, &world);
+    if (size > 0)
+        mine[0] = vals[lib_select_kth((size+1)/2, vals, vals+size-1)];
+    MPI_Allgather(mine, 2, MPI_INT, pairs, 2, MPI_INT, comm);
+
+    /* Pairs are (median, size), lib_compare only looks at the first int. */
+    qsort(pairs, world, 2 * sizeof(int), lib_compare);
+    for (int r = 0; r < world; ++r)
+        total += pairs[2*r+1];
+    for (int r = 0; r < world; ++r) {
+        acc += pairs[2*r+1];
+        if (pairs[2*r+1] > 0 && 2 * acc >= total)
+            return pairs[2*r];
+    }
+
+    return 0;
+}
+
+/*
+ * Select the sorted kths, global ranks counting from 1, among the values of vals on all ranks.
+ * Below is how many values of all ranks precede these, answers go to out at slots. Collective over comm.
+ */
+static void dist_multiselect(MPI_Comm comm, int vals[], const int size, const long below, const long kths[],
+        const int slots[], const int count, const int depth, int out[], int pairs[]) {
+    int pivot = 0, lt = 0, eq = 0, gt = 0, left = 0, right = 0;
+    long sums[2] = {0, 0};
+
+    if (count == 0)
+        return;
+
+    lib_prof_round(depth);
+    pivot = dist_weighted_median(comm, vals, size, pairs);
+    lib_prof_lap(PROF_PIVOT_SELECT);
+
+    lib_partition3_by_pivot_val(pivot, vals, size, &lt, &eq, &gt);
+    lib_prof_lap(PROF_PARTITION);
+
+    sums[0] = lt;
+    sums[1] = eq;
+    MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPI_LONG, MPI_SUM, comm);
+    lib_prof_lap(PROF_EXCHANGE);
+
+    /* Ranks below the pivot's band go left, inside it are answered, above it go right. */
+    while (left < count && kths[left] - below <= sums[0])
+        ++left;
+    for (right = left; right < count && kths[right] - below <= sums[0] + sums[1]; ++right)
+        out[slots[right]] = pivot;
+
+    dist_multiselect(comm, vals, lt, below, kths, slots, left, depth+1, out, pairs);
+    dist_multiselect(comm, vals+lt+eq, gt, below + sums[0] + sums[1], kths+right, slots+right, count-right,
+            depth+1, out, pairs);
+}
+
+/*
+ * MPI_Op over lib_count_sort's bounds: the negated min and the max take the larger, the value counts add up.
+ */
+static void dist_bounds_merge(void *in, void *inout, int *len, MPI_Datatype *type) {
+    const long *src = (const long *)in;
+    long *dst = (long *)inout;
+
+    (void)type;
+    for (int i = 0; i < 3 * *len; i += 3) {
+        dst[i] = src[i] > dst[i] ? src[i] : dst[i];
+        dst[i+1] = src[i+1] > dst[i+1] ? src[i+1] : dst[i+1];
+        dst[i+2] += src[i+2];
+    }
+}
+
+/*
+ * MPI_Op folding each sketch of in into the matching one of inout.
+ */
+static void dist_sketch_merge(void *in, void *inout, int *len, MPI_Datatype *type) {
+    const quantile_sketch_t *src = (const quantile_sketch_t *)in;
+    quantile_sketch_t *dst = (quantile_sketch_t *)inout;
+
+    (void)type;
+    for (int i = 0; i < *len; ++i)
+        lib_sketch_merge(&dst[i], &src[i]);
+}
+
+/*
+ * Increasing comparator of 64 bit keys, for qsort.
+ */
+static int dist_compare_key(const void *a, const void *b) {
+    const int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * Key of element i of records laid out elem_size apart, the key leads every record.
+ */
+static int64_t dist_key_at(const void *vals, const size_t elem_size, const long i) {
+    int64_t key = 0;
+
+    memcpy(&key, (const char *)vals + i * elem_size, sizeof(key));
+    return key;
+}
+
+/*
+ * Merge based compare split of two sorted arrays of size each. Out gets the lower half of their union
+ * when keep_low is set, else the upper half, sorted either way.
+ */
+static void dist_split(const int mine[], const int theirs[], const int size, const int keep_low, int out[]) {
+    int a = 0, b = 0, i = 0;
+
+    if (keep_low) {
+        for (i = 0; i < size; ++i)
+            out[i] = mine[a] <= theirs[b] ? mine[a++] : theirs[b++];
+    } else {
+        a = b = size-1;
+        for (i = size-1; i >= 0; --i)
+            out[i] = mine[a] > theirs[b] ? mine[a--] : theirs[b--];
+    }
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * True when range keys spread over total values suit lib_count_sort: the range is within DIST_COUNT_RANGE and
+ * no wider than the values, so the histograms and their collectives cost no more than moving the values.
+ */
+int lib_count_fits(const long range, const long total) {
+    return range > 0 && range <= DIST_COUNT_RANGE && range <= total;
+}
+
+/*
+ * Global counting sort over comm for keys in a small range, no pivots and no rounds.
+ * Histograms are summed with MPI_Allreduce and prefixed over the ranks with MPI_Exscan, that gives every key's
+ * exact output position so one MPI_Alltoallv moves each value straight to its final rank.
+ * Afterwards rank r holds the r-th even share of all values (see lib_gen_share) in sorted order, local is replaced.
+ * Returns 1 when sorted, 0 with local untouched unless lib_count_fits the global range and count. Collective
+ * over comm.
+ */
+int lib_count_sort(MPI_Comm comm, int *local[], int *local_size) {
+    int *hist = NULL, *below = NULL, *total = NULL, *recv = NULL;
+    int *send_counts = NULL, *send_displs = NULL, *recv_counts = NULL, *recv_displs = NULL;
+    int id = 0, world = 0, dest = 0;
+    long bounds[3] = {LONG_MIN, LONG_MIN, *local_size}; /* Negated min, max and count of values. */
+    MPI_Datatype type;
+    MPI_Op op;
+    long lo = 0, range = 0, n = 0, start = 0, pos = 0, left = 0, take = 0, offset = 0, count = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    /* Global min, max and count in one reduction, empty ranks add nothing. */
+    for (int i = 0; i < *local_size; ++i) {
+        if (-(long)(*local)[i] > bounds[0])
+            bounds[0] = -(long)(*local)[i];
+        if ((*local)[i] > bounds[1])
+            bounds[1] = (*local)[i];
+    }
+    MPI_Type_contiguous(3, MPI_LONG, &type);
+    MPI_Type_commit(&type);
+    MPI_Op_create(dist_bounds_merge, 1, &op);
+    MPI_Allreduce(MPI_IN_PLACE, bounds, 1, type, op, comm);
+    MPI_Op_free(&op);
+    MPI_Type_free(&type);
+
+    /* Nothing on any rank is already sorted, a wide or sparse range is left for the general path. */
+    if (bounds[1] == LONG_MIN)
+        return 1;
+    lo = -bounds[0];
+    range = bounds[1] - lo + 1;
+    if (!lib_count_fits(range, bounds[2]))
+        return 0;
+
+    hist = (int *)calloc(range, sizeof(int));
+    below = (int *)calloc(range, sizeof(int));
+    total = (int *)calloc(range, sizeof(int));
+    send_counts = (int *)calloc(4 * world, sizeof(int));
+    if (hist == NULL || below == NULL || total == NULL || send_counts == NULL)
+        lib_error("COUNT: Can't allocate histograms on heap.");
+    send_displs = send_counts + world;
+    recv_counts = send_counts + 2 * world;
+    recv_displs = send_counts + 3 * world;
+
+    /* Count of each key here, on all lower ranks and everywhere. Exscan leaves rank 0's undefined. */
+    for (int i = 0; i < *local_size; ++i)
+        ++hist[(*local)[i] - lo];
+    MPI_Exscan(hist, below, range, MPI_INT, MPI_SUM, comm);
+    if (id == 0)
+        memset(below, 0, range * sizeof(int));
+    MPI_Allreduce(hist, total, range, MPI_INT, MPI_SUM, comm);
+    n = bounds[2];
+
+    /*
+     * Copies of key k held here sit at start + below[k] of the output, where start counts all smaller keys.
+     * Charge them to the ranks that own those positions, a run of one key may straddle a boundary.
+     */
+    lib_gen_share(n, dest, world, &offset, &count);
+    for (long k = 0; k < range; ++k) {
+        pos = start + below[k];
+        for (left = hist[k]; left > 0; left -= take) {
+            while (pos >= offset + count)
+                lib_gen_share(n, ++dest, world, &offset, &count);
+            take = left < offset + count - pos ? left : offset + count - pos;
+            send_counts[dest] += take;
+            pos += take;
+        }
+        start += total[k];
+    }
+
+    /* Keys ascending are already in destination order, rewrite local from its histogram. */
+    dist_unpack(hist, range, lo, *local);
+
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    send_displs[0] = recv_displs[0] = 0;
+    for (int r = 1; r < world; ++r) {
+        send_displs[r] = send_displs[r-1] + send_counts[r-1];
+        recv_displs[r] = recv_displs[r-1] + recv_counts[r-1];
+    }
+
+    /* Exactly the even share arrives. */
+    lib_gen_share(n, id, world, &offset, &count);
+    if ((recv = (int *)malloc((count > 0 ? count : 1) * sizeof(int))) == NULL)
+        lib_error("COUNT: Can't allocate recv array on heap.");
+    MPI_Alltoallv(*local, send_counts, send_displs, MPI_INT, recv, recv_counts, recv_displs, MPI_INT, comm);
+
+    /* Each sender's block is sorted, one more counting pass orders their concatenation. */
+    memset(hist, 0, range * sizeof(int));
+    for (long i = 0; i < count; ++i)
+        ++hist[recv[i] - lo];
+    dist_unpack(hist, range, lo, recv);
+
+    free(*local);
+    *local = recv;
+    *local_size = (int)count;
+
+    free(hist);
+    free(below);
+    free(total);
+    free(send_counts);
+
+    return 1;
+}
+
+/*
+ * Choose the 2^levels - 1 splitters for a bucket exchange. Every rank sends up to DIST_SAMPLES of its medians
+ * of five to root, which takes the splitters at even quantiles of the combined sample and broadcasts them
+ * as a breadth first tree for lib_classify. Local is reordered. Collective over comm.
+ */
+void lib_sample_splitters(MPI_Comm comm, const int levels, int local[], const int local_size, int tree[]) {
+    int sample[DIST_SAMPLES], *all = NULL, *counts = NULL, *displs = NULL;
+    int id = 0, world = 0, medians = 0, taken = 0, all_size = 0;
+    const int splitters = (1 << levels) - 1;
+
+    if (levels < 1 || levels > DIST_MAX_LEVELS)
+        lib_error("SPLITTERS: Only 1 to 3 levels are supported.");
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    /* Sorted medians of five at the front, too few values for a group are used as they are. */
+    if (local_size >= 5) {
+        medians = lib_select_medians(local, 0, local_size-1);
+    } else {
+        lib_sort(local, local_size);
+        medians = local_size;
+    }
+
+    /* Evenly spaced medians, still sorted. */
+    taken = medians < DIST_SAMPLES ? medians : DIST_SAMPLES;
+    for (int j = 0; j < taken; ++j)
+        sample[j] = local[(long)(2*j + 1) * medians / (2*taken)];
+
+    if (id == ROOT) {
+        counts = (int *)malloc(2 * world * sizeof(int));
+        all = (int *)malloc((world * DIST_SAMPLES > 0 ? world * DIST_SAMPLES : 1) * sizeof(int));
+        if (counts == NULL || all == NULL)
+            lib_error("SPLITTERS: Can't allocate sample on heap.");
+        displs = counts + world;
+    }
+    MPI_Gather(&taken, 1, MPI_INT, counts, 1, MPI_INT, ROOT, comm);
+    if (id == ROOT) {
+        displs[0] = 0;
+        for (int r = 1; r < world; ++r)
+            displs[r] = displs[r-1] + counts[r-1];
+        all_size = displs[world-1] + counts[world-1];
+    }
+    MPI_Gatherv(sample, taken, MPI_INT, all, counts, displs, MPI_INT, ROOT, comm);
+
+    if (id == ROOT) {
+        lib_sort(all, all_size);
+
+        /* Too small a sample for quantiles, any splitter will do. */
+        if (all_size < 2) {
+            for (int i = 0; i < splitters; ++i)
+                tree[i] = all_size > 0 ? all[0] : 0;
+        } else {
+            lib_select_pivots_from_medians(levels, tree, splitters, all, all_size);
+        }
+
+        free(all);
+        free(counts);
+    }
+    MPI_Bcast(tree, splitters, MPI_INT, ROOT, comm);
+}
+
+/*
+ * Merge the sketch of every rank of comm, afterwards each rank holds the same sketch of all values.
+ * Collective over comm.
+ */
+void lib_sketch_allreduce(MPI_Comm comm, quantile_sketch_t *sketch) {
+    MPI_Datatype type;
+    MPI_Op op;
+
+    /* Merging isn't commutative bit for bit, a fixed order gives every rank the same sketch. */
+    MPI_Type_contiguous(sizeof(quantile_sketch_t), MPI_BYTE, &type);
+    MPI_Type_commit(&type);
+    MPI_Op_create(dist_sketch_merge, 0, &op);
+
+    MPI_Allreduce(MPI_IN_PLACE, sketch, 1, type, op, comm);
+
+    MPI_Op_free(&op);
+    MPI_Type_free(&type);
+}
+
+/*
+ * Choose the 2^levels - 1 splitters for a bucket exchange from a merged quantile sketch instead of a sample,
+ * one streaming pass over local and one reduction, no gather and sort at root. Same breadth first tree as
+ * lib_sample_splitters and up to CLASSIFY_MAX_LEVELS. Collective over comm.
+ */
+void lib_sketch_splitters(MPI_Comm comm, const int levels, const int local[], const int local_size, int tree[]) {
+    const int splitters = (1 << levels) - 1;
+    double qs[(1 << CLASSIFY_MAX_LEVELS) - 1];
+    int sorted[(1 << CLASSIFY_MAX_LEVELS) - 1];
+    quantile_sketch_t *sketch = NULL;
+    int depth = 0;
+
+    if (levels < 1 || levels > CLASSIFY_MAX_LEVELS)
+        lib_error("SPLITTERS: Levels out of range for the sketch.");
+    if ((sketch = (quantile_sketch_t *)malloc(sizeof(quantile_sketch_t))) == NULL)
+        lib_error("SPLITTERS: Can't allocate sketch on heap.");
+
+    lib_sketch_init(sketch);
+    lib_sketch_update(sketch, local, local_size);
+    lib_sketch_allreduce(comm, sketch);
+
+    /* Even quantiles in order, then node i of depth d is the (2j+1) 2^(levels-d-1)-th of them, j = i - 2^d + 1. */
+    for (int i = 0; i < splitters; ++i)
+        qs[i] = (double)(i+1) / (splitters+1);
+    lib_sketch_quantiles(sketch, qs, splitters, sorted);
+    for (int i = 0; i < splitters; ++i) {
+        while ((2 << depth) - 1 <= i)
+            ++depth;
+        tree[i] = sorted[(2 * (i - (1 << depth) + 1) + 1) * (1 << (levels - depth - 1)) - 1];
+    }
+
+    /* MPI doesn't promise every rank reduced in the same order, root's splitters are the ones used. */
+    MPI_Bcast(tree, splitters, MPI_INT, ROOT, comm);
+
+    free(sketch);
+}
+
+/*
+ * Sample sort exchange, classify local against the splitter tree in one pass (see lib_classify) and deliver
+ * each bucket to its rank with a single MPI_Alltoallv. Comm must have 2^levels ranks. Afterwards every rank
+ * holds the unsorted values of its bucket and the ranks are in order, local is replaced. Collective over comm.
+ */
+void lib_bucket_exchange(MPI_Comm comm, const int tree[], const int levels, int *local[], int *local_size) {
+    int *out = NULL, *recv = NULL, *send_counts = NULL, *send_displs = NULL, *recv_counts = NULL, *recv_displs = NULL;
+    int world = 0, received = 0;
+
+    MPI_Comm_size(comm, &world);
+    if (world != 1 << levels)
+        lib_error("BUCKET: Need one rank per bucket.");
+
+    send_counts = (int *)malloc(4 * world * sizeof(int));
+    out = (int *)malloc((*local_size > 0 ? *local_size : 1) * sizeof(int));
+    if (send_counts == NULL || out == NULL)
+        lib_error("BUCKET: Can't allocate buckets on heap.");
+    send_displs = send_counts + world;
+    recv_counts = send_counts + 2 * world;
+    recv_displs = send_counts + 3 * world;
+
+    /* Bucket b is the block for rank b. */
+    lib_classify(tree, levels, *local, *local_size, send_counts, out);
+
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    send_displs[0] = recv_displs[0] = 0;
+    for (int r = 1; r < world; ++r) {
+        send_displs[r] = send_displs[r-1] + send_counts[r-1];
+        recv_displs[r] = recv_displs[r-1] + recv_counts[r-1];
+    }
+    received = recv_displs[world-1] + recv_counts[world-1];
+
+    if ((recv = (int *)malloc((received > 0 ? received : 1) * sizeof(int))) == NULL)
+        lib_error("BUCKET: Can't allocate recv array on heap.");
+    MPI_Alltoallv(out, send_counts, send_displs, MPI_INT, recv, recv_counts, recv_displs, MPI_INT, comm);
+
+    free(*local);
+    *local = recv;
+    *local_size = received;
+
+    free(out);
+    free(send_counts);
+}
+
+/*
+ * Bitonic sort over the hypercube of comm, 2^d ranks each holding the same local_size values.
+ * Each rank sorts locally, then d(d+1)/2 compare split steps with the lib_subgroup_info partners leave
+ * local sorted and the ranks in order, every rank still holding exactly local_size values.
+ * No pivots, so the work and the messages are the same for any input. Collective over comm.
+ */
+void lib_bitonic_sort(MPI_Comm comm, int local[], const int local_size) {
+    MPI_Request *requests = NULL;
+    subgroup_info_t info = {0, 0, 0, 0, 0};
+    int *recv = NULL, *merged = NULL;
+    int world = 0, dimension = 0, round = 0, ascending = 0;
+    int sizes[2] = {-local_size, local_size};
+
+    MPI_Comm_rank(comm, &info.world_id);
+    MPI_Comm_size(comm, &world);
+    while ((1 << dimension) < world)
+        ++dimension;
+    if ((1 << dimension) != world)
+        lib_error("BITONIC: Needs a power of two ranks.");
+
+    /* Compare split keeps exactly local_size, so every rank must start with the same. */
+    MPI_Allreduce(MPI_IN_PLACE, sizes, 2, MPI_INT, MPI_MAX, comm);
+    if (-sizes[0] != sizes[1])
+        lib_error("BITONIC: Every rank needs the same number of values.");
+
+    lib_sort(local, local_size);
+    lib_prof_lap(PROF_LOCAL_SORT);
+    if (dimension == 0 || local_size == 0)
+        return;
+
+    recv = (int *)malloc(local_size * sizeof(int));
+    merged = (int *)malloc(local_size * sizeof(int));
+    requests = (MPI_Request *)malloc(2 * dimension * sizeof(MPI_Request));
+    if (recv == NULL || merged == NULL || requests == NULL)
+        lib_error("BITONIC: Can't allocate buffers on heap.");
+
+    /* One partner per dimension and the buffers never move, so all messages can be set up now. */
+    for (int j = 0; j < dimension; ++j) {
+        lib_subgroup_info(j+1, &info);
+        MPI_Send_init(local, local_size, MPI_INT, info.partner, BITONIC_TAG, comm, &requests[2*j]);
+        MPI_Recv_init(recv, local_size, MPI_INT, info.partner, BITONIC_TAG, comm, &requests[2*j+1]);
+    }
+
+    /* Stage i merges bitonic runs of 2^(i+1) ranks, ascending or descending by the next bit of the id. */
+    for (int i = 0; i < dimension; ++i) {
+        ascending = ((info.world_id >> (i+1)) & 1) == 0;
+        for (int j = i; j >= 0; --j) {
+            lib_subgroup_info(j+1, &info);
+            lib_prof_round(round++);
+
+            MPI_Startall(2, &requests[2*j]);
+            MPI_Waitall(2, &requests[2*j], MPI_STATUSES_IGNORE);
+            lib_prof_bytes(2L * local_size * sizeof(int), 2L * local_size * sizeof(int));
+            lib_prof_lap(PROF_EXCHANGE);
+
+            /* Lower id of the pair keeps the small half of an ascending run. */
+            dist_split(local, recv, local_size, (info.world_id < info.partner) == ascending, merged);
+            memcpy(local, merged, local_size * sizeof(int));
+            lib_prof_lap(PROF_UNION);
+        }
+    }
+
+    for (int j = 0; j < 2 * dimension; ++j)
+        MPI_Request_free(&requests[j]);
+    free(requests);
+    free(recv);
+    free(merged);
+}
+
+/*
+ * Distributed top k over comm, the k smallest values of all ranks or the k largest when largest is set.
+ * Each rank selects its own k candidates, the tightest k-th value among the ranks that have k bounds the answer
+ * and only candidates within it are gathered, at most k per rank. Root writes the answer to out in increasing
+ * order, out must hold k ints there. Returns the count at root, fewer than k only when all ranks together
+ * hold fewer, 0 elsewhere. Local is reordered. Collective over comm.
+ */
+int lib_top_k(MPI_Comm comm, int local[], const int local_size, const int k, const int largest, int out[]) {
+    int id = 0, world = 0, keep = local_size < k ? local_size : k, bound = 0, threshold = 0;
+    int survivors = 0, total = 0, found = 0;
+    int *cand = NULL, *all = NULL, *counts = NULL, *displs = NULL;
+
+    if (k < 0)
+        lib_error("DIST: Top k can't be negative.");
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    /* A rank with k candidates already has k values within its worst one, no answer lies beyond that. */
+    cand = dist_extreme(local, local_size, keep, largest);
+    bound = largest ? INT_MIN : INT_MAX;
+    for (int i = 0; k > 0 && keep == k && i < keep; ++i)
+        bound = largest ? (cand[i] < bound ? cand[i] : bound) : (cand[i] > bound ? cand[i] : bound);
+    MPI_Allreduce(&bound, &threshold, 1, MPI_INT, largest ? MPI_MAX : MPI_MIN, comm);
+    lib_prof_lap(PROF_LOCAL_SORT);
+
+    for (int i = 0; i < keep; ++i) {
+        if (largest ? cand[i] >= threshold : cand[i] <= threshold)
+            cand[survivors++] = cand[i];
+    }
+
+    /* Only the survivors go to root. */
+    if (id == ROOT) {
+        counts = (int *)malloc(world * sizeof(int));
+        displs = (int *)malloc(world * sizeof(int));
+        if (counts == NULL || displs == NULL)
+            lib_error("DIST: Can't allocate top k counts on heap.");
+    }
+    MPI_Gather(&survivors, 1, MPI_INT, counts, 1, MPI_INT, ROOT, comm);
+    if (id == ROOT) {
+        displs[0] = 0;
+        for (int i = 1; i < world; ++i)
+            displs[i] = displs[i-1] + counts[i-1];
+        total = displs[world-1] + counts[world-1];
+        if ((all = (int *)malloc((total > 0 ? total : 1) * sizeof(int))) == NULL)
+            lib_error("DIST: Can't allocate top k candidates on heap.");
+    }
+    MPI_Gatherv(cand, survivors, MPI_INT, all, counts, displs, MPI_INT, ROOT, comm);
+    lib_prof_bytes((long)(id == ROOT ? total : survivors) * sizeof(int),
+            (long)(id == ROOT ? total : survivors) * sizeof(int));
+    lib_prof_lap(PROF_GATHER);
+
+    /* Ties at the threshold can leave root more than k, the same select settles them. */
+    if (id == ROOT) {
+        found = total < k ? total : k;
+        cand = dist_extreme(all, total, found, largest);
+        lib_sort(cand, found);
+        memcpy(out, cand, found * sizeof(int));
+        lib_prof_lap(PROF_LOCAL_SORT);
+    }
+
+    free(all);
+    free(counts);
+    free(displs);
+
+    return found;
+}
+
+/*
+ * Exact distributed multiselect over comm, out[i] gets the kths[i]-th smallest value of all ranks, counting
+ * from 1, in any order and with repeats. No values move, every round picks a pivot from the ranks' weighted
+ * medians, partitions local around it and sums the counts, so rounds are logarithmic in the total and each
+ * costs O(local_size) plus one small allreduce. Every rank gets every answer. Local is reordered.
+ * Collective over comm.
+ */
+void lib_dist_multiselect(MPI_Comm comm, int local[], const int local_size, const long kths[], const int count,
+        int out[]) {
+    int world = 0;
+    int *pairs = NULL, *slots = NULL;
+    long total = local_size, *sorted = NULL;
+
+    MPI_Comm_size(comm, &world);
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_LONG, MPI_SUM, comm);
+
+    pairs = (int *)malloc(2 * world * sizeof(int));
+    slots = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    sorted = (long *)malloc((count > 0 ? count : 1) * sizeof(long));
+    if (pairs == NULL || slots == NULL || sorted == NULL)
+        lib_error("DIST: Can't allocate select arrays on heap.");
+
+    /* Ranks in increasing order so each partition splits them in two, insertion sort as batches are small. */
+    for (int i = 0; i < count; ++i) {
+        int j = i;
+
+        if (kths[i] < 1 || kths[i] > total)
+            lib_error("DIST: Select rank out of range.");
+        for (; j > 0 && sorted[j-1] > kths[i]; --j) {
+            sorted[j] = sorted[j-1];
+            slots[j] = slots[j-1];
+        }
+        sorted[j] = kths[i];
+        slots[j] = i;
+    }
+
+    dist_multiselect(comm, local, local_size, 0, sorted, slots, count, 0, out, pairs);
+
+    free(pairs);
+    free(slots);
+    free(sorted);
+}
+
+/*
+ * Exact distributed select over comm, the kth smallest value of all ranks counting from 1, on every rank.
+ * See lib_dist_multiselect. Local is reordered. Collective over comm.
+ */
+int lib_dist_select(MPI_Comm comm, int local[], const int local_size, const long kth) {
+    int out = 0;
+
+    lib_dist_multiselect(comm, local, local_size, &kth, 1, &out);
+
+    return out;
+}
+
+/*
+ * Move a globally sorted layout over comm so rank r ends with targets[r] elements in out, order kept. Sizes are
+ * every rank's current count and add up to the same as targets. Elements are elem_size bytes of MPI datatype
+ * elem. Each rank sends point to point only the slices of local that fall in another rank's target, no all to
+ * all. Out holds targets[id] elements and doesn't overlap local. Collective over comm.
+ */
+void lib_dist_place(MPI_Comm comm, MPI_Datatype elem, const size_t elem_size, const void *local, const int sizes[],
+        const int targets[], void *out) {
+    int id = 0, world = 0, messages = 0;
+    long have = 0, want = 0, my_have = 0, my_want = 0, from = 0, to = 0;
+    MPI_Request *requests = NULL;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    if ((requests = (MPI_Request *)malloc(2 * world * sizeof(MPI_Request))) == NULL)
+        lib_error("PLACE: Can't allocate requests on heap.");
+
+    /* Where my values and my target start in the global order. */
+    for (int r = 0; r < id; ++r) {
+        my_have += sizes[r];
+        my_want += targets[r];
+    }
+
+    /* Receive the part of my target each rank holds, send the part of mine in each rank's target. */
+    for (int r = 0; r < world; ++r) {
+        from = have > my_want ? have : my_want;
+        to = have + sizes[r] < my_want + targets[id] ? have + sizes[r] : my_want + targets[id];
+        if (r != id && to > from)
+            MPI_Irecv((char *)out + (from - my_want) * elem_size, (int)(to - from), elem, r, EQUALIZE_TAG, comm,
+                    &requests[messages++]);
+
+        from = my_have > want ? my_have : want;
+        to = my_have + sizes[id] < want + targets[r] ? my_have + sizes[id] : want + targets[r];
+        if (to > from) {
+            if (r == id)
+                memcpy((char *)out + (from - my_want) * elem_size, (const char *)local + (from - my_have) * elem_size,
+                        (to - from) * elem_size);
+            else
+                MPI_Isend((const char *)local + (from - my_have) * elem_size, (int)(to - from), elem, r,
+                        EQUALIZE_TAG, comm, &requests[messages++]);
+        }
+
+        have += sizes[r];
+        want += targets[r];
+    }
+    MPI_Waitall(messages, requests, MPI_STATUSES_IGNORE);
+
+    free(requests);
+}
+
+/*
+ * Even out a globally sorted layout over comm, rank r ends with the r-th even share of all values
+ * (see lib_gen_share) with the order kept. Every rank learns the p sizes, then lib_dist_place sends point to
+ * point only the slices of its range that fall in another rank's share, no all to all. Local is replaced.
+ * Collective over comm.
+ */
+void lib_equalize(MPI_Comm comm, int *local[], int *local_size) {
+    int id = 0, world = 0, *sizes = NULL, *targets = NULL, *out = NULL;
+    long total = 0, offset = 0, share = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    if ((sizes = (int *)malloc(2 * world * sizeof(int))) == NULL)
+        lib_error("EQUALIZE: Can't allocate sizes on heap.");
+    targets = sizes + world;
+
+    /* Where every rank's values sit in the global order now, and the even share each should hold. */
+    MPI_Allgather(local_size, 1, MPI_INT, sizes, 1, MPI_INT, comm);
+    for (int r = 0; r < world; ++r)
+        total += sizes[r];
+    for (int r = 0; r < world; ++r) {
+        lib_gen_share(total, r, world, &offset, &share);
+        targets[r] = (int)share;
+    }
+
+    if ((out = (int *)malloc((targets[id] > 0 ? targets[id] : 1) * sizeof(int))) == NULL)
+        lib_error("EQUALIZE: Can't allocate share on heap.");
+    lib_dist_place(comm, MPI_INT, sizeof(int), *local, sizes, targets, out);
+
+    free(*local);
+    *local = out;
+    *local_size = targets[id];
+
+    free(sizes);
+}
+
+/*
+ * Fold comm onto its first cube ranks for a hypercube algorithm: ranks at or past cube send their local_size
+ * elements to rank id - cube and end with none, the ones below append their partner's. Elements are elem_size
+ * bytes of MPI datatype elem. Returns local, grown with realloc where a partner's elements arrived.
+ * Collective over comm.
+ */
+void *lib_dist_fold(MPI_Comm comm, const int cube, MPI_Datatype elem, const size_t elem_size, void *local,
+        int *local_size) {
+    MPI_Status status;
+    int id = 0, world = 0, received = 0;
+    void *grown = NULL;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    if (id >= cube) {
+        MPI_Send(local, *local_size, elem, id - cube, FOLD_TAG, comm);
+        *local_size = 0;
+    } else if (id + cube < world) {
+        MPI_Probe(id + cube, FOLD_TAG, comm, &status);
+        MPI_Get_count(&status, elem, &received);
+        if ((grown = realloc(local, (*local_size + received + 1) * elem_size)) == NULL)
+            lib_error("FOLD: Can't grow local for the fold.");
+        local = grown;
+        MPI_Recv((char *)local + *local_size * elem_size, received, elem, id + cube, FOLD_TAG, comm,
+                MPI_STATUS_IGNORE);
+        *local_size += received;
+    }
+
+    return local;
+}
+
+/*
+ * 1 on every rank when the ranks' values in rank order are already sorted, else 0. One pass over local
+ * for its natural runs, then each rank compares its first value with the largest last value before it,
+ * empty ranks included. Collective over comm.
+ */
+int lib_dist_sorted(MPI_Comm comm, const int local[], const int local_size) {
+    long last = local_size > 0 ? local[local_size-1] : LONG_MIN, below = LONG_MIN;
+    int id = 0, sorted = lib_count_runs(local, local_size) <= 1;
+
+    MPI_Comm_rank(comm, &id);
+
+    /* Exscan leaves rank 0's result undefined. */
+    MPI_Exscan(&last, &below, 1, MPI_LONG, MPI_MAX, comm);
+    if (id > 0 && local_size > 0)
+        sorted &= below <= local[0];
+    MPI_Allreduce(MPI_IN_PLACE, &sorted, 1, MPI_INT, MPI_LAND, comm);
+
+    return sorted;
+}
+
+/*
+ * Order independent hash of vals, the sum mod 2^64 of a 64 bit mix of each value. Hashes of parts of a multiset
+ * add up to the hash of the whole, whatever the order or the ranks they are on.
+ */
+uint64_t lib_multiset_hash(const int vals[], const int size) {
+    uint64_t hash = 0;
+
+    /* Mixed after an offset by the golden ratio, so 0 doesn't hash to 0. */
+    for (int i = 0; i < size; ++i)
+        hash += lib_mix64((uint64_t)(uint32_t)vals[i] + MIX_GOLDEN);
+
+    return hash;
+}
+
+/*
+ * Count and multiset hash of all ranks' values over comm, every rank gets the same. One pass over local and
+ * one MPI_Allreduce. Collective over comm.
+ */
+void lib_dist_digest(MPI_Comm comm, const int local[], const int local_size, dist_digest_t *digest) {
+    uint64_t sums[2] = {(uint64_t)local_size, lib_multiset_hash(local, local_size)};
+
+    /* Both wrap mod 2^64, the count never gets near. */
+    MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPI_UINT64_T, MPI_SUM, comm);
+    digest->count = (long)sums[0];
+    digest->hash = sums[1];
+}
+
+/*
+ * 1 on every rank when the ranks' values are sorted in rank order (lib_dist_sorted) and are the same multiset
+ * as input, a lib_dist_digest of the values before sorting, else 0. O(local_size) and a few small collectives,
+ * cheap enough to leave on. Collective over comm.
+ */
+int lib_dist_verify(MPI_Comm comm, const int local[], const int local_size, const dist_digest_t *input) {
+    dist_digest_t output;
+    const int sorted = lib_dist_sorted(comm, local, local_size);
+
+    lib_dist_digest(comm, local, local_size, &output);
+
+    return sorted && output.count == input->count && output.hash == input->hash;
+}
+
+/*
+ * Splitters for records keyed on 64 bit ints. Every rank gets all ranks' samples and picks the same world-1
+ * splitters from their sorted union, no root step. Collective over comm.
+ */
+void lib_key_splitters(MPI_Comm comm, const int64_t sample[], const int count, int64_t splitters[]) {
+    int world = 0, total = 0, *counts = NULL, *displs = NULL;
+    int64_t *all = NULL;
+
+    MPI_Comm_size(comm, &world);
+    counts = (int *)malloc(2 * world * sizeof(int));
+    if (counts == NULL)
+        lib_error("KEY: Can't allocate counts on heap.");
+    displs = counts + world;
+
+    MPI_Allgather(&count, 1, MPI_INT, counts, 1, MPI_INT, comm);
+    for (int r = 0; r < world; ++r) {
+        displs[r] = total;
+        total += counts[r];
+    }
+    if ((all = (int64_t *)malloc((total > 0 ? total : 1) * sizeof(int64_t))) == NULL)
+        lib_error("KEY: Can't allocate sample on heap.");
+    MPI_Allgatherv(sample, count, MPI_INT64_T, all, counts, displs, MPI_INT64_T, comm);
+
+    qsort(all, total, sizeof(int64_t), dist_compare_key);
+    for (int d = 0; d < world-1; ++d)
+        splitters[d] = total > 0 ? all[(long)(d+1) * total / world] : 0;
+
+    free(counts);
+    free(all);
+}
+
+/*
+ * Deliver records sorted on a leading int64_t key to their ranks, keys up to splitters[d] and above
+ * splitters[d-1] go to rank d, in one MPI_Alltoallv. Vals is replaced by what this rank receives, in rank
+ * order, so it is sorted only per sender. Collective over comm.
+ */
+void lib_key_exchange(MPI_Comm comm, const int64_t splitters[], MPI_Datatype type, const size_t elem_size,
+        void **vals, int *size) {
+    int world = 0, received = 0, pos = 0;
+    int *counts = NULL, *displs = NULL, *recv_counts = NULL, *recv_displs = NULL;
+    void *recv = NULL;
+
+    MPI_Comm_size(comm, &world);
+    counts = (int *)malloc(4 * world * sizeof(int));
+    if (counts == NULL)
+        lib_error("KEY: Can't allocate counts on heap.");
+    displs = counts + world;
+    recv_counts = counts + 2 * world;
+    recv_displs = counts + 3 * world;
+
+    /* Sorted, so each rank's part is the run up to its splitter. */
+    for (int d = 0; d < world; ++d) {
+        displs[d] = pos;
+        while (pos < *size && (d == world-1 || dist_key_at(*vals, elem_size, pos) <= splitters[d]))
+            ++pos;
+        counts[d] = pos - displs[d];
+    }
+
+    MPI_Alltoall(counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    for (int s = 0; s < world; ++s) {
+        recv_displs[s] = received;
+        received += recv_counts[s];
+    }
+    if ((recv = malloc((received > 0 ? received : 1) * elem_size)) == NULL)
+        lib_error("KEY: Can't allocate exchange on heap.");
+    MPI_Alltoallv(*vals, counts, displs, type, recv, recv_counts, recv_displs, type, comm);
+
+    free(*vals);
+    *vals = recv;
+    *size = received;
+
+    free(counts);
+}
+
+/*
+ * Read this rank's even share (see lib_gen_share) of a binary file of elem_size elements into a malloced
+ * array. Offset is set to the index of the first element read. Returns the number read.
+ */
+long lib_dist_read(MPI_Comm comm, const char *filename, const size_t elem_size, void **vals, long *offset) {
+    int id = 0, world = 0;
+    long total = 0, count = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    if ((total = lib_count_binary(filename, elem_size)) < 0)
+        lib_error("READ: Can't read input file.");
+    lib_gen_share(total, id, world, offset, &count);
+
+    if ((*vals = malloc((count > 0 ? count : 1) * elem_size)) == NULL)
+        lib_error("READ: Can't allocate share on heap.");
+    if (lib_read_binary(filename, *vals, elem_size, *offset, count) != count)
+        lib_error("READ: Short read of input file.");
+
+    return count;
+}
+
+/*
+ * Read this rank's even share of a binary file of kv64_t records into a malloced array, or of native ints
+ * when keys_only is set, each key then getting its index in the file as payload. Returns the number read.
+ */
+int lib_dist_read_kv64(MPI_Comm comm, const char *filename, const int keys_only, kv64_t *vals[]) {
+    long offset = 0, count = 0;
+    int *keys = NULL;
+
+    if (!keys_only)
+        return (int)lib_dist_read(comm, filename, sizeof(kv64_t), (void **)vals, &offset);
+
+    count = lib_dist_read(comm, filename, sizeof(int), (void **)&keys, &offset);
+    if ((*vals = (kv64_t *)malloc((count > 0 ? count : 1) * sizeof(kv64_t))) == NULL)
+        lib_error("READ: Can't allocate records on heap.");
+    for (long i = 0; i < count; ++i) {
+        (*vals)[i].key = keys[i];
+        (*vals)[i].payload = offset + i;
+    }
+
+    free(keys);
+    return (int)count;
+}
+
+/*
+ * Write every rank's count elements to filename in rank order with collective MPI-IO, offsets from MPI_Exscan
+ * of the counts so root never holds the result. Returns the total written. Collective over comm.
+ */
+long lib_dist_write(MPI_Comm comm, const char *filename, const void *vals, const size_t elem_size,
+        const long count) {
+    MPI_File fh;
+    MPI_Status status;
+    int id = 0, size = 0;
+    long offset = 0, total = 0, rounds = 0, done = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Exscan(&count, &offset, 1, MPI_LONG, MPI_SUM, comm);
+    if (id == 0)
+        offset = 0;
+    MPI_Allreduce(&count, &total, 1, MPI_LONG, MPI_SUM, comm);
+
+    /* Truncate any older, longer output first. */
+    if (MPI_File_open(comm, (char *)filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        lib_error("WRITE: Failed to open file.");
+    MPI_File_set_size(fh, total * (MPI_Offset)elem_size);
+
+    /* Write is collective, every rank makes the same number of calls even with nothing left. */
+    rounds = (count + DIST_WRITE_CHUNK - 1) / DIST_WRITE_CHUNK;
+    MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_LONG, MPI_MAX, comm);
+    for (long r = 0; r < rounds; ++r) {
+        size = count - done < DIST_WRITE_CHUNK ? (int)(count - done) : DIST_WRITE_CHUNK;
+        MPI_File_write_at_all(fh, (offset + done) * (MPI_Offset)elem_size, (const char *)vals + done * elem_size,
+                size * (int)elem_size, MPI_BYTE, &status);
+        done += size;
+    }
+
+    MPI_File_close(&fh);
+
+    return total;
+}
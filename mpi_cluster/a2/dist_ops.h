@@ -0,0 +1,199 @@
+#ifndef _DIST_OPS_H_
+#define _DIST_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "typed_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Widest key range (max - min + 1) the counting sort accepts, wider ranges fall back to comparison sorts. */
+#define DIST_COUNT_RANGE    (1 << 20)
+/* Medians each rank contributes to the splitter sample. */
+#define DIST_SAMPLES        64
+/* Deepest splitter tree lib_select_pivots_from_medians fills. */
+#define DIST_MAX_LEVELS     3
+/* Tag of the bitonic compare split messages. */
+#define BITONIC_TAG         20
+/* Tag of the equalize and place slices. */
+#define EQUALIZE_TAG        21
+/* Tag of the elements folded onto the cube. */
+#define FOLD_TAG            23
+/* Elements written per collective call of lib_dist_write. */
+#define DIST_WRITE_CHUNK    (1 << 16)
+
+/******************* Type Declarations ********************/
+/* Count and order independent hash of a distributed multiset, see lib_dist_digest. */
+typedef struct dist_digest_s {
+    long count; /* Values over all ranks. */
+    uint64_t hash; /* Sum of lib_multiset_hash over all ranks, mod 2^64. */
+} dist_digest_t;
+
+/********************** Prototypes ************************/
+/*
+ * True when range keys spread over total values suit lib_count_sort: the range is within DIST_COUNT_RANGE and
+ * no wider than the values, so the histograms and their collectives cost no more than moving the values.
+ */
+int lib_count_fits(const long range, const long total);
+
+/*
+ * Global counting sort over comm for keys in a small range, no pivots and no rounds.
+ * Histograms are summed with MPI_Allreduce and prefixed over the ranks with MPI_Exscan, that gives every key's
+ * exact output position so one MPI_Alltoallv moves each value straight to its final rank.
+ * Afterwards rank r holds the r-th even share of all values (see lib_gen_share) in sorted order, local is replaced.
+ * Returns 1 when sorted, 0 with local untouched unless lib_count_fits the global range and count. Collective
+ * over comm.
+ */
+int lib_count_sort(MPI_Comm comm, int *local[], int *local_size);
+
+/*
+ * Choose the 2^levels - 1 splitters for a bucket exchange. Every rank sends up to DIST_SAMPLES of its medians
+ * of five to root, which takes the splitters at even quantiles of the combined sample and broadcasts them
+ * as a breadth first tree for lib_classify. Local is reordered. Collective over comm.
+ */
+void lib_sample_splitters(MPI_Comm comm, const int levels, int local[], const int local_size, int tree[]);
+
+/*
+ * Merge the sketch of every rank of comm, afterwards each rank holds the same sketch of all values.
+ * Collective over comm.
+ */
+void lib_sketch_allreduce(MPI_Comm comm, quantile_sketch_t *sketch);
+
+/*
+ * Choose the 2^levels - 1 splitters for a bucket exchange from a merged quantile sketch instead of a sample,
+ * one streaming pass over local and one reduction, no gather and sort at root. Same breadth first tree as
+ * lib_sample_splitters and up to CLASSIFY_MAX_LEVELS. Collective over comm.
+ */
+void lib_sketch_splitters(MPI_Comm comm, const int levels, const int local[], const int local_size, int tree[]);
+
+/*
+ * Sample sort exchange, classify local against the splitter tree in one pass (see lib_classify) and deliver
+ * each bucket to its rank with a single MPI_Alltoallv. Comm must have 2^levels ranks. Afterwards every rank
+ * holds the unsorted values of its bucket and the ranks are in order, local is replaced. Collective over comm.
+ */
+void lib_bucket_exchange(MPI_Comm comm, const int tree[], const int levels, int *local[], int *local_size);
+
+/*
+ * Bitonic sort over the hypercube of comm, 2^d ranks each holding the same local_size values.
+ * Each rank sorts locally, then d(d+1)/2 compare split steps with the lib_subgroup_info partners leave
+ * local sorted and the ranks in order, every rank still holding exactly local_size values.
+ * No pivots, so the work and the messages are the same for any input. Collective over comm.
+ */
+void lib_bitonic_sort(MPI_Comm comm, int local[], const int local_size);
+
+/*
+ * Distributed top k over comm, the k smallest values of all ranks or the k largest when largest is set.
+ * Each rank selects its own k candidates, the tightest k-th value among the ranks that have k bounds the answer
+ * and only candidates within it are gathered, at most k per rank. Root writes the answer to out in increasing
+ * order, out must hold k ints there. Returns the count at root, fewer than k only when all ranks together
+ * hold fewer, 0 elsewhere. Local is reordered. Collective over comm.
+ */
+int lib_top_k(MPI_Comm comm, int local[], const int local_size, const int k, const int largest, int out[]);
+
+/*
+ * Exact distributed multiselect over comm, out[i] gets the kths[i]-th smallest value of all ranks, counting
+ * from 1, in any order and with repeats. No values move, every round picks a pivot from the ranks' weighted
+ * medians, partitions local around it and sums the counts, so rounds are logarithmic in the total and each
+ * costs O(local_size) plus one small allreduce. Every rank gets every answer. Local is reordered.
+ * Collective over comm.
+ */
+void lib_dist_multiselect(MPI_Comm comm, int local[], const int local_size, const long kths[], const int count,
+        int out[]);
+
+/*
+ * Exact distributed select over comm, the kth smallest value of all ranks counting from 1, on every rank.
+ * See lib_dist_multiselect. Local is reordered. Collective over comm.
+ */
+int lib_dist_select(MPI_Comm comm, int local[], const int local_size, const long kth);
+
+/*
+ * Move a globally sorted layout over comm so rank r ends with targets[r] elements in out, order kept. Sizes are
+ * every rank's current count and add up to the same as targets. Elements are elem_size bytes of MPI datatype
+ * elem. Each rank sends point to point only the slices of local that fall in another rank's target, no all to
+ * all. Out holds targets[id] elements and doesn't overlap local. Collective over comm.
+ */
+void lib_dist_place(MPI_Comm comm, MPI_Datatype elem, const size_t elem_size, const void *local, const int sizes[],
+        const int targets[], void *out);
+
+/*
+ * Even out a globally sorted layout over comm, rank r ends with the r-th even share of all values
+ * (see lib_gen_share) with the order kept. Every rank learns the p sizes, then lib_dist_place sends point to
+ * point only the slices of its range that fall in another rank's share, no all to all. Local is replaced.
+ * Collective over comm.
+ */
+void lib_equalize(MPI_Comm comm, int *local[], int *local_size);
+
+/*
+ * Fold comm onto its first cube ranks for a hypercube algorithm: ranks at or past cube send their local_size
+ * elements to rank id - cube and end with none, the ones below append their partner's. Elements are elem_size
+ * bytes of MPI datatype elem. Returns local, grown with realloc where a partner's elements arrived.
+ * Collective over comm.
+ */
+void *lib_dist_fold(MPI_Comm comm, const int cube, MPI_Datatype elem, const size_t elem_size, void *local,
+        int *local_size);
+
+/*
+ * 1 on every rank when the ranks' values in rank order are already sorted, else 0. One pass over local
+ * for its natural runs, then each rank compares its first value with the largest last value before it,
+ * empty ranks included. Collective over comm.
+ */
+int lib_dist_sorted(MPI_Comm comm, const int local[], const int local_size);
+
+/*
+ * Order independent hash of vals, the sum mod 2^64 of a 64 bit mix of each value. Hashes of parts of a multiset
+ * add up to the hash of the whole, whatever the order or the ranks they are on.
+ */
+uint64_t lib_multiset_hash(const int vals[], const int size);
+
+/*
+ * Count and multiset hash of all ranks' values over comm, every rank gets the same. One pass over local and
+ * one MPI_Allreduce. Collective over comm.
+ */
+void lib_dist_digest(MPI_Comm comm, const int local[], const int local_size, dist_digest_t *digest);
+
+/*
+ * 1 on every rank when the ranks' values are sorted in rank order (lib_dist_sorted) and are the same multiset
+ * as input, a lib_dist_digest of the values before sorting, else 0. O(local_size) and a few small collectives,
+ * cheap enough to leave on. Collective over comm.
+ */
+int lib_dist_verify(MPI_Comm comm, const int local[], const int local_size, const dist_digest_t *input);
+
+/*
+ * Splitters for records keyed on 64 bit ints. Every rank gets all ranks' samples and picks the same world-1
+ * splitters from their sorted union, no root step. Collective over comm.
+ */
+void lib_key_splitters(MPI_Comm comm, const int64_t sample[], const int count, int64_t splitters[]);
+
+/*
+ * Deliver records sorted on a leading int64_t key to their ranks, keys up to splitters[d] and above
+ * splitters[d-1] go to rank d, in one MPI_Alltoallv. Vals is replaced by what this rank receives, in rank
+ * order, so it is sorted only per sender. Collective over comm.
+ */
+void lib_key_exchange(MPI_Comm comm, const int64_t splitters[], MPI_Datatype type, const size_t elem_size,
+        void **vals, int *size);
+
+/*
+ * Read this rank's even share (see lib_gen_share) of a binary file of elem_size elements into a malloced
+ * array. Offset is set to the index of the first element read. Returns the number read.
+ */
+long lib_dist_read(MPI_Comm comm, const char *filename, const size_t elem_size, void **vals, long *offset);
+
+/*
+ * Read this rank's even share of a binary file of kv64_t records into a malloced array, or of native ints
+ * when keys_only is set, each key then getting its index in the file as payload. Returns the number read.
+ */
+int lib_dist_read_kv64(MPI_Comm comm, const char *filename, const int keys_only, kv64_t *vals[]);
+
+/*
+ * Write every rank's count elements to filename in rank order with collective MPI-IO, offsets from MPI_Exscan
+ * of the counts so root never holds the result. Returns the total written. Collective over comm.
+ */
+long lib_dist_write(MPI_Comm comm, const char *filename, const void *vals, const size_t elem_size,
+        const long count);
+
+#endif /* _DIST_OPS_H_ */
@@ -0,0 +1,520 @@
+/**
+ * External memory (out of core) sort for inputs larger than the memory of the cluster.
+ * Data lives in binary run files on local scratch, all reads and writes are large sequential
+ * blocks. Runs are combined with a loser tree so each output value costs log(k) comparisons
+ * and no branches on which run is smaller beyond the tree walk.
+ *
+ * The distributed side is a sample sort: splitters from regular samples of the local runs,
+ * then the merged stream of every rank is cut at the splitters and shipped in rounds no
+ * larger than the memory budget. Each rank appends what it receives from a source to a run,
+ * the stream from one source is already sorted so a final merge of p runs finishes the job.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "typed_ops.h"
+#include "extern_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * Grow the arrays of a run set to hold at least one more run.
+ */
+static void runs_grow(ext_runs_t *runs) {
+    int capacity = runs->capacity == 0 ? 8 : runs->capacity * 2;
+
+    if (runs->count < runs->capacity)
+        return;
+
+    runs->names = realloc(runs->names, capacity * sizeof(*runs->names));
+    runs->files = realloc(runs->files, capacity * sizeof(FILE *));
+    runs->sizes = realloc(runs->sizes, capacity * sizeof(long));
+    if (runs->names == NULL || runs->files == NULL || runs->sizes == NULL)
+        lib_error("EXT_RUNS: Can't grow run set.");
+
+    runs->capacity = capacity;
+}
+
+/*
+ * Refill a reader's block, closes the file once the run is exhausted.
+ */
+static void reader_fill(ext_reader_t *reader, const int buf_ints) {
+    reader->pos = 0;
+    reader->len = 0;
+
+    if (reader->f == NULL)
+        return;
+
+    reader->len = fread(reader->buf, sizeof(int), buf_ints, reader->f);
+    if (reader->len == 0) {
+        fclose(reader->f);
+        reader->f = NULL;
+    }
+}
+
+/*
+ * Advance input i to its next value, marks it dead when exhausted.
+ */
+static void merge_advance(ext_merge_t *merge, const int i) {
+    ext_reader_t *reader = merge->src + i;
+
+    if (reader->pos == reader->len)
+        reader_fill(reader, merge->buf_ints);
+
+    merge->live[i] = reader->len > 0;
+    if (merge->live[i])
+        merge->keys[i] = reader->buf[reader->pos++];
+}
+
+/*
+ * True if input a should come out before input b. Dead inputs lose to everything, ties go to lower index.
+ */
+static inline int merge_beats(const ext_merge_t *merge, const int a, const int b) {
+    if (!merge->live[b])
+        return 1;
+    if (!merge->live[a])
+        return 0;
+    return merge->keys[a] < merge->keys[b] || (merge->keys[a] == merge->keys[b] && a < b);
+}
+
+/*
+ * Play the initial tournament below node, leaves are k..2k-1. Returns the winner.
+ */
+static int merge_build(ext_merge_t *merge, const int node) {
+    int left = 0, right = 0;
+
+    if (node >= merge->k)
+        return node - merge->k;
+
+    left = merge_build(merge, 2*node);
+    right = merge_build(merge, 2*node + 1);
+    if (merge_beats(merge, left, right)) {
+        merge->tree[node] = right;
+        return left;
+    }
+
+    merge->tree[node] = left;
+    return right;
+}
+
+/*
+ * Block size of each of k merge inputs sharing half of mem_ints, the other half holds the output.
+ */
+static int merge_block(const int mem_ints, const int k) {
+    return mem_ints / (2 * (k > 0 ? k : 1));
+}
+
+/*
+ * Runs one merge takes within mem_ints: as many as get EXT_MIN_BUF from half the budget, never fewer than two.
+ */
+static int merge_fan_in(const int mem_ints) {
+    const int fan_in = mem_ints / (2*EXT_MIN_BUF);
+
+    return fan_in > 2 ? fan_in : 2;
+}
+
+/*
+ * Number of values in sorted vals that are <= key.
+ */
+static int upper_bound(const int vals[], const int size, const int key) {
+    int lo = 0, hi = size, mid = 0;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo)/2;
+        if (vals[mid] <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/*
+ * Stream this rank's share of input into sorted runs of mem_ints, keeping regular samples of each run.
+ * Samples are appended to *samples, which is realloced as needed.
+ */
+static void make_runs(ext_runs_t *runs, const char *input, const long offset, const long count,
+        const int mem_ints, const long stride, int **samples, int *num_samples) {
+    int *chunk = malloc(mem_ints * sizeof(int));
+    long done = 0, want = 0;
+    int got = 0, take = 0;
+
+    if (chunk == NULL)
+        lib_error("EXT_SORT: Can't allocate chunk on heap.");
+
+    while (done < count) {
+        want = count - done < mem_ints ? count - done : mem_ints;
+        got = lib_read_binary(input, chunk, sizeof(int), offset + done, want);
+        if (got != want)
+            lib_error("EXT_SORT: Input file ended early.");
+
+        lib_sort_i32(chunk, got);
+        lib_ext_runs_add(runs, chunk, got);
+
+        /* Regular sampling, one value from the middle of every stride of the sorted chunk. */
+        take = got / stride;
+        *samples = realloc(*samples, (*num_samples + take + 1) * sizeof(int));
+        if (*samples == NULL)
+            lib_error("EXT_SORT: Can't grow samples.");
+        for (int i = 0; i < take; ++i)
+            (*samples)[(*num_samples)++] = chunk[i*stride + stride/2];
+
+        done += got;
+    }
+
+    free(chunk);
+}
+
+/*
+ * Gather every rank's samples and pick world-1 splitters, identical on all ranks.
+ */
+static void pick_splitters(MPI_Comm comm, const int world, int samples[], const int num_samples, int splitters[]) {
+    int *counts = malloc(world * sizeof(int)), *displs = malloc(world * sizeof(int)), *all = NULL;
+    int total = 0;
+
+    if (counts == NULL || displs == NULL)
+        lib_error("EXT_SORT: Can't allocate sample counts.");
+
+    MPI_Allgather(&num_samples, 1, MPI_INT, counts, 1, MPI_INT, comm);
+    for (int i = 0; i < world; ++i) {
+        displs[i] = total;
+        total += counts[i];
+    }
+
+    all = malloc((total > 0 ? total : 1) * sizeof(int));
+    if (all == NULL)
+        lib_error("EXT_SORT: Can't allocate samples.");
+    MPI_Allgatherv(samples, num_samples, MPI_INT, all, counts, displs, MPI_INT, comm);
+    lib_sort_i32(all, total);
+
+    for (int i = 0; i < world-1; ++i)
+        splitters[i] = total > 0 ? all[(long)(i+1) * total / world] : 0;
+
+    free(all);
+    free(displs);
+    free(counts);
+}
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Start an empty set of runs, files are named <scratch>/<name>.<rank>.<run>.bin.
+ */
+void lib_ext_runs_init(ext_runs_t *runs, const char *scratch, const char *name, const int rank) {
+    memset(runs, 0, sizeof(ext_runs_t));
+    snprintf(runs->prefix, sizeof(runs->prefix), "%s/%s.%d", scratch, name, rank);
+}
+
+/*
+ * Write a sorted array out as a new run. Returns index of the run.
+ */
+int lib_ext_runs_add(ext_runs_t *runs, const int vals[], const int size) {
+    int run = runs->count;
+
+    runs_grow(runs);
+    snprintf(runs->names[run], EXT_NAME_SIZE, "%s.%d.bin", runs->prefix, run);
+    if ((runs->files[run] = fopen(runs->names[run], "wb")) == NULL)
+        lib_error("EXT_RUNS: Failed to open run file on scratch.");
+    runs->sizes[run] = 0;
+    runs->count++;
+
+    lib_ext_runs_append(runs, run, vals, size);
+
+    /* A run made in one go is complete, don't hold the handle. */
+    fclose(runs->files[run]);
+    runs->files[run] = NULL;
+
+    return run;
+}
+
+/*
+ * Append sorted values to an existing run, caller guarantees they follow its last value.
+ */
+void lib_ext_runs_append(ext_runs_t *runs, const int run, const int vals[], const int size) {
+    if (run >= runs->count)
+        lib_error("EXT_RUNS: No such run.");
+
+    if (runs->files[run] == NULL && (runs->files[run] = fopen(runs->names[run], "ab")) == NULL)
+        lib_error("EXT_RUNS: Failed to reopen run file.");
+
+    if ((int)fwrite(vals, sizeof(int), size, runs->files[run]) != size)
+        lib_error("EXT_RUNS: Failed to write run, scratch full?");
+    runs->sizes[run] += size;
+}
+
+/*
+ * Close all run files, delete them from scratch and free the set.
+ */
+void lib_ext_runs_free(ext_runs_t *runs) {
+    for (int i = 0; i < runs->count; ++i) {
+        if (runs->files[i] != NULL)
+            fclose(runs->files[i]);
+        remove(runs->names[i]);
+    }
+
+    free(runs->names);
+    free(runs->files);
+    free(runs->sizes);
+    memset(runs, 0, sizeof(ext_runs_t));
+}
+
+/*
+ * Merge runs in groups of at most fan_in, pass after pass, until no more than fan_in remain. Each pass holds
+ * mem_ints: half for the inputs' blocks, half for the output. The merged runs replace those of runs, which
+ * are deleted from scratch.
+ */
+void lib_ext_runs_reduce(ext_runs_t *runs, const int fan_in, const int mem_ints) {
+    ext_runs_t group, next;
+    ext_merge_t merge;
+    int *out = NULL, count = 0, run = 0;
+
+    if (fan_in < 2)
+        lib_error("EXT_RUNS: Can't merge fewer than two runs at a time.");
+    if (runs->count <= fan_in)
+        return;
+    if (mem_ints < 2*fan_in)
+        lib_error("EXT_RUNS: Memory budget is smaller than one value per merge input and output.");
+    if ((out = malloc(mem_ints / 2 * sizeof(int))) == NULL)
+        lib_error("EXT_RUNS: Can't allocate merge output on heap.");
+
+    while (runs->count > fan_in) {
+        memset(&next, 0, sizeof(ext_runs_t));
+        if (snprintf(next.prefix, sizeof(next.prefix), "%s.m", runs->prefix) >= (int)sizeof(next.prefix))
+            lib_error("EXT_RUNS: Scratch path too long for another merge pass.");
+
+        /* Each group is a view of fan_in consecutive runs, merged into one new run. */
+        for (int first = 0; first < runs->count; first += fan_in) {
+            group = *runs;
+            group.names += first;
+            group.files += first;
+            group.sizes += first;
+            group.count = runs->count - first < fan_in ? runs->count - first : fan_in;
+
+            run = lib_ext_runs_add(&next, NULL, 0);
+            lib_ext_merge_open(&merge, &group, merge_block(mem_ints, group.count));
+            while ((count = lib_ext_merge_next(&merge, out, mem_ints / 2)) > 0)
+                lib_ext_runs_append(&next, run, out, count);
+            lib_ext_merge_close(&merge);
+
+            if (next.files[run] != NULL) {
+                fclose(next.files[run]);
+                next.files[run] = NULL;
+            }
+        }
+
+        lib_ext_runs_free(runs);
+        *runs = next;
+    }
+
+    free(out);
+}
+
+/*
+ * Open a merge over every run in runs. Each input reads blocks of buf_ints at a time, so the merge holds
+ * about runs->count * buf_ints; see lib_ext_runs_reduce to bound it.
+ */
+void lib_ext_merge_open(ext_merge_t *merge, ext_runs_t *runs, const int buf_ints) {
+    int k = runs->count > 0 ? runs->count : 1;
+
+    if (buf_ints < 1)
+        lib_error("EXT_MERGE: Read blocks must hold at least one value.");
+
+    merge->k = k;
+    merge->buf_ints = buf_ints;
+    merge->src = calloc(k, sizeof(ext_reader_t));
+    merge->tree = calloc(k, sizeof(int));
+    merge->keys = calloc(k, sizeof(int));
+    merge->live = calloc(k, sizeof(int));
+    if (merge->src == NULL || merge->tree == NULL || merge->keys == NULL || merge->live == NULL)
+        lib_error("EXT_MERGE: Can't allocate merge.");
+
+    for (int i = 0; i < runs->count; ++i) {
+        /* Flush anything still being appended before reading it back. */
+        if (runs->files[i] != NULL) {
+            fclose(runs->files[i]);
+            runs->files[i] = NULL;
+        }
+
+        merge->src[i].buf = malloc(merge->buf_ints * sizeof(int));
+        if (merge->src[i].buf == NULL)
+            lib_error("EXT_MERGE: Can't allocate read buffer.");
+        if ((merge->src[i].f = fopen(runs->names[i], "rb")) == NULL)
+            lib_error("EXT_MERGE: Failed to open run file.");
+
+        merge_advance(merge, i);
+    }
+
+    merge->tree[0] = merge_build(merge, 1);
+}
+
+/*
+ * Fill out with up to max next values of the merge in increasing order. Returns the count, 0 once done.
+ */
+int lib_ext_merge_next(ext_merge_t *merge, int out[], const int max) {
+    int count = 0, winner = merge->tree[0], temp = 0;
+
+    while (count < max && merge->live[winner]) {
+        out[count++] = merge->keys[winner];
+        merge_advance(merge, winner);
+
+        /* Replay the winner's path, the loser stays at each node and the winner moves up. */
+        for (int node = (winner + merge->k)/2; node > 0; node /= 2) {
+            if (merge_beats(merge, merge->tree[node], winner)) {
+                temp = merge->tree[node];
+                merge->tree[node] = winner;
+                winner = temp;
+            }
+        }
+        merge->tree[0] = winner;
+    }
+
+    return count;
+}
+
+/*
+ * Close the inputs and free the merge.
+ */
+void lib_ext_merge_close(ext_merge_t *merge) {
+    for (int i = 0; i < merge->k; ++i) {
+        if (merge->src[i].f != NULL)
+            fclose(merge->src[i].f);
+        free(merge->src[i].buf);
+    }
+
+    free(merge->src);
+    free(merge->tree);
+    free(merge->keys);
+    free(merge->live);
+    memset(merge, 0, sizeof(ext_merge_t));
+}
+
+/*
+ * Out of core distributed sort of a binary file of ints, see header for details.
+ */
+long lib_ext_sort(MPI_Comm comm, const char *input, const char *output, const int mem_ints, const char *scratch) {
+    ext_runs_t local_runs, recv_runs;
+    ext_merge_t merge;
+    char out_name[EXT_NAME_SIZE];
+    int *samples = NULL, *splitters = NULL, *out = NULL, *recv = NULL;
+    int *send_counts = NULL, *send_displs = NULL, *recv_counts = NULL, *recv_displs = NULL;
+    int id = 0, world = 0, num_samples = 0, chunk = 0, count = 0, most = 0, end = 0, total = 0, fan_in = 0;
+    long num_vals = 0, offset = 0, share = 0, stride = 0, written = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    if (mem_ints < 2*world || mem_ints < 4)
+        lib_error("EXT_SORT: Memory budget is smaller than two values per rank and per merge input.");
+    fan_in = merge_fan_in(mem_ints);
+
+    /* Even share of the input file per rank. */
+    num_vals = lib_count_binary(input, sizeof(int));
+    offset = num_vals * id / world;
+    share = num_vals * (id+1) / world - offset;
+    stride = share / (EXT_OVERSAMPLE * world);
+    if (stride < 1)
+        stride = 1;
+
+    /* Phase 1: sorted runs of the local share, plus samples for the splitters. */
+    lib_ext_runs_init(&local_runs, scratch, "run", id);
+    make_runs(&local_runs, input, offset, share, mem_ints, stride, &samples, &num_samples);
+
+    splitters = malloc(world * sizeof(int));
+    if (splitters == NULL)
+        lib_error("EXT_SORT: Can't allocate splitters.");
+    pick_splitters(comm, world, samples, num_samples, splitters);
+    free(samples);
+    lib_ext_runs_reduce(&local_runs, fan_in, mem_ints);
+
+    /* Phase 2: merge local runs and route each slice to its rank. Half the budget out, half in. */
+    chunk = mem_ints / (2*world);
+    out = malloc(chunk * sizeof(int));
+    recv = malloc(chunk * world * sizeof(int));
+    send_counts = malloc(world * sizeof(int));
+    send_displs = malloc(world * sizeof(int));
+    recv_counts = malloc(world * sizeof(int));
+    recv_displs = malloc(world * sizeof(int));
+    if (out == NULL || recv == NULL || send_counts == NULL || send_displs == NULL ||
+            recv_counts == NULL || recv_displs == NULL)
+        lib_error("EXT_SORT: Can't allocate exchange buffers.");
+
+    /* One receive run per source, the stream from a source arrives in order. */
+    lib_ext_runs_init(&recv_runs, scratch, "recv", id);
+    for (int i = 0; i < world; ++i)
+        lib_ext_runs_add(&recv_runs, NULL, 0);
+
+    lib_ext_merge_open(&merge, &local_runs, merge_block(mem_ints, local_runs.count));
+    while (1) {
+        count = lib_ext_merge_next(&merge, out, chunk);
+        MPI_Allreduce(&count, &most, 1, MPI_INT, MPI_MAX, comm);
+        if (most == 0)
+            break;
+
+        /* Chunk is sorted, so each destination is a contiguous slice ending at its splitter. */
+        for (int i = 0, start = 0; i < world; ++i) {
+            end = i < world-1 ? upper_bound(out, count, splitters[i]) : count;
+            if (end < start)
+                end = start;
+            send_displs[i] = start;
+            send_counts[i] = end - start;
+            start = end;
+        }
+
+        MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+        total = 0;
+        for (int i = 0; i < world; ++i) {
+            recv_displs[i] = total;
+            total += recv_counts[i];
+        }
+        MPI_Alltoallv(out, send_counts, send_displs, MPI_INT, recv, recv_counts, recv_displs, MPI_INT, comm);
+
+        for (int i = 0; i < world; ++i)
+            if (recv_counts[i] > 0)
+                lib_ext_runs_append(&recv_runs, i, recv + recv_displs[i], recv_counts[i]);
+    }
+    lib_ext_merge_close(&merge);
+    lib_ext_runs_free(&local_runs);
+    free(recv);
+
+    /* Phase 3: merge the runs from every source into the final output of this rank. */
+    snprintf(out_name, EXT_NAME_SIZE, output, id);
+    lib_write_binary(out_name, NULL, sizeof(int), 0, 0);
+    lib_ext_runs_reduce(&recv_runs, fan_in, mem_ints);
+    lib_ext_merge_open(&merge, &recv_runs, merge_block(mem_ints, recv_runs.count));
+    chunk = mem_ints / 2;
+    out = realloc(out, chunk * sizeof(int));
+    if (out == NULL)
+        lib_error("EXT_SORT: Can't allocate output block.");
+    while ((count = lib_ext_merge_next(&merge, out, chunk)) > 0) {
+        lib_write_binary(out_name, out, sizeof(int), count, 1);
+        written += count;
+    }
+    lib_ext_merge_close(&merge);
+    lib_ext_runs_free(&recv_runs);
+
+    free(recv_displs);
+    free(recv_counts);
+    free(send_displs);
+    free(send_counts);
+    free(splitters);
+    free(out);
+
+    return written;
+}
@@ -0,0 +1,102 @@
+#ifndef _EXTERN_OPS_H_
+#define _EXTERN_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+
+/* Project Headers */
+#include "mpi.h"
+
+/******************* Constants/Macros *********************/
+/* Max length of a run file name, including the scratch directory. */
+#define EXT_NAME_SIZE       256
+/* Read buffer per merge input a pass aims for, more runs than the budget holds at this size merge in passes. */
+#define EXT_MIN_BUF         4096
+/* Samples taken per rank for every rank in the world to pick splitters. */
+#define EXT_OVERSAMPLE      32
+
+/******************* Type Declarations ********************/
+/* A set of sorted run files on local scratch. Runs can be appended to while being written. */
+typedef struct ext_runs_s {
+    char (*names)[EXT_NAME_SIZE]; /* File name of each run. */
+    FILE **files; /* Open write handle per run, NULL when closed. */
+    long *sizes; /* Number of ints in each run. */
+    int count; /* Number of runs in use. */
+    int capacity; /* Allocated slots. */
+    char prefix[EXT_NAME_SIZE - 32]; /* Scratch dir and file prefix, leaves room for the run index. */
+} ext_runs_t;
+
+/* One buffered sorted input of a merge. */
+typedef struct ext_reader_s {
+    FILE *f; /* Run file, NULL for an exhausted input. */
+    int *buf; /* Block of the run in memory. */
+    int pos; /* Next unread element in buf. */
+    int len; /* Valid elements in buf. */
+} ext_reader_t;
+
+/* K-way merge of runs with a tree of losers, one comparison per level per output element. */
+typedef struct ext_merge_s {
+    int k; /* Number of inputs. */
+    int buf_ints; /* Size of each reader block. */
+    ext_reader_t *src; /* Inputs. */
+    int *tree; /* tree[0] is the current winner, tree[1..k-1] the loser at each internal node. */
+    int *keys; /* Current head of each input. */
+    int *live; /* 0 once an input is exhausted, sorts after every live key. */
+} ext_merge_t;
+
+/********************** Prototypes ************************/
+/*
+ * Start an empty set of runs, files are named <scratch>/<name>.<rank>.<run>.bin.
+ */
+void lib_ext_runs_init(ext_runs_t *runs, const char *scratch, const char *name, const int rank);
+
+/*
+ * Write a sorted array out as a new run. Returns index of the run.
+ */
+int lib_ext_runs_add(ext_runs_t *runs, const int vals[], const int size);
+
+/*
+ * Append sorted values to an existing run, caller guarantees they follow its last value.
+ */
+void lib_ext_runs_append(ext_runs_t *runs, const int run, const int vals[], const int size);
+
+/*
+ * Close all run files, delete them from scratch and free the set.
+ */
+void lib_ext_runs_free(ext_runs_t *runs);
+
+/*
+ * Merge runs in groups of at most fan_in, pass after pass, until no more than fan_in remain. Each pass holds
+ * mem_ints: half for the inputs' blocks, half for the output. The merged runs replace those of runs, which
+ * are deleted from scratch.
+ */
+void lib_ext_runs_reduce(ext_runs_t *runs, const int fan_in, const int mem_ints);
+
+/*
+ * Open a merge over every run in runs. Each input reads blocks of buf_ints at a time, so the merge holds
+ * about runs->count * buf_ints; see lib_ext_runs_reduce to bound it.
+ */
+void lib_ext_merge_open(ext_merge_t *merge, ext_runs_t *runs, const int buf_ints);
+
+/*
+ * Fill out with up to max next values of the merge in increasing order. Returns the count, 0 once done.
+ */
+int lib_ext_merge_next(ext_merge_t *merge, int out[], const int max);
+
+/*
+ * Close the inputs and free the merge.
+ */
+void lib_ext_merge_close(ext_merge_t *merge);
+
+/*
+ * Out of core distributed sort of a binary file of ints. Each rank streams its share of input
+ * through mem_ints sized chunks into sorted runs under scratch, splitters are picked from regular
+ * samples of the runs, then the merged runs are routed to their destination rank in bounded rounds
+ * and merged again into output (a name formatted with the rank). Memory use stays near mem_ints, runs
+ * too many to merge at once with EXT_MIN_BUF blocks are first merged in passes.
+ * Returns the number of values this rank wrote, rank r holds only values <= those of rank r+1.
+ */
+long lib_ext_sort(MPI_Comm comm, const char *input, const char *output, const int mem_ints, const char *scratch);
+
+#endif /* _EXTERN_OPS_H_ */
@@ -4,15 +4,13 @@
  * It is a CSV file with each value on a single line followed by a command and a new line. If your input file differs,
  * modify it or generate a new one with my program.
  *
- * I've also defined a simple logging routine that opens a file per task and writes tracing information to it.
- * This logging is disabled via define flag at compile time.
+ * Tracing moved to trace_ops.c, it records binary events in memory and is enabled at runtime.
  */
 /********************* Header Files ***********************/
 /* C Headers */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 /* Project Headers */
 #include "array_ops.h"
@@ -88,50 +86,61 @@ void lib_write_file(const char *filename, const int *vals, const int size) {
 }
 
 /*
- * Simple logging function to log the status of buffers and other variables.
- * Each process has log for itself called log.rank.txt.
- * Format of log is: (date) tag: mesg
+ * Number of elements of elem_size bytes in a binary file.
  */
-void lib_log(FILE *f, const char *tag, const char *mesg) {
-    time_t rawtime;
-    struct tm *timeinfo;
-    char date[30];
-
-    /* Get current time and format string into date. */
-    time(&rawtime);
-    timeinfo = localtime(&rawtime);
-    strftime(date, 30, "(%T)", timeinfo);
-
-    fprintf(f, "%s %s: %s", date, tag, mesg);
-    fflush(f);
+long lib_count_binary(const char *filename, const size_t elem_size) {
+    long bytes = 0;
+    FILE *f;
+
+    if ((f = fopen(filename, "rb")) == NULL)
+        lib_error("COUNT_BINARY: Failed to open file.");
+
+    if (fseek(f, 0, SEEK_END) != 0 || (bytes = ftell(f)) < 0)
+        lib_error("COUNT_BINARY: Failed to seek to end.");
+
+    if (fclose(f) != 0)
+        lib_error("COUNT_BINARY: Failed to close properly.");
+
+    return bytes / (long)elem_size;
 }
 
 /*
- * Tracing function, takes a file and traces the values in the array.
+ * Read count elements of elem_size bytes starting at element offset of a binary file into vals.
+ * Returns the number actually read, less than count only at end of file.
  */
-void lib_trace_array(FILE *f, char *tag, int array[], int size) {
-    int count = 0, buf_size = 200;
-    char buf[buf_size];
-    memset(buf, '\0', buf_size*sizeof(char));
-
-    /* Using the standard logging function to store info. */
-    lib_log(f, tag, "Tracing an array, numbers are:\n");
-
-    /* Print blocks of 20 numbers into it and flush. */
-    for (int i = 0; i < size; ++i) {
-        count += snprintf(buf+count, buf_size-count, "%d ", array[i]);
-        if (i != 0 && (i % 20) == 0) {
-            count += snprintf(buf+count, buf_size-count, "\n");
-            lib_log(f, tag, buf);
-
-            count = 0;
-            memset(buf, '\0', buf_size*sizeof(char));
-        }
-    }
-
-    /* Final print if we still have stuff in the buffer. */
-    if (count != 0) {
-        count += snprintf(buf+count, buf_size-count, "\n");
-        lib_log(f, tag, buf);
-    }
+long lib_read_binary(const char *filename, void *vals, const size_t elem_size, const long offset, const long count) {
+    long read = 0;
+    FILE *f;
+
+    if ((f = fopen(filename, "rb")) == NULL)
+        lib_error("READ_BINARY: Failed to open file.");
+
+    if (fseek(f, offset * (long)elem_size, SEEK_SET) != 0)
+        lib_error("READ_BINARY: Failed to seek to offset.");
+
+    read = fread(vals, elem_size, count, f);
+    if (ferror(f))
+        lib_error("READ_BINARY: Failed to read.");
+
+    if (fclose(f) != 0)
+        lib_error("READ_BINARY: Failed to close properly.");
+
+    return read;
 }
+
+/*
+ * Write count elements of elem_size bytes to a binary file. If append is 0 the file is truncated first.
+ */
+void lib_write_binary(const char *filename, const void *vals, const size_t elem_size, const long count, const int append) {
+    FILE *f;
+
+    if ((f = fopen(filename, append ? "ab" : "wb")) == NULL)
+        lib_error("WRITE_BINARY: Failed to open file.");
+
+    if ((long)fwrite(vals, elem_size, count, f) != count)
+        lib_error("WRITE_BINARY: Failed to write.");
+
+    if (fclose(f) != 0)
+        lib_error("WRITE_BINARY: Failed to close properly.");
+}
+
@@ -11,9 +11,9 @@
 #define INPUT 			"input.txt"
 #define OUTPUT 			"output.txt"
 
-/* Log name, ensure it is sprinted with its rank. */
-#define LOG_FORMAT		"log.%d.txt"
-#define FILE_SIZE		15
+/* Binary input and per rank binary output for the out of core sort. */
+#define INPUT_BIN		"input.bin"
+#define OUTPUT_BIN		"output.%d.bin"
 
 /******************* Type Declarations ********************/
 
@@ -35,16 +35,19 @@ void lib_read_file(const char *filename, int *vals, const int size);
 void lib_write_file(const char *filename, const int *vals, const int size);
 
 /*
- * Simple logging function to log the status of buffers and other variables.
- * Each process has log for itself called log.rank.txt.
- * Format of log is: date - tag: mesg
+ * Number of elements of elem_size bytes in a binary file.
  */
-void lib_log(FILE *f, const char *tag, const char *mesg);
+long lib_count_binary(const char *filename, const size_t elem_size);
 
 /*
- * Tracing function, takes a buffer of adequate size and traces the values in array.
- * Prints the to the passed in files.
+ * Read count elements of elem_size bytes starting at element offset of a binary file into vals.
+ * Returns the number actually read, less than count only at end of file.
  */
-void lib_trace_array(FILE *f, char *tag, int array[], int size);
+long lib_read_binary(const char *filename, void *vals, const size_t elem_size, const long offset, const long count);
+
+/*
+ * Write count elements of elem_size bytes to a binary file. If append is 0 the file is truncated first.
+ */
+void lib_write_binary(const char *filename, const void *vals, const size_t elem_size, const long count, const int append);
 
 #endif /* _FILE_OPS_H_ */
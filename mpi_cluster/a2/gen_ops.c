@@ -0,0 +1,274 @@
+/**
+ * Synthetic input generation on every rank at once. The old lib_generate_numbers had root draw every
+ * value with rand() and write text before anything could start, generation was the slowest part of a run.
+ *
+ * Here a value is a pure function of (seed, global index): the index is hashed with splitmix64 into
+ * the bits for that element. Ranks generate their shares independently, the input is identical for
+ * any number of ranks, and a rank can regenerate any slice later without storing it.
+ *
+ * Zipf uses rejection-inversion sampling (Hormann & Derflinger 1996), constant expected time per value
+ * and no table, so it works for any number of distinct values.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Keys generated at a time by lib_gen_fill_kv64. */
+#define GEN_KEY_BUFFER      1024
+
+/******************* Type Definitions *********************/
+/* Constants of the zipf rejection-inversion sampler, depend only on unique and zipf_s. */
+typedef struct zipf_s {
+    double n; /* Number of distinct values. */
+    double s; /* Exponent. */
+    double h_x1; /* H(1.5) - 1, lower end of the inverted area. */
+    double h_n; /* H(n + 0.5), upper end. */
+    double cut; /* Accept without the second test when k - x is below this. */
+} zipf_t;
+
+/**************** Static Data Definitions *****************/
+/* Command line names of each distribution, same order as gen_dist_t. */
+static const char *gen_names[] = {"uniform", "range", "sorted", "reverse", "few", "zipf", "skew"};
+
+/****************** Static Functions **********************/
+/*
+ * Value in [0, bound) from the top 32 bits of r, multiply and shift instead of a modulo.
+ */
+static int gen_bounded(const uint64_t r, const uint64_t bound) {
+    return (int)(((r >> 32) * bound) >> 32);
+}
+
+/*
+ * Uniform double in (0, 1) from the top 53 bits of r.
+ */
+static double gen_unit(const uint64_t r) {
+    return ((r >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * log1p(x)/x and expm1(x)/x, with series near 0 where the division loses all precision.
+ */
+static double zipf_helper1(const double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0/3 - 0.25*x));
+}
+
+static double zipf_helper2(const double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x/2 * (1 + x/3 * (1 + x/4));
+}
+
+/*
+ * Density h(x) = x^-s, its integral H and the inverse of H.
+ */
+static double zipf_h(const zipf_t *z, const double x) {
+    return exp(-z->s * log(x));
+}
+
+static double zipf_hint(const zipf_t *z, const double x) {
+    double log_x = log(x);
+
+    return zipf_helper2((1 - z->s) * log_x) * log_x;
+}
+
+static double zipf_hinv(const zipf_t *z, const double x) {
+    double t = x * (1 - z->s);
+
+    if (t < -1)
+        t = -1;
+    return exp(zipf_helper1(t) * x);
+}
+
+/*
+ * Precompute the sampler constants for n distinct values.
+ */
+static void zipf_init(zipf_t *z, const int n, const double s) {
+    if (n < 1 || s <= 0)
+        lib_error("GEN: Zipf needs at least one value and a positive exponent.");
+
+    z->n = n;
+    z->s = s;
+    z->h_x1 = zipf_hint(z, 1.5) - 1;
+    z->h_n = zipf_hint(z, n + 0.5);
+    z->cut = 2 - zipf_hinv(z, zipf_hint(z, 2.5) - zipf_h(z, 2));
+}
+
+/*
+ * Draw k in [1, n] for the index at state. The first try mixes state like the other distributions, rejections
+ * go on along a stream seeded by that draw, stepping state itself would reuse the next index's draw.
+ */
+static int zipf_sample(const zipf_t *z, const uint64_t state) {
+    uint64_t r = lib_mix64(state), retry = r;
+    double u = 0, x = 0, k = 0;
+
+    while (1) {
+        u = z->h_n + gen_unit(r) * (z->h_x1 - z->h_n);
+        x = zipf_hinv(z, u);
+        k = floor(x + 0.5);
+        if (k < 1)
+            k = 1;
+        else if (k > z->n)
+            k = z->n;
+        if (k - x <= z->cut || u >= zipf_hint(z, k + 0.5) - zipf_h(z, k))
+            return (int)k;
+
+        retry += MIX_GOLDEN;
+        r = lib_mix64(retry);
+    }
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Fill params with the defaults for dist: range MAX_VAL, GEN_UNIQUE values and GEN_ZIPF_S.
+ * Zipf defaults to range distinct values.
+ */
+void lib_gen_params(gen_params_t *params, const gen_dist_t dist, const uint64_t seed, const long total, const int world) {
+    params->dist = dist;
+    params->seed = seed;
+    params->total = total;
+    params->world = world;
+    params->range = MAX_VAL;
+    params->unique = dist == GEN_ZIPF ? MAX_VAL : GEN_UNIQUE;
+    params->zipf_s = GEN_ZIPF_S;
+}
+
+/*
+ * Distribution for a command line name: uniform, range, sorted, reverse, few, zipf or skew. Returns -1 if unknown.
+ */
+int lib_gen_parse(const char *name) {
+    for (int i = 0; i < (int)(sizeof(gen_names) / sizeof(gen_names[0])); ++i) {
+        if (strcmp(name, gen_names[i]) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Even split of total elements, rank gets count elements starting at global index offset.
+ */
+void lib_gen_share(const long total, const int rank, const int world, long *offset, long *count) {
+    long per = total / world, extra = total % world;
+
+    /* First extra ranks take one more. */
+    *offset = rank * per + (rank < extra ? rank : extra);
+    *count = per + (rank < extra);
+}
+
+/*
+ * Generate the count elements starting at global index offset into vals.
+ * Each value depends only on the seed and its index, so any rank can generate any part of the input
+ * without communication and the result does not change with the number of ranks.
+ */
+void lib_gen_fill(const gen_params_t *params, int vals[], const long offset, const long count) {
+    const uint64_t base = lib_mix64(params->seed);
+    const int range = params->range, unique = params->unique;
+    const double step = params->total > 0 ? (double)range / params->total : 0;
+    zipf_t zipf;
+    long index = 0, slice = 0;
+    uint64_t state = 0;
+
+    if (params->dist != GEN_UNIFORM && range < 1)
+        lib_error("GEN: Range must be at least 1.");
+    if ((params->dist == GEN_FEW_UNIQUE || params->dist == GEN_ZIPF) && (unique < 1 || unique > range))
+        lib_error("GEN: Unique values must be between 1 and range.");
+    if (params->dist == GEN_ZIPF)
+        zipf_init(&zipf, unique, params->zipf_s);
+
+    for (long i = 0; i < count; ++i) {
+        index = offset + i;
+        state = base + (uint64_t)index * MIX_GOLDEN;
+
+        switch (params->dist) {
+        case GEN_UNIFORM:
+            vals[i] = (int)(uint32_t)lib_mix64(state);
+            break;
+        case GEN_RANGE:
+            vals[i] = gen_bounded(lib_mix64(state), range);
+            break;
+        case GEN_SORTED:
+            vals[i] = (int)(index * step);
+            break;
+        case GEN_REVERSE:
+            vals[i] = range - 1 - (int)(index * step);
+            break;
+        case GEN_FEW_UNIQUE:
+            /* Spread the few values over the range so pivots still see distinct keys. */
+            vals[i] = gen_bounded(lib_mix64(state), unique) * (range / unique);
+            break;
+        case GEN_ZIPF:
+            vals[i] = (zipf_sample(&zipf, state) - 1) * (range / unique);
+            break;
+        case GEN_SKEWED:
+            slice = params->total > 0 ? index * params->world / params->total : 0;
+            vals[i] = gen_bounded(lib_mix64(state), ((long)range * (slice + 1)) / params->world);
+            break;
+        default:
+            lib_error("GEN: Unknown distribution.");
+        }
+    }
+}
+
+/*
+ * Generate the same keys as lib_gen_fill as records, each with its global index as payload.
+ */
+void lib_gen_fill_kv64(const gen_params_t *params, kv64_t vals[], const long offset, const long count) {
+    int keys[GEN_KEY_BUFFER], size = 0;
+
+    /* Through a small buffer of keys, no second array the size of vals. */
+    for (long done = 0; done < count; done += size) {
+        size = count - done < GEN_KEY_BUFFER ? (int)(count - done) : GEN_KEY_BUFFER;
+        lib_gen_fill(params, keys, offset + done, size);
+        for (int i = 0; i < size; ++i) {
+            vals[done + i].key = keys[i];
+            vals[done + i].payload = offset + done + i;
+        }
+    }
+}
+
+/*
+ * Every rank of comm generates its share of the input and writes it to its place in a binary file of ints
+ * with collective MPI-IO, GEN_CHUNK ints at a time.
+ */
+void lib_gen_write(MPI_Comm comm, const char *filename, const gen_params_t *params) {
+    MPI_File fh;
+    MPI_Status status;
+    int id = 0, world = 0, size = 0, *chunk = NULL;
+    long offset = 0, count = 0, rounds = 0, done = 0;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+    lib_gen_share(params->total, id, world, &offset, &count);
+
+    chunk = malloc(GEN_CHUNK * sizeof(int));
+    if (chunk == NULL)
+        lib_error("GEN: Can't allocate chunk on heap.");
+
+    /* Truncate any older, longer input first. */
+    if (MPI_File_open(comm, (char *)filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+        lib_error("GEN: Failed to open file.");
+    MPI_File_set_size(fh, params->total * (MPI_Offset)sizeof(int));
+
+    /* Write is collective, every rank makes the same number of calls even with nothing left. */
+    rounds = (params->total / world + 1 + GEN_CHUNK - 1) / GEN_CHUNK;
+    for (long r = 0; r < rounds; ++r) {
+        size = count - done < GEN_CHUNK ? count - done : GEN_CHUNK;
+        lib_gen_fill(params, chunk, offset + done, size);
+        MPI_File_write_at_all(fh, (offset + done) * (MPI_Offset)sizeof(int), chunk, size, MPI_INT, &status);
+        done += size;
+    }
+
+    MPI_File_close(&fh);
+    free(chunk);
+}
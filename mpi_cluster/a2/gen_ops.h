@@ -0,0 +1,80 @@
+#ifndef _GEN_OPS_H_
+#define _GEN_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "typed_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Seed used when none is given, same seed means same input on any number of tasks. */
+#define GEN_SEED            428
+/* Distinct values for the few unique distribution. */
+#define GEN_UNIQUE          16
+/* Zipf exponent, 1 is the classic word frequency skew. */
+#define GEN_ZIPF_S          1.0
+/* Ints generated per rank before each collective write. */
+#define GEN_CHUNK           (1 << 20)
+
+/******************* Type Declarations ********************/
+/* Workload distributions to benchmark against, names for the command line are in lib_gen_parse. */
+typedef enum gen_dist_e {
+    GEN_UNIFORM, /* Uniform over the full 32 bit range, negatives included. */
+    GEN_RANGE, /* Uniform over [0, range), the old lib_generate_numbers input. */
+    GEN_SORTED, /* Already sorted increasing across the whole input. */
+    GEN_REVERSE, /* Sorted decreasing across the whole input. */
+    GEN_FEW_UNIQUE, /* Only unique distinct values, heavy duplicates. */
+    GEN_ZIPF, /* Zipf over unique values with exponent zipf_s, value 0 is the most frequent. */
+    GEN_SKEWED /* Slice k of world draws from [0, range*(k+1)/world), low values dominate. */
+} gen_dist_t;
+
+/* Everything needed to generate any element of the input from its global index. */
+typedef struct gen_params_s {
+    gen_dist_t dist; /* Distribution to draw from. */
+    uint64_t seed; /* Base seed, each index gets its own stream derived from it. */
+    long total; /* Elements in the whole input across all ranks. */
+    int world; /* Number of slices for the skewed distribution. */
+    int range; /* Upper bound (exclusive) of values for all but uniform. */
+    int unique; /* Distinct values for few unique and zipf. */
+    double zipf_s; /* Zipf exponent, must be positive. */
+} gen_params_t;
+
+/********************** Prototypes ************************/
+/*
+ * Fill params with the defaults for dist: range MAX_VAL, GEN_UNIQUE values and GEN_ZIPF_S.
+ * Zipf defaults to range distinct values.
+ */
+void lib_gen_params(gen_params_t *params, const gen_dist_t dist, const uint64_t seed, const long total, const int world);
+
+/*
+ * Distribution for a command line name: uniform, range, sorted, reverse, few, zipf or skew. Returns -1 if unknown.
+ */
+int lib_gen_parse(const char *name);
+
+/*
+ * Even split of total elements, rank gets count elements starting at global index offset.
+ */
+void lib_gen_share(const long total, const int rank, const int world, long *offset, long *count);
+
+/*
+ * Generate the count elements starting at global index offset into vals.
+ * Each value depends only on the seed and its index, so any rank can generate any part of the input
+ * without communication and the result does not change with the number of ranks.
+ */
+void lib_gen_fill(const gen_params_t *params, int vals[], const long offset, const long count);
+
+/*
+ * Generate the same keys as lib_gen_fill as records, each with its global index as payload.
+ */
+void lib_gen_fill_kv64(const gen_params_t *params, kv64_t vals[], const long offset, const long count);
+
+/*
+ * Every rank of comm generates its share of the input and writes it to its place in a binary file of ints
+ * with collective MPI-IO, GEN_CHUNK ints at a time.
+ */
+void lib_gen_write(MPI_Comm comm, const char *filename, const gen_params_t *params);
+
+#endif /* _GEN_OPS_H_ */
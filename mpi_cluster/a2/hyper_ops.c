@@ -0,0 +1,138 @@
+/**
+ * Hypercube quicksort as a library call. The executables read a text file, sort and write another one, a job
+ * that already holds its data in memory would have to round trip through text. lib_hyper_sort sorts the
+ * caller's buffer where it is, on the caller's communicator.
+ *
+ * The hypercube leaves every rank with however many keys fell in its range. The caller's buffer can't grow,
+ * so a last pass (lib_dist_place in dist_ops.c, what lib_equalize uses) moves the sorted keys point to point
+ * until each rank again holds its own n, straight into buf. Ranks past the cube are folded onto it with
+ * lib_dist_fold like the sort driver's.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "typed_ops.h"
+#include "dist_ops.h"
+#include "hyper_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Hypercube quicksort and local sort with the suffix S functions, local holds T for element type E. */
+#define HYPER_SORT_CASE(E, S, T) \
+    case E: { \
+        T *typed = (T *)local; \
+        if (dimension > 0) \
+            lib_hyper_quicksort_##S(cube_comm, dimension, &typed, &local_size); \
+        lib_sort_##S(typed, local_size); \
+        local = typed; \
+        break; \
+    }
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * MPI datatype of one element of type.
+ */
+static MPI_Datatype hyper_mpi_type(const hyper_type_t type) {
+    switch (type) {
+    case HYPER_I32: return lib_mpi_type_i32();
+    case HYPER_I64: return lib_mpi_type_i64();
+    case HYPER_U64: return lib_mpi_type_u64();
+    case HYPER_F64: return lib_mpi_type_f64();
+    case HYPER_KV64: return lib_mpi_type_kv64();
+    default: lib_error("HYPER: Unknown element type.");
+    }
+
+    return MPI_DATATYPE_NULL;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Size in bytes of one element of type.
+ */
+size_t lib_hyper_elem_size(const hyper_type_t type) {
+    switch (type) {
+    case HYPER_I32: return sizeof(int32_t);
+    case HYPER_I64: return sizeof(int64_t);
+    case HYPER_U64: return sizeof(uint64_t);
+    case HYPER_F64: return sizeof(double);
+    case HYPER_KV64: return sizeof(kv64_t);
+    default: lib_error("HYPER: Unknown element type.");
+    }
+
+    return 0;
+}
+
+/*
+ * Sort the n elements of buf on every rank of comm together, in memory and in place. Afterwards buf still holds
+ * n elements on each rank, this rank's shard of the sorted whole: every key at most those of higher ranks, with
+ * the ranks' n the same as before. Any communicator and any number of ranks, those past the largest power of two
+ * fold their elements onto the cube for the hypercube quicksort (lib_hyper_quicksort_S), which runs on its own
+ * duplicate of comm so the caller's messages are never matched. No file I/O. Collective over comm.
+ */
+void lib_hyper_sort(MPI_Comm comm, void *buf, const size_t n, const hyper_type_t type) {
+    MPI_Comm own, cube_comm;
+    MPI_Datatype elem = hyper_mpi_type(type);
+    const size_t elem_size = lib_hyper_elem_size(type);
+    int id = 0, world = 0, cube = 1, dimension = 0, local_size = (int)n, *targets = NULL, *sizes = NULL;
+    void *local = NULL;
+
+    if (n > INT_MAX)
+        lib_error("HYPER: More elements on a rank than an MPI count holds.");
+
+    MPI_Comm_dup(comm, &own);
+    MPI_Comm_rank(own, &id);
+    MPI_Comm_size(own, &world);
+    while (cube * 2 <= world) {
+        cube *= 2;
+        ++dimension;
+    }
+
+    targets = (int *)malloc(2 * world * sizeof(int));
+    if (targets == NULL)
+        lib_error("HYPER: Can't allocate counts on heap.");
+    sizes = targets + world;
+    MPI_Allgather(&local_size, 1, MPI_INT, targets, 1, MPI_INT, own);
+
+    /* The typed sorts grow and replace local, so it's a copy. Ranks past the cube hand it on and sit out. */
+    if ((local = malloc((local_size > 0 ? local_size : 1) * elem_size)) == NULL)
+        lib_error("HYPER: Can't allocate local on heap.");
+    memcpy(local, buf, local_size * elem_size);
+    local = lib_dist_fold(own, cube, elem, elem_size, local, &local_size);
+
+    MPI_Comm_split(own, id < cube ? 0 : MPI_UNDEFINED, id, &cube_comm);
+    if (id < cube) {
+        switch (type) {
+        HYPER_SORT_CASE(HYPER_I32, i32, int32_t)
+        HYPER_SORT_CASE(HYPER_I64, i64, int64_t)
+        HYPER_SORT_CASE(HYPER_U64, u64, uint64_t)
+        HYPER_SORT_CASE(HYPER_F64, f64, double)
+        HYPER_SORT_CASE(HYPER_KV64, kv64, kv64_t)
+        default: lib_error("HYPER: Unknown element type.");
+        }
+        MPI_Comm_free(&cube_comm);
+    }
+
+    /* Back to the caller's counts, straight into buf. */
+    MPI_Allgather(&local_size, 1, MPI_INT, sizes, 1, MPI_INT, own);
+    lib_dist_place(own, elem, elem_size, local, sizes, targets, buf);
+
+    free(local);
+    free(targets);
+    MPI_Comm_free(&own);
+}
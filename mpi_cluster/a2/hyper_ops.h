@@ -0,0 +1,40 @@
+#ifndef _HYPER_OPS_H_
+#define _HYPER_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stddef.h>
+
+/* Project Headers */
+#include "mpi.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Declarations ********************/
+/* Element types lib_hyper_sort takes, each backed by the typed_ops.h functions of the same suffix. */
+typedef enum hyper_type_e {
+    HYPER_I32, /* int32_t. */
+    HYPER_I64, /* int64_t. */
+    HYPER_U64, /* uint64_t. */
+    HYPER_F64, /* double, NaNs have no place in the order. */
+    HYPER_KV64, /* kv64_t, ordered on the key, the payload moves with it. */
+    HYPER_TYPES /* Number of types, not a type. */
+} hyper_type_t;
+
+/********************** Prototypes ************************/
+/*
+ * Size in bytes of one element of type.
+ */
+size_t lib_hyper_elem_size(const hyper_type_t type);
+
+/*
+ * Sort the n elements of buf on every rank of comm together, in memory and in place. Afterwards buf still holds
+ * n elements on each rank, this rank's shard of the sorted whole: every key at most those of higher ranks, with
+ * the ranks' n the same as before. Any communicator and any number of ranks, those past the largest power of two
+ * fold their elements onto the cube for the hypercube quicksort (lib_hyper_quicksort_S), which runs on its own
+ * duplicate of comm so the caller's messages are never matched. No file I/O. Collective over comm.
+ */
+void lib_hyper_sort(MPI_Comm comm, void *buf, const size_t n, const hyper_type_t type);
+
+#endif /* _HYPER_OPS_H_ */
@@ -0,0 +1,122 @@
+/**
+ * Distributed sort-merge equi join of two record sets on their 64 bit keys.
+ *
+ * Both sides go through the same splitters so a key and all of its matches meet on one rank, each rank
+ * sorts what it got and a linear merge finds the matches, so the join runs in parallel and neither input
+ * is ever held whole by one rank. The matches go straight from every rank into one file with lib_dist_write.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "typed_ops.h"
+#include "dist_ops.h"
+#include "join_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+/*
+ * Take count evenly spaced keys of the sorted vals into sample.
+ */
+static void join_sample(const kv64_t vals[], const int size, const int count, int64_t sample[]) {
+    for (int i = 0; i < count; ++i)
+        sample[i] = vals[(long)(2*i + 1) * size / (2*count)].key;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Co-partition two record sets over comm for a join. Both sides are cut at the same splitters, picked from
+ * regular samples of both, and delivered with one MPI_Alltoallv each, so every key lands on one rank with all
+ * its matches from the other side. Afterwards each side is sorted by key on every rank and the ranks are
+ * in key order. Left and right are replaced. Collective over comm.
+ */
+void lib_join_partition(MPI_Comm comm, kv64_t *left[], int *left_size, kv64_t *right[], int *right_size) {
+    int world = 0, taken = 0, count = 0;
+    int64_t sample[2 * JOIN_OVERSAMPLE], *splitters = NULL;
+
+    MPI_Comm_size(comm, &world);
+    if ((splitters = (int64_t *)malloc(world * sizeof(int64_t))) == NULL)
+        lib_error("JOIN: Can't allocate splitters on heap.");
+
+    /* Regular samples of both sorted sides. */
+    lib_sort_kv64(*left, *left_size);
+    lib_sort_kv64(*right, *right_size);
+    taken = *left_size < JOIN_OVERSAMPLE ? *left_size : JOIN_OVERSAMPLE;
+    count = *right_size < JOIN_OVERSAMPLE ? *right_size : JOIN_OVERSAMPLE;
+    join_sample(*left, *left_size, taken, sample);
+    join_sample(*right, *right_size, count, sample + taken);
+    lib_key_splitters(comm, sample, taken + count, splitters);
+
+    /* Received runs are sorted per sender only. */
+    lib_key_exchange(comm, splitters, lib_mpi_type_kv64(), sizeof(kv64_t), (void **)left, left_size);
+    lib_key_exchange(comm, splitters, lib_mpi_type_kv64(), sizeof(kv64_t), (void **)right, right_size);
+    lib_sort_kv64(*left, *left_size);
+    lib_sort_kv64(*right, *right_size);
+
+    free(splitters);
+}
+
+/*
+ * Merge join of two key sorted record arrays, one row per pair of records with equal keys, in key order.
+ * Out is malloced to fit and must be freed. Returns the number of rows.
+ */
+long lib_merge_join(const kv64_t left[], const int left_size, const kv64_t right[], const int right_size,
+        join_row_t *out[]) {
+    long rows = 0, n = 0;
+    int a = 0, b = 0, a_end = 0, b_end = 0;
+
+    /* First pass counts, the output of duplicate keys is a cross product and can be far larger than either. */
+    for (int pass = 0; pass < 2; ++pass) {
+        a = b = 0;
+        n = 0;
+        while (a < left_size && b < right_size) {
+            if (left[a].key < right[b].key) {
+                ++a;
+            } else if (left[a].key > right[b].key) {
+                ++b;
+            } else {
+                for (a_end = a; a_end < left_size && left[a_end].key == left[a].key; ++a_end)
+                    continue;
+                for (b_end = b; b_end < right_size && right[b_end].key == right[b].key; ++b_end)
+                    continue;
+                for (int i = a; pass == 1 && i < a_end; ++i) {
+                    for (int j = b; j < b_end; ++j) {
+                        (*out)[n].key = left[i].key;
+                        (*out)[n].left = left[i].payload;
+                        (*out)[n].right = right[j].payload;
+                        ++n;
+                    }
+                }
+                if (pass == 0)
+                    n += (long)(a_end - a) * (b_end - b);
+                a = a_end;
+                b = b_end;
+            }
+        }
+
+        if (pass == 0) {
+            rows = n;
+            if ((*out = (join_row_t *)malloc((rows > 0 ? rows : 1) * sizeof(join_row_t))) == NULL)
+                lib_error("JOIN: Can't allocate rows on heap.");
+        }
+    }
+
+    return rows;
+}
@@ -0,0 +1,42 @@
+#ifndef _JOIN_OPS_H_
+#define _JOIN_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "typed_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Output of qJoin, one join_row_t per match. */
+#define JOIN_OUTPUT         "join.bin"
+/* Key samples each rank takes from each side to pick the shared splitters. */
+#define JOIN_OVERSAMPLE     32
+
+/******************* Type Declarations ********************/
+/* One match of an equi join, the key and the payload of the row from each side. */
+typedef struct join_row_s {
+    int64_t key;
+    int64_t left;
+    int64_t right;
+} join_row_t;
+
+/********************** Prototypes ************************/
+/*
+ * Co-partition two record sets over comm for a join. Both sides are cut at the same splitters, picked from
+ * regular samples of both, and delivered with one MPI_Alltoallv each, so every key lands on one rank with all
+ * its matches from the other side. Afterwards each side is sorted by key on every rank and the ranks are
+ * in key order. Left and right are replaced. Collective over comm.
+ */
+void lib_join_partition(MPI_Comm comm, kv64_t *left[], int *left_size, kv64_t *right[], int *right_size);
+
+/*
+ * Merge join of two key sorted record arrays, one row per pair of records with equal keys, in key order.
+ * Out is malloced to fit and must be freed. Returns the number of rows.
+ */
+long lib_merge_join(const kv64_t left[], const int left_size, const kv64_t right[], const int right_size,
+        join_row_t *out[]);
+
+#endif /* _JOIN_OPS_H_ */
@@ -0,0 +1,174 @@
+/**
+ * Built in phase timing for the sorts. A run lays its phases end to end with lib_prof_lap, each lap charges
+ * the time since the previous one to a phase, so the phases add up to the whole run with one MPI_Wtime call
+ * per boundary. Hypercube phases are also kept per round together with the bytes moved in that round.
+ *
+ * At exit every value is reduced to min, max and mean across the ranks and root writes a json report.
+ * Max against mean shows load imbalance, a phase whose max grows with the rank count shows where scaling breaks.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "prof_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Round phases are the contiguous block of the enum. */
+#define PROF_ROUND_FIRST    PROF_PIVOT_SELECT
+#define PROF_ROUND_LAST     PROF_UNION
+#define PROF_ROUND_PHASES   (PROF_ROUND_LAST - PROF_ROUND_FIRST + 1)
+
+/* Values reduced: each phase, the total, then per round its phases, bytes and wire bytes. */
+#define PROF_ROUND_VALS     (PROF_ROUND_PHASES + 2)
+#define PROF_VALS           (PROF_PHASES + 1 + PROF_MAX_ROUNDS * PROF_ROUND_VALS)
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+/* Json names of each phase, same order as prof_phase_t. */
+static const char *prof_names[PROF_PHASES] = {
+    "read", "generate", "scatter", "pivot_select", "pivot_bcast", "partition",
+    "exchange", "union", "local_sort", "gather", "write", "verify"
+};
+
+/* Time per round and phase, phases outside rounds always use round 0. */
+static double prof_times[PROF_MAX_ROUNDS][PROF_PHASES];
+static long prof_bytes[PROF_MAX_ROUNDS], prof_wire[PROF_MAX_ROUNDS];
+static double prof_start, prof_mark;
+static int prof_cur_round, prof_rounds;
+
+/****************** Static Functions **********************/
+/*
+ * Write one min/max/mean object for value i of the reduced arrays.
+ */
+static void prof_write_stat(FILE *f, const char *name, const double *min, const double *max,
+        const double *sum, const int i, const int world) {
+    fprintf(f, "\"%s\": {\"min\": %.9f, \"max\": %.9f, \"mean\": %.9f}", name, min[i], max[i], sum[i] / world);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Clear all timings and counters and start the clock for the first phase.
+ */
+void lib_prof_init(void) {
+    memset(prof_times, 0, sizeof(prof_times));
+    memset(prof_bytes, 0, sizeof(prof_bytes));
+    memset(prof_wire, 0, sizeof(prof_wire));
+    prof_cur_round = 0;
+    prof_rounds = 0;
+    prof_start = prof_mark = MPI_Wtime();
+}
+
+/*
+ * Charge the time since the last lap (or init) to phase, in the current round for round phases.
+ */
+void lib_prof_lap(const prof_phase_t phase) {
+    double now = MPI_Wtime();
+    int round = phase >= PROF_ROUND_FIRST && phase <= PROF_ROUND_LAST ? prof_cur_round : 0;
+
+    prof_times[round][phase] += now - prof_mark;
+    prof_mark = now;
+}
+
+/*
+ * Following round phases and bytes are recorded against round, counting from 0.
+ */
+void lib_prof_round(const int round) {
+    prof_cur_round = round < PROF_MAX_ROUNDS ? round : PROF_MAX_ROUNDS-1;
+    if (prof_cur_round >= prof_rounds)
+        prof_rounds = prof_cur_round + 1;
+}
+
+/*
+ * Add bytes sent plus received to the current round, wire is what actually went over the transport
+ * for them after any compression.
+ */
+void lib_prof_bytes(const long bytes, const long wire) {
+    prof_bytes[prof_cur_round] += bytes;
+    prof_wire[prof_cur_round] += wire;
+}
+
+/*
+ * Time charged to phase so far on this rank, summed over rounds.
+ */
+double lib_prof_time(const prof_phase_t phase) {
+    double time = 0;
+
+    for (int r = 0; r < PROF_MAX_ROUNDS; ++r)
+        time += prof_times[r][phase];
+
+    return time;
+}
+
+/*
+ * Reduce every phase and round to min, max and mean over the ranks of comm and have root write
+ * them to filename as json, program names the run. Collective over comm.
+ */
+void lib_prof_report(MPI_Comm comm, const char *filename, const char *program) {
+    double vals[PROF_VALS], min[PROF_VALS], max[PROF_VALS], sum[PROF_VALS];
+    int id = 0, world = 0, rounds = 0, base = 0;
+    FILE *f;
+
+    MPI_Comm_rank(comm, &id);
+    MPI_Comm_size(comm, &world);
+
+    /* Flatten, totals over rounds first then each round on its own. */
+    for (int p = 0; p < PROF_PHASES; ++p)
+        vals[p] = lib_prof_time(p);
+    vals[PROF_PHASES] = MPI_Wtime() - prof_start;
+    for (int r = 0; r < PROF_MAX_ROUNDS; ++r) {
+        base = PROF_PHASES + 1 + r * PROF_ROUND_VALS;
+        for (int p = 0; p < PROF_ROUND_PHASES; ++p)
+            vals[base + p] = prof_times[r][PROF_ROUND_FIRST + p];
+        vals[base + PROF_ROUND_PHASES] = prof_bytes[r];
+        vals[base + PROF_ROUND_PHASES + 1] = prof_wire[r];
+    }
+
+    MPI_Reduce(vals, min, PROF_VALS, MPI_DOUBLE, MPI_MIN, ROOT, comm);
+    MPI_Reduce(vals, max, PROF_VALS, MPI_DOUBLE, MPI_MAX, ROOT, comm);
+    MPI_Reduce(vals, sum, PROF_VALS, MPI_DOUBLE, MPI_SUM, ROOT, comm);
+    MPI_Reduce(&prof_rounds, &rounds, 1, MPI_INT, MPI_MAX, ROOT, comm);
+
+    if (id != ROOT)
+        return;
+
+    if ((f = fopen(filename, "w")) == NULL)
+        lib_error("PROF: Could not open report file.");
+
+    fprintf(f, "{\n  \"program\": \"%s\",\n  \"ranks\": %d,\n  \"rounds\": %d,\n  ", program, world, rounds);
+    prof_write_stat(f, "total", min, max, sum, PROF_PHASES, world);
+    fprintf(f, ",\n  \"phases\": {\n");
+    for (int p = 0; p < PROF_PHASES; ++p) {
+        fprintf(f, "    ");
+        prof_write_stat(f, prof_names[p], min, max, sum, p, world);
+        fprintf(f, p < PROF_PHASES-1 ? ",\n" : "\n");
+    }
+    fprintf(f, "  },\n  \"per_round\": [\n");
+    for (int r = 0; r < rounds; ++r) {
+        base = PROF_PHASES + 1 + r * PROF_ROUND_VALS;
+        fprintf(f, "    {\"round\": %d", r);
+        for (int p = 0; p < PROF_ROUND_PHASES; ++p) {
+            fprintf(f, ", ");
+            prof_write_stat(f, prof_names[PROF_ROUND_FIRST + p], min, max, sum, base + p, world);
+        }
+        fprintf(f, ", ");
+        prof_write_stat(f, "bytes", min, max, sum, base + PROF_ROUND_PHASES, world);
+        fprintf(f, ", ");
+        prof_write_stat(f, "wire", min, max, sum, base + PROF_ROUND_PHASES + 1, world);
+        fprintf(f, r < rounds-1 ? "},\n" : "}\n");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    if (fclose(f) != 0)
+        lib_error("PROF: Failed to close report file.");
+}
@@ -0,0 +1,67 @@
+#ifndef _PROF_OPS_H_
+#define _PROF_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+
+/* Project Headers */
+#include "mpi.h"
+
+/******************* Constants/Macros *********************/
+/* Default name of the json report. */
+#define PROF_REPORT         "profile.json"
+/* Most hypercube or exchange rounds recorded, later rounds add to the last one. */
+#define PROF_MAX_ROUNDS     16
+
+/******************* Type Declarations ********************/
+/* Phases of a sort. Phases from PROF_PIVOT_SELECT to PROF_UNION are recorded per round. */
+typedef enum prof_phase_e {
+    PROF_READ, /* Reading input from file. */
+    PROF_GENERATE, /* Generating input in memory instead of reading. */
+    PROF_SCATTER, /* Distributing input from root. */
+    PROF_PIVOT_SELECT, /* Choosing the pivot of a round. */
+    PROF_PIVOT_BCAST, /* Sending or waiting for the pivot. */
+    PROF_PARTITION, /* Splitting local around the pivot. */
+    PROF_EXCHANGE, /* Trading halves with the partner. */
+    PROF_UNION, /* Merging received values into local. */
+    PROF_LOCAL_SORT, /* Final sort of local. */
+    PROF_GATHER, /* Collecting the share sizes and then the sorted shares at root. */
+    PROF_WRITE, /* Writing output. */
+    PROF_VERIFY, /* Checking the output is a sorted permutation of the input. */
+    PROF_PHASES /* Number of phases, not a phase. */
+} prof_phase_t;
+
+/********************** Prototypes ************************/
+/*
+ * Clear all timings and counters and start the clock for the first phase.
+ */
+void lib_prof_init(void);
+
+/*
+ * Charge the time since the last lap (or init) to phase, in the current round for round phases.
+ */
+void lib_prof_lap(const prof_phase_t phase);
+
+/*
+ * Following round phases and bytes are recorded against round, counting from 0.
+ */
+void lib_prof_round(const int round);
+
+/*
+ * Add bytes sent plus received to the current round, wire is what actually went over the transport
+ * for them after any compression.
+ */
+void lib_prof_bytes(const long bytes, const long wire);
+
+/*
+ * Time charged to phase so far on this rank, summed over rounds.
+ */
+double lib_prof_time(const prof_phase_t phase);
+
+/*
+ * Reduce every phase and round to min, max and mean over the ranks of comm and have root write
+ * them to filename as json, program names the run. Collective over comm.
+ */
+void lib_prof_report(MPI_Comm comm, const char *filename, const char *program);
+
+#endif /* _PROF_OPS_H_ */
@@ -0,0 +1,183 @@
+/**
+ * Distributed aggregation of an input on integer keys: distinct keys, count per key, payload sum per key,
+ * or an estimated distinct count. Every key is grouped on one task (see agg_ops.c) and all tasks write
+ * their rows into one file at once, nothing is gathered on root.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qAggregate <agg> <input> <format>
+ *          or: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qAggregate <agg> gen <numbers> <dist> <seed>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works.
+ * agg: What to compute.
+ *      -> unique: Every distinct key once, in increasing order.
+ *      -> count: Every distinct key followed by how often it occurs.
+ *      -> sum: Every distinct key followed by the sum of its payloads.
+ *      -> approx: Only the estimated number of distinct keys from a HyperLogLog counter, about 1.6% error.
+ * input: Binary input file, each task reads its own slice.
+ * format: Optional layout of the input.
+ *      -> Omit for files of native ints like input.bin from qGenerate, a key's payload is its index in the file.
+ *      -> Use "kv" for files of kv64_t records, a 64 bit key followed by a 64 bit payload.
+ * numbers: With gen, amount of integers per task, each task generates its share in memory.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen.
+ *
+ * Output:
+ * aggregate.bin holds one 64 bit key per row for unique, a key and its count or sum for count and sum.
+ * Approx writes nothing.
+ *
+ * Example count per key of 10000000 generated zipf numbers per process, 8 process.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qAggregate count gen 10000000 zipf
+ *
+ * Root prints the number of distinct keys. Profile works as in qParallel, the grouping is the exchange.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "prof_ops.h"
+#include "typed_ops.h"
+#include "agg_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Format flag for inputs of key, payload records. */
+#define KV_FLAG             "kv"
+
+/******************* Type Definitions *********************/
+/* Aggregations on the command line, same order as agg_names. */
+typedef enum agg_mode_e {
+    AGG_UNIQUE,
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_APPROX,
+    AGG_MODES /* Number of modes, not a mode. */
+} agg_mode_t;
+
+/**************** Static Data Definitions *****************/
+/* Command line names of each aggregation. */
+static const char *agg_names[] = {"unique", "count", "sum", "approx"};
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Aggregation for a command line name, -1 if unknown.
+ */
+int parse_mode(const char *name) {
+    for (int m = 0; m < AGG_MODES; ++m)
+        if (strcmp(name, agg_names[m]) == 0)
+            return m;
+
+    return -1;
+}
+
+/*
+ * Lay the rows out as mode writes them, the key alone or the key and its count or sum. Returns the
+ * int64_t values in out, which must hold two per row.
+ */
+long format_rows(const agg_mode_t mode, const agg_row_t rows[], const int size, int64_t out[]) {
+    long n = 0;
+
+    for (int i = 0; i < size; ++i) {
+        out[n++] = rows[i].key;
+        if (mode == AGG_COUNT)
+            out[n++] = rows[i].count;
+        else if (mode == AGG_SUM)
+            out[n++] = rows[i].sum;
+    }
+
+    return n;
+}
+
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, mode = 0, dist = GEN_RANGE, size = 0, rows = 0;
+    kv64_t *vals = NULL;
+    agg_row_t *out = NULL;
+    int64_t *flat = NULL;
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    hll_t hll;
+    long offset = 0, share = 0, count = 0, distinct = 0;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank and size too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    lib_prof_init();
+
+    /* Protection from invalid use. */
+    if (argc < 3 || (mode = parse_mode(argv[1])) < 0)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+
+    /* Each task generates or reads its own share. */
+    if (strcmp(argv[2], GENERATE_FLAG) == 0) {
+        if (argc < 4)
+            lib_error("MAIN: Bad usage, see top of respective c file.");
+        if (argc >= 5 && (dist = lib_gen_parse(argv[4])) < 0)
+            lib_error("MAIN: Unknown distribution, see top of respective c file.");
+        if (argc >= 6)
+            seed = strtoull(argv[5], NULL, 10);
+        lib_gen_params(&params, dist, seed, atol(argv[3]) * world, world);
+        lib_gen_share(params.total, id, world, &offset, &share);
+        if ((vals = (kv64_t *)malloc((share > 0 ? share : 1) * sizeof(kv64_t))) == NULL)
+            lib_error("MAIN: Can't allocate vals array on heap.");
+        lib_gen_fill_kv64(&params, vals, offset, share);
+        size = (int)share;
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        size = lib_dist_read_kv64(MPI_COMM_WORLD, argv[2], argc < 4 || strcmp(argv[3], KV_FLAG) != 0, &vals);
+        lib_prof_lap(PROF_READ);
+    }
+
+    if (mode == AGG_APPROX) {
+        /* Estimate only, one small reduction and nothing written. */
+        lib_hll_init(&hll);
+        for (int i = 0; i < size; ++i)
+            lib_hll_add(&hll, vals[i].key);
+        lib_hll_allreduce(MPI_COMM_WORLD, &hll);
+        distinct = (long)(lib_hll_estimate(&hll) + 0.5);
+        lib_prof_lap(PROF_EXCHANGE);
+    } else {
+        rows = lib_aggregate(MPI_COMM_WORLD, vals, size, &out);
+        lib_prof_lap(PROF_EXCHANGE);
+
+        if ((flat = (int64_t *)malloc((rows > 0 ? 2 * (long)rows : 1) * sizeof(int64_t))) == NULL)
+            lib_error("MAIN: Can't allocate output array on heap.");
+        count = format_rows(mode, out, rows, flat);
+        lib_dist_write(MPI_COMM_WORLD, AGG_OUTPUT, flat, sizeof(int64_t), count);
+        lib_prof_lap(PROF_WRITE);
+        distinct = rows;
+        MPI_Allreduce(MPI_IN_PLACE, &distinct, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    }
+
+    if (id == ROOT) {
+        printf("%s %ld distinct keys.\n", mode == AGG_APPROX ? "About" : "Found", distinct);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+    }
+
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qAggregate");
+
+    free(vals);
+    free(out);
+    free(flat);
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * Out of core version of the parallel sort, for inputs many times larger than the cluster's memory.
+ * Input is a binary file of native ints instead of the csv text, it is far too slow to parse at that size.
+ * Each rank streams its share of the input through chunks of <memory> ints into sorted runs on scratch,
+ * then runs are merged and routed to their final rank in rounds that fit in the same budget.
+ * See extern_ops.c for the details.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qExternal <memory> <mode> <numbers> <scratch>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works.
+ * memory: Amount of integers each task may hold in memory at once.
+ * mode: Flag that optionally makes all tasks generate a new input.bin, see qGenerate.c for other distributions.
+ *      -> Use "gen" followed by the total amount of integers to generate a new input.
+ *      -> To read the existing input.bin, simply omit 'mode' and 'numbers'.
+ * scratch: Optional directory for run files, defaults to the current directory. Use local disk.
+ *
+ * Output:
+ * Every task writes its sorted shard to output.<rank>.bin, shards concatenated in rank order are sorted.
+ *
+ * Example generate 100 million numbers sorted by 8 tasks holding 1 million ints each.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qExternal 1000000 gen 100000000 /tmp
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "extern_ops.h"
+#include "gen_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, mem_ints = 0;
+    const char *scratch = ".";
+    gen_params_t params;
+    long written = 0, total = 0;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+    /* Protection from invalid use. */
+    if (argc < 2)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+    mem_ints = atoi(argv[1]);
+
+    /* Optional generate, then optional scratch directory. */
+    if (argc >= 4 && strcmp(argv[2], GENERATE_FLAG) == 0) {
+        lib_gen_params(&params, GEN_RANGE, GEN_SEED, atol(argv[3]), world);
+        lib_gen_write(MPI_COMM_WORLD, INPUT_BIN, &params);
+        if (argc >= 5)
+            scratch = argv[4];
+    } else if (argc >= 3) {
+        scratch = argv[2];
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    written = lib_ext_sort(MPI_COMM_WORLD, INPUT_BIN, OUTPUT_BIN, mem_ints, scratch);
+    MPI_Reduce(&written, &total, 1, MPI_LONG, MPI_SUM, ROOT, MPI_COMM_WORLD);
+
+    if (id == ROOT) {
+        printf("Sorted %ld integers out of core.\n", total);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
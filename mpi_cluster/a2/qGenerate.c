@@ -0,0 +1,85 @@
+/**
+ * Parallel input generator. Every task generates its own share of the input and writes it straight
+ * into input.bin with collective MPI-IO, so the time drops with the number of tasks instead of
+ * being bound by root's rand() and text formatting. See gen_ops.c for the distributions.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qGenerate <numbers> <dist> <seed>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works.
+ * numbers: Total amount of integers to generate.
+ * dist: Optional distribution, defaults to range.
+ *      -> uniform: Full 32 bit range, negatives included.
+ *      -> range: Between 0 and MAX_VAL, same as the old generator.
+ *      -> sorted, reverse: Increasing or decreasing over the whole file.
+ *      -> few: Only a handful of distinct values.
+ *      -> zipf: Zipf distributed, small values far more frequent.
+ *      -> skew: Values drawn from a range that grows with position, low values dominate.
+ * seed: Optional seed, the same seed always gives the same file whatever the number of tasks.
+ *
+ * Example generate 1 billion zipf numbers with 8 tasks, then sort them out of core.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qGenerate 1000000000 zipf
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qExternal 10000000 /tmp
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+
+/******************* Constants/Macros *********************/
+
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, dist = GEN_RANGE;
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank and size too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+    /* Protection from invalid use. */
+    if (argc < 2)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+    if (argc >= 3 && (dist = lib_gen_parse(argv[2])) < 0)
+        lib_error("MAIN: Unknown distribution, see top of respective c file.");
+    if (argc >= 4)
+        seed = strtoull(argv[3], NULL, 10);
+
+    lib_gen_params(&params, dist, seed, atol(argv[1]), world);
+    lib_gen_write(MPI_COMM_WORLD, INPUT_BIN, &params);
+
+    if (id == ROOT) {
+        printf("Generated %ld integers into %s.\n", params.total, INPUT_BIN);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
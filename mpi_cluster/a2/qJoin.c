@@ -0,0 +1,140 @@
+/**
+ * Distributed sort-merge join of two inputs on integer keys. Both sides are cut at the same splitters so
+ * every key meets all of its matches on one task, each task sorts both sides and merges out the matches,
+ * then all tasks write their matches into one file at once. See join_ops.c for the details.
+ * Neither input nor the result ever goes through root.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qJoin <left> <right> <format>
+ *          or: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qJoin gen <numbers> <dist> <seed>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works.
+ * left, right: Binary input files, each task reads its own slice of both.
+ * format: Optional layout of the inputs.
+ *      -> Omit for files of native ints like input.bin from qGenerate, a key's payload is its index in the file.
+ *      -> Use "kv" for files of kv64_t records, a 64 bit key followed by a 64 bit payload.
+ * numbers: With gen, amount of integers per task on each side, each task generates its share in memory.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen, the right side uses seed+1.
+ *
+ * Output:
+ * join.bin holds one join_row_t (key, left payload, right payload) per match, in key order.
+ *
+ * Example join two generated sides of 10000000 uniform keys per process, 8 process. Mind the other
+ * distributions, they draw from few keys and their match count grows with the square of the input.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qJoin gen 10000000 uniform
+ *
+ * Root prints the number of matches. Profile works as in qParallel, the co-partition is the exchange.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "prof_ops.h"
+#include "typed_ops.h"
+#include "join_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Format flag for inputs of key, payload records. */
+#define KV_FLAG             "kv"
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Generate this task's share of one side into a malloced record array, payload is the global index.
+ */
+int generate_side(const gen_params_t *params, const int id, const int world, kv64_t *side[]) {
+    long offset = 0, count = 0;
+
+    lib_gen_share(params->total, id, world, &offset, &count);
+    if ((*side = (kv64_t *)malloc((count > 0 ? count : 1) * sizeof(kv64_t))) == NULL)
+        lib_error("MAIN: Can't allocate side array on heap.");
+    lib_gen_fill_kv64(params, *side, offset, count);
+
+    return (int)count;
+}
+
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, dist = GEN_RANGE, left_size = 0, right_size = 0, keys_only = 1;
+    kv64_t *left = NULL, *right = NULL;
+    join_row_t *rows = NULL;
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    long matches = 0, total = 0;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank and size too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    lib_prof_init();
+
+    /* Protection from invalid use. */
+    if (argc < 3)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+
+    /* Each task generates or reads its own share of both sides. */
+    if (strcmp(argv[1], GENERATE_FLAG) == 0) {
+        if (argc >= 4 && (dist = lib_gen_parse(argv[3])) < 0)
+            lib_error("MAIN: Unknown distribution, see top of respective c file.");
+        if (argc >= 5)
+            seed = strtoull(argv[4], NULL, 10);
+        lib_gen_params(&params, dist, seed, atol(argv[2]) * world, world);
+        left_size = generate_side(&params, id, world, &left);
+        params.seed = seed + 1;
+        right_size = generate_side(&params, id, world, &right);
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        keys_only = argc < 4 || strcmp(argv[3], KV_FLAG) != 0;
+        left_size = lib_dist_read_kv64(MPI_COMM_WORLD, argv[1], keys_only, &left);
+        right_size = lib_dist_read_kv64(MPI_COMM_WORLD, argv[2], keys_only, &right);
+        lib_prof_lap(PROF_READ);
+    }
+
+    /* Same splitters for both sides, then match locally. */
+    lib_join_partition(MPI_COMM_WORLD, &left, &left_size, &right, &right_size);
+    lib_prof_lap(PROF_EXCHANGE);
+    matches = lib_merge_join(left, left_size, right, right_size, &rows);
+    lib_prof_lap(PROF_UNION);
+
+    total = lib_dist_write(MPI_COMM_WORLD, JOIN_OUTPUT, rows, sizeof(join_row_t), matches);
+    lib_prof_lap(PROF_WRITE);
+
+    if (id == ROOT) {
+        printf("Joined %ld matches into %s.\n", total, JOIN_OUTPUT);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+    }
+
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qJoin");
+
+    free(left);
+    free(right);
+    free(rows);
+
+    MPI_Finalize();
+
+    return 0;
+}
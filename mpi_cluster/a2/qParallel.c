@@ -6,14 +6,16 @@
  * see details here: http://en.wikipedia.org/wiki/Selection_algorithm.
  * Many helper functions exist in array_ops.c and file_ops.c see them.
  *
- * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qParallel <numbers> <mode>
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qParallel <numbers> <mode> <dist> <seed>
  *
  * Arguments:
  * tasks: The amount of number of processes to start. Only 2, 4 and 8 are acceptable.
  * numbers: Amount of integers per task, total integers is tasks * numbers.
- * mode: Flag that optionally makes master generate a new input.
- *      -> Use "gen" to generate new input.
- *      -> To read from input.txt, simply omit 'mode' and 'numbers'.
+ * mode: Flag that optionally makes every task generate its own share of the input in memory.
+ *      -> Use "gen" to generate new input, input.txt is neither read nor written.
+ *      -> To read from input.txt, simply omit 'mode'.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen, the same seed gives the same input on any number of tasks.
  *
  * Example generate file with 10000 numbers per process, 8 process.
  * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qParallel 10000 gen
@@ -25,18 +27,77 @@
  * I accept any file that is formatted so every integer is separated by a comma. Any amount of whitespace
  * between comma and next integer is allowable. Example: 10, 20,\n30,    50,
  *
+ * Profile:
+ * Every run writes profile.json, min/max/mean over the tasks of the time in each phase (read, scatter,
+ * each hypercube round's pivot select, pivot send, partition, exchange and union, local sort, gather of the
+ * sizes and shares, write and verify) and the bytes each round moved. Wire is what those bytes took on the
+ * transport after compression, the final gather (and balance pass) is counted as one more round after the
+ * hypercube's.
+ *
  * Logging:
- * I have created a rudimentary logging framework. It traces throughout execution the state of the arrays.
- * It is disabled by default, remove the comment on QDEBUG line and recompile to enable.
+ * Tracing records pivots and the state of the arrays throughout execution into memory, see trace_ops.c.
+ * It is off by default, set QTRACE=1 when starting to enable it, no recompile needed. Each task writes
+ * trace.<rank>.bin at exit, turn them into the readable log.<rank>.txt with ./demo/qTrace <tasks>.
+ *
+ * Modes:
+ * The sort is chosen with QMODE when starting, see dist_ops.c for the alternatives to the hypercube.
+ *      -> auto, the default. Inputs whose keys span at most DIST_COUNT_RANGE values and no more than there are
+ *         numbers (the default range input spans MAX_VAL) are placed by a global histogram in one exchange,
+ *         wider or sparser ones go through the hypercube.
+ *      -> hyper, always the hypercube.
+ *      -> bitonic, bitonic merge over the same hypercube pairs. No pivots, every task keeps exactly numbers
+ *         values and the messages are fixed, best for small numbers where predictable latency matters.
+ *
+ * Exchange:
+ * How hypercube partners move data is chosen with QEXCHANGE when starting.
+ *      -> shared, the default. Tasks on the same node keep their arrays in an MPI-3 shared window, a partner
+ *         on the node reads its part in place instead of receiving a message. Other partners use messages.
+ *      -> rma, every task exposes its array in an MPI_Win, partners swap counts and MPI_Get exactly what
+ *         they need in a post/start/complete/wait epoch. No receive sizing, the target's cpu isn't involved.
+ *      -> msg, plain Isend and Recv.
+ *
+ * Compression:
+ * Set QCOMPRESS=1 when starting to compress every message of the hypercube and the final gather, see
+ * codec_ops.c. Each message goes as frame of reference or, once sorted, delta bit packed ints, whichever is
+ * narrowest, or raw when neither pays off. Received blocks decode straight into the union. Window reads
+ * are not messages and stay uncompressed.
+ *
+ * Balance:
+ * The hypercube leaves every task with however many values fell in its range. Set QBALANCE=1 when starting
+ * to even them out afterwards, each task then holds exactly its share of numbers * tasks (one more for the
+ * first few when it doesn't divide), see lib_equalize in dist_ops.c. Only boundary slices move, point to point.
+ * The counting sort and bitonic modes are balanced already.
+ *
+ * Top k:
+ * Set QTOPK=k when starting to write only the k smallest values to output.txt, or QTOPK=-k for the k largest,
+ * both in increasing order, k from 1 up to all the numbers. Nothing is sorted, every task selects its own k
+ * candidates and only those within the tightest task's k-th value reach root, see lib_top_k in dist_ops.c.
+ * QMODE and QEXCHANGE don't apply.
+ *
+ * Presorted:
+ * Every run first checks in one pass whether the input is already sorted across the tasks, then it only
+ * evens out the shares (see lib_dist_sorted in dist_ops.c) whatever QMODE says. After the hypercube the
+ * local sort merges natural runs when there are few (lib_adaptive_sort), so nearly sorted input costs
+ * a few linear passes there instead of a full sort.
+ *
+ * Library:
+ * Jobs that already hold their data in memory call lib_hyper_sort in hyper_ops.c instead, the same hypercube
+ * on any communicator, sorting the caller's buffer in place with no input.txt or output.txt.
+ *
+ * Verify:
+ * Every run checks its result in O(numbers) per task, see lib_dist_verify in dist_ops.c. A count and an order
+ * independent hash of the input are summed over the tasks before sorting. Afterwards each task checks its
+ * share is sorted and starts at or above the last value of the tasks before it, and the shares must hash to
+ * the input. Root checks the gathered output the same way, so a value lost or repeated anywhere stops the run
+ * with an error instead of writing a wrong output.txt. Set QVERIFY=0 when starting to skip it, top k never
+ * verifies. No serial pass over output.txt is needed.
  *
  * Tests:
  * There are unit tests, those are also disabled. You can ignore them or read them if you like.
  *
- * TODO:
- *  -> Resolve outstanding scaling issue. Memory limited?
- *  Bug Note: There seems to be an issue with the MPI library. For total numbers (tasks*numbers) > 80000, this program
- *  crashes inside the MPI_Gather code. I do not in fact know why this happens after spend several hours
- *  on it. I'd like to know though, maybe you have an idea? All other code is known to work.
+ * Gather:
+ * Root gathers the per process counts first and then uses MPI_Gatherv. The old fixed size MPI_Gather with
+ * -1 padding received more than each process sent, which hung or crashed for larger inputs.
  */
 /********************* Header Files ***********************/
 /* C Headers */
@@ -48,25 +109,55 @@
 #include "mpi.h"
 #include "array_ops.h"
 #include "file_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "codec_ops.h"
+#include "prof_ops.h"
+#include "trace_ops.h"
 
 /******************* Constants/Macros *********************/
-/* Scaling factor gives buffer room for gather, might be a bit excessive. */
+/* Scaling factor for the initial recv buffer, it grows if a partner sends more. */
 #define GATHER_SCALE 		4
-//#define QDEBUG 				1 // Enable this line for tracing code.
-#define LOG_SIZE			100
 /* Maximum dimension of the hypercube */
 #define MAX_DIM 			3
 /* A tag for use in the send and recv */
 #define PIVOT_TAG			0
 #define EXCHANGE_TAG 		1
+#define COUNT_TAG 			2
+#define DONE_TAG 			3
+/* Environment variable choosing the sort and its values, see Modes above. */
+#define MODE_ENV			"QMODE"
+#define MODE_AUTO			"auto"
+#define MODE_HYPER			"hyper"
+#define MODE_BITONIC		"bitonic"
+/* Environment variable choosing the hypercube exchange and its values, see Exchange above. */
+#define EXCHANGE_ENV		"QEXCHANGE"
+#define EXCHANGE_SHARED		"shared"
+#define EXCHANGE_RMA		"rma"
+#define EXCHANGE_MSG		"msg"
+/* Environment variable turning on message compression, see Compression above. */
+#define COMPRESS_ENV		"QCOMPRESS"
+/* Environment variable turning on the final balance pass, see Balance above. */
+#define BALANCE_ENV			"QBALANCE"
+/* Environment variable turning off the output check, see Verify above. */
+#define VERIFY_ENV			"QVERIFY"
+/* Environment variable asking for only the k smallest, or with a minus sign largest, see Top k above. */
+#define TOP_K_ENV			"QTOPK"
 
 /******************* Type Definitions *********************/
+/* Window the hypercube keeps local in, shared by the ranks of a node or open to remote access by all. */
+typedef struct exchange_win_s {
+    int rma; /* 1 for MPI_Get over all ranks, 0 for direct loads within a node. */
+    MPI_Comm comm; /* Ranks in the window, only this node's when shared. */
+    MPI_Win win; /* Two buffers of cap ints per rank. */
+    int cap; /* Ints per buffer. */
+    int *base; /* First buffer of this rank. */
+    int **bases; /* Shared only, first buffer of each node rank mapped here. */
+    int *node_rank; /* Shared only, node rank of each world rank, MPI_UNDEFINED when on another node. */
+} exchange_win_t;
 
 
 /**************** Static Data Definitions *****************/
-/* Log file per process, buf used for anything not an array trace. */
-static FILE *log;
-static char log_buf[LOG_SIZE];
 
 /****************** Static Functions **********************/
 
@@ -93,84 +184,327 @@ int determine_dimension(const int world_size) {
 /*
  * Simple wrapper, acts as a multicast but only sends to members of a given subgroup.
  * Only ever called by root of a group, send to all ids above sender below group size.
+ * Blocking sends, an Isend of the pivot argument was never completed and its buffer went out of scope.
  */
 void send_pivot(int pivot, const subgroup_info_t * const info) {
-    MPI_Request mpi_request;
-
     for (int i = 1; i < info->group_size; ++i)
-        MPI_Isend(&pivot, 1, MPI_INT, info->world_id+i, PIVOT_TAG, MPI_COMM_WORLD, &mpi_request);
+        MPI_Send(&pivot, 1, MPI_INT, info->world_id+i, PIVOT_TAG, MPI_COMM_WORLD);
+}
+
+/*
+ * Window with two buffers of cap ints per rank, see hyper_quicksort. With rma every rank allocates its
+ * own in MPI_COMM_WORLD for MPI_Get. Otherwise ranks of the same node share one MPI-3 window and can address
+ * each other's buffers directly. Collective over MPI_COMM_WORLD.
+ */
+void window_init(exchange_win_t *xw, const int cap, const int rma) {
+    MPI_Group world_group, node_group;
+    MPI_Aint size = 0;
+    int disp = 0, world = 0, node_size = 0, *ranks = NULL;
+    const MPI_Aint bytes = 2 * (MPI_Aint)(cap > 0 ? cap : 1) * sizeof(int);
+
+    xw->rma = rma;
+    xw->cap = cap > 0 ? cap : 1;
+    xw->bases = NULL;
+    xw->node_rank = NULL;
+
+    if (rma) {
+        MPI_Comm_dup(MPI_COMM_WORLD, &xw->comm);
+        MPI_Win_allocate(bytes, sizeof(int), MPI_INFO_NULL, xw->comm, &xw->base, &xw->win);
+        return;
+    }
+
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &xw->comm);
+    MPI_Comm_size(xw->comm, &node_size);
+    MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, xw->comm, &xw->base, &xw->win);
+
+    /* Where every node rank's buffers are mapped here, and which world ranks are on this node. */
+    xw->bases = (int **)malloc(node_size * sizeof(int *));
+    xw->node_rank = (int *)malloc(world * sizeof(int));
+    ranks = (int *)malloc(world * sizeof(int));
+    if (xw->bases == NULL || xw->node_rank == NULL || ranks == NULL)
+        lib_error("WINDOW: Can't allocate window tables on heap.");
+
+    for (int q = 0; q < node_size; ++q)
+        MPI_Win_shared_query(xw->win, q, &size, &disp, &xw->bases[q]);
+
+    for (int r = 0; r < world; ++r)
+        ranks[r] = r;
+    MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    MPI_Comm_group(xw->comm, &node_group);
+    MPI_Group_translate_ranks(world_group, world, ranks, node_group, xw->node_rank);
+    MPI_Group_free(&world_group);
+    MPI_Group_free(&node_group);
+    free(ranks);
+
+    /* Passive target for the whole sort, ordering comes from MPI_Win_sync and the partner messages. */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, xw->win);
+}
+
+/*
+ * Release the window and its communicator. Collective over MPI_COMM_WORLD.
+ */
+void window_free(exchange_win_t *xw) {
+    if (!xw->rma)
+        MPI_Win_unlock_all(xw->win);
+    MPI_Win_free(&xw->win);
+    MPI_Comm_free(&xw->comm);
+    free(xw->bases);
+    free(xw->node_rank);
+}
+
+/*
+ * One sided read of count ints at disp of partner's window into dest. The partner reads from this rank
+ * at the same time, so each side both exposes (post/wait) and accesses (start/complete) for just the pair.
+ * Wait returns once the partner's read of this rank is done.
+ */
+void window_get(const exchange_win_t *xw, const int partner, const MPI_Aint disp, int dest[], const int count) {
+    MPI_Group world_group, pair;
+
+    MPI_Comm_group(xw->comm, &world_group);
+    MPI_Group_incl(world_group, 1, &partner, &pair);
+
+    MPI_Win_post(pair, MPI_MODE_NOPUT, xw->win);
+    MPI_Win_start(pair, 0, xw->win);
+    if (count > 0)
+        MPI_Get(dest, count, MPI_INT, partner, disp, count, MPI_INT, xw->win);
+    MPI_Win_complete(xw->win);
+    MPI_Win_wait(xw->win);
+
+    MPI_Group_free(&pair);
+    MPI_Group_free(&world_group);
+}
+
+/*
+ * Make sure buf holds at least need bytes, cap is its current size.
+ */
+void grow_wire(unsigned char *buf[], long *cap, const long need) {
+    if (need <= *cap)
+        return;
+
+    free(*buf);
+    *cap = need;
+    if ((*buf = (unsigned char *)malloc(*cap)) == NULL)
+        lib_error("MAIN: Can't grow wire buffer on heap.");
 }
 
 /*
  * Implementation of the hyper quicksort for any given dimension. Topology is assumed to be entirely
  * in MPI_COMM_WORLD. Details follow traditional hypercube algorithm seen on page 422 of Parallel Computing (Gupta).
  * At the end, each processor with local_size elements in local will be ready to locally sort.
+ * Recv is grown when a partner sends more than fits, skewed inputs can move most of the data to one side.
+ * Partitions are three way and partners trade their (lt, eq, gt) counts first, keys equal to the pivot
+ * can go either way so they are split to even out the load. Duplicate heavy inputs stay balanced.
+ *
+ * With a window xw, local lives in this rank's window buffers while it fits. A shared window lets a partner
+ * on the same node copy the part it needs straight out of them, no message and no copy through the transport.
+ * An rma window lets any partner MPI_Get exactly its part straight into its next union.
+ * Rounds alternate between the two buffers, so the next union never overwrites what a partner still reads.
+ * Partners on other nodes of a shared window, or whose local outgrew its buffer, exchange messages as before.
+ * With compress, messages go encoded by lib_codec_encode and decode straight into the union, recv is unused.
  */
 void hyper_quicksort(const int dimension, const int id, int *local[], int *local_size,
-        int recv[], const int recv_size) {
+        int *recv[], int *recv_size, const exchange_win_t *xw, const int compress) {
     MPI_Status mpi_status;
     MPI_Request mpi_request;
     subgroup_info_t info = {0, 0, 0, 0, id}; /* Init struct to zero, except for id of caller. */
-    int pivot = 0, lt_size = 0, gt_size = 0, received = 0;
+    int pivot = 0, received = 0, keep_from = 0, keep_size = 0, send_from = 0, send_size = 0;
+    int their_keep_from = 0, their_keep_size = 0, their_send_from = 0, their_send_size = 0;
+    int round = 0, in_window = 0, windowed = 0, upper = 0, new_size = 0;
+    int mine[4] = {0, 0, 0, 0}, theirs[4] = {0, 0, 0, 0}; /* Counts of lt, eq and gt, then whether in the window. */
+    int *mybase = NULL, *src = NULL, *next = NULL;
+    unsigned char *packed = NULL, *inbox = NULL;
+    long packed_cap = 0, inbox_cap = 0, wire_out = 0;
+    int wire_in = 0;
 
     if (dimension < 1)
         lib_error("HYPER: Dimension can't be less than 1.");
 
+    /* Move local into the first window buffer if it fits. */
+    if (xw != NULL && *local_size <= xw->cap) {
+        mybase = xw->base;
+        memcpy(mybase, *local, *local_size * sizeof(int));
+        free(*local);
+        *local = mybase;
+        in_window = 1;
+    }
+
     /* Iterate for all dimensions of cube. */
     for (int d = dimension-1; d >= 0; --d) {
         /* Determine the group and member number of id, and its partner. */
+        round = dimension-1-d;
         lib_subgroup_info(d+1, &info);
-
-#ifdef QDEBUG
-        snprintf(log_buf, LOG_SIZE, "INFO: World_id, Group, mem, partner. %d %d %d %d.\n",
-        		info.world_id, info.group_num, info.member_num, info.partner);
-        lib_log(log, "INFO", log_buf);
-#endif
+        lib_prof_round(round);
+        TRACE_EVENT(TRACE_INFO, info.world_id, info.group_num, info.member_num, info.partner);
 
         /* Select and broadcast pivot only to subgroup. */
+        lib_prof_lap(PROF_PIVOT_SELECT);
         if (info.member_num == 0) {
-            int pivot_index = lib_median_of_medians(*local, 0, (*local_size) - 1);
-            pivot = (*local)[pivot_index];
-#ifdef QDEBUG
-            snprintf(log_buf, LOG_SIZE, "ROUND: %d, GROUP: %d, pivot is: %d.\n", dimension-d, info.group_num, pivot);
-            lib_log(log, "PIVOT", log_buf);
-#endif
+            /* An empty group root can only guess. */
+            pivot = *local_size > 0 ? (*local)[lib_median_of_medians(*local, 0, (*local_size) - 1)] : 0;
+            lib_prof_lap(PROF_PIVOT_SELECT);
+            TRACE_EVENT(TRACE_PIVOT, dimension-d, info.group_num, pivot, 0);
             send_pivot(pivot, &info);
         } else {
-            MPI_Recv(&pivot, 1, MPI_INT, MPI_ANY_SOURCE, PIVOT_TAG, MPI_COMM_WORLD, &mpi_status);
+            /* Only from my group root, a root of the next round's smaller group may already be sending. */
+            MPI_Recv(&pivot, 1, MPI_INT, id - info.member_num, PIVOT_TAG, MPI_COMM_WORLD, &mpi_status);
         }
 
+        lib_prof_lap(PROF_PIVOT_BCAST);
+
         /* Partition the array. */
-        lib_partition_by_pivot_val(pivot, *local, *local_size, &lt_size, &gt_size);
-
-#ifdef QDEBUG
-        lib_trace_array(log, "PARTITIONED", *local, *local_size);
-#endif
-
-        /* Determine position in the cube. If below is true, I am in upper part of this dimension. */
-        if (id & (1<<d)) {
-            MPI_Isend(*local, lt_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
-            MPI_Recv(recv, recv_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
-            /* We have sent lower portion, move elements greater down. Update local_size.*/
-            memmove(*local, *local+lt_size, gt_size*sizeof(int));
-            *local_size = gt_size;
+        lib_partition3_by_pivot_val(pivot, *local, *local_size, &mine[0], &mine[1], &mine[2]);
+        lib_prof_lap(PROF_PARTITION);
+
+        TRACE_ARRAY(TRACE_PARTITIONED, *local, *local_size);
+
+        /*
+         * Trade counts, then both sides agree on how to split the equal band. If id bit d is set, I am upper.
+         * Each side also works out the other's split, that gives the exact size it will receive.
+         * The partitioned window is published before the counts go out so the partner sees it after.
+         */
+        mine[3] = in_window;
+        if (in_window && !xw->rma)
+            MPI_Win_sync(xw->win);
+        MPI_Sendrecv(mine, 4, MPI_INT, info.partner, COUNT_TAG, theirs, 4, MPI_INT, info.partner, COUNT_TAG,
+                MPI_COMM_WORLD, &mpi_status);
+        upper = id & (1<<d);
+        lib_split_equal(mine, theirs, upper, &keep_from, &keep_size, &send_from, &send_size);
+        lib_split_equal(theirs, mine, !upper, &their_keep_from, &their_keep_size, &their_send_from, &their_send_size);
+        received = their_send_size;
+        new_size = keep_size + received;
+        windowed = in_window && theirs[3] && (xw->rma || xw->node_rank[info.partner] != MPI_UNDEFINED);
+
+        /* Union goes into the other window buffer while it fits, kept part first. */
+        if (in_window && new_size <= xw->cap) {
+            next = mybase + ((round+1) % 2) * xw->cap;
+        } else if ((next = (int *)malloc((new_size > 0 ? new_size : 1) * sizeof(int))) == NULL) {
+            lib_error("HYPER: Can't allocate union array on heap.");
+        }
+
+        /* Partner's current buffer is the same one of its two as mine, every windowed rank alternates alike. */
+        if (windowed && xw->rma) {
+            window_get(xw, info.partner, (MPI_Aint)(round % 2) * xw->cap + their_send_from, next+keep_size, received);
+            src = next+keep_size;
+        } else if (windowed) {
+            MPI_Win_sync(xw->win);
+            src = xw->bases[xw->node_rank[info.partner]] + (round % 2) * xw->cap + their_send_from;
+        } else if (compress) {
+            grow_wire(&packed, &packed_cap, lib_codec_bound(send_size));
+            wire_out = lib_codec_encode(*local+send_from, send_size, packed);
+            MPI_Isend(packed, (int)wire_out, MPI_BYTE, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
+
+            /* Encoded size depends on the values, probe for it. */
+            MPI_Probe(info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
+            MPI_Get_count(&mpi_status, MPI_BYTE, &wire_in);
+            grow_wire(&inbox, &inbox_cap, wire_in);
+            MPI_Recv(inbox, wire_in, MPI_BYTE, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
+            MPI_Wait(&mpi_request, MPI_STATUS_IGNORE);
+
+            /* Checked before decoding, a block longer than received would overrun the union array. */
+            if (lib_codec_count(inbox) != received)
+                lib_error("HYPER: Exchanged block doesn't match its count.");
+            lib_codec_decode(inbox, next+keep_size);
+            src = next+keep_size;
         } else {
-            MPI_Isend(*local+lt_size, gt_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
-            MPI_Recv(recv, recv_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
-            /* We have sent upper portion of array, merely update size and ignore older elements. */
-            *local_size = lt_size;
+            MPI_Isend(*local+send_from, send_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
+
+            /* Grow recv if it won't fit. */
+            if (received > *recv_size) {
+                free(*recv);
+                *recv_size = received;
+                if ((*recv = (int *)malloc(*recv_size * sizeof(int))) == NULL)
+                    lib_error("HYPER: Can't grow recv array on heap.");
+            }
+            MPI_Recv(*recv, *recv_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
+
+            /* Ensure the send completes before local is moved or reallocated under it. */
+            MPI_Wait(&mpi_request, MPI_STATUS_IGNORE);
+            src = *recv;
         }
+        lib_prof_bytes((long)(send_size + received) * sizeof(int),
+                windowed || !compress ? (long)((send_size + received) * sizeof(int)) : wire_out + wire_in);
+        lib_prof_lap(PROF_EXCHANGE);
+
+        /* Union of the kept part and the received part, a get already landed in place. */
+        memcpy(next, *local+keep_from, keep_size*sizeof(int));
+        if (src != next+keep_size)
+            memcpy(next+keep_size, src, received*sizeof(int));
+
+        /* Partner has finished reading my shared buffer once it also got here, it is rewritten next round. */
+        if (windowed && !xw->rma)
+            MPI_Sendrecv(NULL, 0, MPI_INT, info.partner, DONE_TAG, NULL, 0, MPI_INT, info.partner, DONE_TAG,
+                    MPI_COMM_WORLD, &mpi_status);
+
+        if (!in_window)
+            free(*local);
+        in_window = in_window && new_size <= xw->cap;
+        *local = next;
+        *local_size = new_size;
+        lib_prof_lap(PROF_UNION);
+
+        TRACE_ARRAY(TRACE_RECV, src, received);
+        TRACE_ARRAY(TRACE_UNION, *local, *local_size);
+    }
 
-        /* Get the received count and call array union function to merge into local. */
-        MPI_Get_count(&mpi_status, MPI_INT, &received);
-        lib_array_union(local, local_size, recv, received);
+    /* Back on the heap for the rest of the program. */
+    if (in_window) {
+        if ((next = (int *)malloc((*local_size > 0 ? *local_size : 1) * sizeof(int))) == NULL)
+            lib_error("HYPER: Can't allocate local array on heap.");
+        memcpy(next, *local, *local_size * sizeof(int));
+        *local = next;
+    }
 
-        /* Ensure all partner exchanges complete before proceeding to the next round. */
-#ifdef QDEBUG
-        lib_trace_array(log, "RECV", recv, received);
-        lib_trace_array(log, "UNION", *local, *local_size);
-#endif
+    free(packed);
+    free(inbox);
+}
+
+/*
+ * Gather every rank's local at root like MPI_Gatherv, but each rank sends its local encoded by
+ * lib_codec_encode and root decodes each block into place at displs. Counts and displs are root only.
+ * Returns the bytes this rank put on or took off the wire.
+ */
+long gather_compressed(const int id, const int world, const int local[], const int local_size,
+        int root[], const int counts[], const int displs[]) {
+    unsigned char *packed = NULL, *all = NULL;
+    int *wire_counts = NULL, *wire_displs = NULL;
+    long packed_cap = 0, wire = 0;
+    int bytes = 0;
+
+    grow_wire(&packed, &packed_cap, lib_codec_bound(local_size));
+    bytes = (int)lib_codec_encode(local, local_size, packed);
+    wire = bytes;
+
+    /* Encoded sizes first, so root can lay the blocks out. */
+    if (id == ROOT) {
+        wire_counts = (int *)malloc(world * sizeof(int));
+        wire_displs = (int *)malloc(world * sizeof(int));
+        if (wire_counts == NULL || wire_displs == NULL)
+            lib_error("MAIN: Can't allocate wire counts on heap.");
     }
+    MPI_Gather(&bytes, 1, MPI_INT, wire_counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+    if (id == ROOT) {
+        wire_displs[0] = 0;
+        for (int i = 1; i < world; ++i)
+            wire_displs[i] = wire_displs[i-1] + wire_counts[i-1];
+        wire = wire_displs[world-1] + wire_counts[world-1];
+        if ((all = (unsigned char *)malloc(wire > 0 ? wire : 1)) == NULL)
+            lib_error("MAIN: Can't allocate wire gather on heap.");
+    }
+
+    MPI_Gatherv(packed, bytes, MPI_BYTE, all, wire_counts, wire_displs, MPI_BYTE, ROOT, MPI_COMM_WORLD);
+
+    for (int i = 0; id == ROOT && i < world; ++i) {
+        if (lib_codec_decode(all + wire_displs[i], root + displs[i]) != counts[i])
+            lib_error("MAIN: Gathered block doesn't match its count.");
+    }
+
+    free(packed);
+    free(all);
+    free(wire_counts);
+    free(wire_displs);
+
+    return wire;
 }
 
 /*
@@ -178,8 +512,17 @@ void hyper_quicksort(const int dimension, const int id, int *local[], int *local
  */
 int main(int argc, char **argv) {
     int id = 0, world = 0, num_per_proc = 0, root_size = 0, recv_size = 0, local_size = 0, dimension = 0;
-    int *root = NULL, *recv = NULL, *local = NULL;
-    char file[FILE_SIZE];
+    int generate = 0, dist = GEN_RANGE, sorted = 0, compress = 0, top_k = 0, out_size = 0, balance = 0, verify = 0;
+    const char *mode = getenv(MODE_ENV), *exchange = getenv(EXCHANGE_ENV), *compress_env = getenv(COMPRESS_ENV);
+    const char *top_k_env = getenv(TOP_K_ENV), *balance_env = getenv(BALANCE_ENV), *verify_env = getenv(VERIFY_ENV);
+    int presorted = 0;
+    exchange_win_t xw;
+    int *root = NULL, *recv = NULL, *local = NULL, *counts = NULL, *displs = NULL;
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    dist_digest_t digest;
+    long offset = 0, count = 0, requested = 0;
+    char *end = NULL;
     double start = 0.0;
 
     /* Standard init for MPI, start timer after init. Get rank and size too. */
@@ -187,42 +530,61 @@ int main(int argc, char **argv) {
     start = MPI_Wtime();
     MPI_Comm_rank(MPI_COMM_WORLD, &id);
     MPI_Comm_size(MPI_COMM_WORLD, &world);
-
-#ifdef QDEBUG
-    /* Open log file, overwrite on each open. */
-    snprintf(file, FILE_SIZE, LOG_FORMAT, id);
-    if ((log = fopen(file, "w")) == NULL)
-        lib_error("MAIN: Could not open log file.");
-#endif
+    lib_prof_init();
+    lib_trace_init(id);
 
     /* Determine the dimension of the cube. */
     dimension = determine_dimension(world);
     if (dimension == 0)
         lib_error("MAIN: This hypercube program only supports running with 2, 4 or 8 processors.");
 
-    /* Get the work amount from command for each process. */
-    num_per_proc = atoi(*++argv);
+    /* Get the work amount from command for each process, then the optional generate arguments. */
+    if (argc < 2)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+    num_per_proc = atoi(argv[1]);
     root_size = num_per_proc * world;
+    out_size = root_size;
+    generate = argc >= 3 && strcmp(argv[2], GENERATE_FLAG) == 0;
+    if (generate && argc >= 4 && (dist = lib_gen_parse(argv[3])) < 0)
+        lib_error("MAIN: Unknown distribution, see top of respective c file.");
+    if (generate && argc >= 5)
+        seed = strtoull(argv[4], NULL, 10);
+    if (mode == NULL)
+        mode = MODE_AUTO;
+    if (strcmp(mode, MODE_AUTO) != 0 && strcmp(mode, MODE_HYPER) != 0 && strcmp(mode, MODE_BITONIC) != 0)
+        lib_error("MAIN: Unknown QMODE, see top of respective c file.");
+    if (exchange == NULL)
+        exchange = EXCHANGE_SHARED;
+    if (strcmp(exchange, EXCHANGE_SHARED) != 0 && strcmp(exchange, EXCHANGE_RMA) != 0 && strcmp(exchange, EXCHANGE_MSG) != 0)
+        lib_error("MAIN: Unknown QEXCHANGE, see top of respective c file.");
+    compress = compress_env != NULL && atoi(compress_env) != 0;
+    if (top_k_env != NULL) {
+        requested = strtol(top_k_env, &end, 10);
+        if (end == top_k_env || *end != '\0' || requested == 0 || requested < -(long)root_size || requested > root_size)
+            lib_error("MAIN: QTOPK must be a nonzero count of at most all the numbers, see top of respective c file.");
+        top_k = (int)requested;
+    }
+    balance = balance_env != NULL && atoi(balance_env) != 0;
+    verify = (verify_env == NULL || atoi(verify_env) != 0) && top_k == 0;
 
-    /* Root only work, ensure good usage and proper input. */
+    /* Root only work, ensure good usage and proper input. Generated input never goes through root. */
     if (id == ROOT) {
         /* Allocate the whole array on the heap, large amount of memory likely wouldn't fit on stack. */
         root = (int *)malloc(root_size * sizeof(int));
-        if (root == NULL)
+        counts = (int *)malloc(world * sizeof(int));
+        displs = (int *)malloc(world * sizeof(int));
+        if (root == NULL || counts == NULL || displs == NULL)
             lib_error("MAIN: Can't allocate root_vals array on heap.");
 
-        /* If requested, generate new input file. */
-        if (argc == 3 && strcmp(*++argv, GENERATE_FLAG) == 0) {
-            lib_generate_numbers(root, root_size);
-            lib_write_file(INPUT, root, root_size);
-        }
-
-        /* Read back input from file into array on heap. */
-        lib_read_file(INPUT, root, root_size);
+        /* Read input from file into array on heap. */
+        if (!generate)
+            lib_read_file(INPUT, root, root_size);
     }
+    lib_prof_lap(PROF_READ);
 
     /*
      * Allocate a recv buffer with a bit of extra padding, accounts for small deviations in distribution.
+     * Skewed input can still overflow it, hyper_quicksort grows it then.
      * Local will be reallocated based on need, start as num_per_proc.
      */
     recv_size = num_per_proc * GATHER_SCALE;
@@ -236,58 +598,138 @@ int main(int argc, char **argv) {
     if (local == NULL)
         lib_error("MAIN: Can't allocate local array on heap.");
 
-    /* Scatter across the processes and then do hyper quicksort algorithm. Also, bcast the pivots. */
-    MPI_Scatter(root, num_per_proc, MPI_INT, local, local_size, MPI_INT, ROOT, MPI_COMM_WORLD);
-#ifdef QDEBUG
-    lib_trace_array(log, "SCATTER", local, local_size);
-#endif
-
-    /* Rearrange the cube so that each processor has data strictly less than one with higher number.*/
-    hyper_quicksort(dimension, id, &local, &local_size, recv, recv_size);
+    /* Each process generates its own share, else scatter across the processes. Then do hyper quicksort algorithm. */
+    if (generate) {
+        lib_gen_params(&params, dist, seed, (long)root_size, world);
+        lib_gen_share(params.total, id, world, &offset, &count);
+        lib_gen_fill(&params, local, offset, count);
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        MPI_Scatter(root, num_per_proc, MPI_INT, local, local_size, MPI_INT, ROOT, MPI_COMM_WORLD);
+        lib_prof_lap(PROF_SCATTER);
+    }
 
-#ifdef QDEBUG
-    lib_trace_array(log, "HYPER", local, local_size);
-#endif
+    /* What the output must hold, counted before anything moves. */
+    if (verify) {
+        lib_dist_digest(MPI_COMM_WORLD, local, local_size, &digest);
+        lib_prof_lap(PROF_VERIFY);
+    }
+    TRACE_ARRAY(TRACE_SCATTER, local, local_size);
 
     /*
-     * Reallocated root to be rescaled, mpi_gather doesn't know how many per process anymore.
-     * Set values to -1 and assume it won't be worse than the scaling factor of about 20%.
+     * Only the k smallest or largest are wanted, root gets just those and nothing is sorted.
+     * Input that is sorted already only needs even shares. A small key range is sorted outright by counting,
+     * bitonic always sorts. Local then holds its final share.
+     * The sortedness check is a pass and a collective, it is lapped as verify whether or not it pays off.
      */
-    if (id == ROOT) {
-        free(root);
-        root_size *= GATHER_SCALE;
-        root = (int *)malloc(root_size * sizeof(int));
-        if (root == NULL)
-            lib_error("MAIN: Can't allocate root array on heap.");
-        memset(root, -1, root_size * sizeof(int));
+    if (top_k == 0) {
+        presorted = lib_dist_sorted(MPI_COMM_WORLD, local, local_size);
+        lib_prof_lap(PROF_VERIFY);
+    }
+    if (top_k != 0) {
+        out_size = lib_top_k(MPI_COMM_WORLD, local, local_size, top_k > 0 ? top_k : -top_k, top_k < 0, root);
+        sorted = 1;
+        lib_prof_lap(PROF_EXCHANGE);
+    } else if (presorted) {
+        lib_equalize(MPI_COMM_WORLD, &local, &local_size);
+        sorted = 1;
+        lib_prof_lap(PROF_EXCHANGE);
+    } else if (strcmp(mode, MODE_AUTO) == 0) {
+        sorted = lib_count_sort(MPI_COMM_WORLD, &local, &local_size);
+        lib_prof_lap(PROF_EXCHANGE);
+    } else if (strcmp(mode, MODE_BITONIC) == 0) {
+        lib_bitonic_sort(MPI_COMM_WORLD, local, local_size);
+        sorted = 1;
+        lib_prof_lap(PROF_EXCHANGE);
     }
 
-    /* Quicksort local array and then send back to root. */
-    qsort(local, local_size, sizeof(int), lib_compare);
-    MPI_Gather(local, local_size, MPI_INT, root, GATHER_SCALE*num_per_proc, MPI_INT, ROOT, MPI_COMM_WORLD);
+    if (!sorted) {
+        /* Rearrange the cube so that each processor has data strictly less than one with higher number.*/
+        if (strcmp(exchange, EXCHANGE_MSG) != 0) {
+            window_init(&xw, recv_size, strcmp(exchange, EXCHANGE_RMA) == 0);
+            hyper_quicksort(dimension, id, &local, &local_size, &recv, &recv_size, &xw, compress);
+            window_free(&xw);
+        } else {
+            hyper_quicksort(dimension, id, &local, &local_size, &recv, &recv_size, NULL, compress);
+        }
 
-    /* Last step, root has to compress array due to uneven nature after gather. Then write to file. */
-    if (id == ROOT) {
-        lib_compress_array(world, root, root_size);
-        root_size /= GATHER_SCALE;
+        TRACE_ARRAY(TRACE_HYPER, local, local_size);
+
+        /* Sort local array, merges the runs of nearly sorted input and is introsort (lib_sort) otherwise. */
+        lib_adaptive_sort(local, local_size);
+        lib_prof_lap(PROF_LOCAL_SORT);
+
+        /* Equal shares for whatever comes next, counted with the gather's round. */
+        if (balance) {
+            lib_prof_round(dimension);
+            lib_equalize(MPI_COMM_WORLD, &local, &local_size);
+            lib_prof_lap(PROF_EXCHANGE);
+        }
+    }
+
+    /* Every share sorted, in order over the ranks and together the input, before root sees any of it. */
+    if (verify) {
+        if (!lib_dist_verify(MPI_COMM_WORLD, local, local_size, &digest))
+            lib_error("VERIFY: Sorted shares are not a sorted permutation of the input.");
+        lib_prof_lap(PROF_VERIFY);
+    }
+
+    /* Top k already has its answer at root. */
+    if (top_k == 0) {
+        /*
+         * Sizes are uneven after the hypercube, gather them first so root can place each process exactly.
+         * No sentinel values, so generated inputs may hold any int.
+         */
+        MPI_Gather(&local_size, 1, MPI_INT, counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+        if (id == ROOT) {
+            displs[0] = 0;
+            for (int i = 1; i < world; ++i)
+                displs[i] = displs[i-1] + counts[i-1];
+        }
+
+        /* Send back to root. Then write to file. */
+        lib_prof_round(dimension);
+        if (compress) {
+            lib_prof_bytes((long)(id == ROOT ? root_size : local_size) * sizeof(int),
+                    gather_compressed(id, world, local, local_size, root, counts, displs));
+        } else {
+            MPI_Gatherv(local, local_size, MPI_INT, root, counts, displs, MPI_INT, ROOT, MPI_COMM_WORLD);
+            lib_prof_bytes((long)(id == ROOT ? root_size : local_size) * sizeof(int),
+                    (long)(id == ROOT ? root_size : local_size) * sizeof(int));
+        }
+        lib_prof_lap(PROF_GATHER);
+    }
 
-#ifdef QDEBUG
-        lib_trace_array(log, "GATHER", root, root_size);
-#endif
+    if (id == ROOT) {
+        TRACE_ARRAY(TRACE_GATHER, root, out_size);
+
+        /* The gather (and its decoding) must not lose or reorder anything either. */
+        if (verify) {
+            if (out_size != digest.count || lib_count_runs(root, out_size) > 1 ||
+                    lib_multiset_hash(root, out_size) != digest.hash)
+                lib_error("VERIFY: Gathered output lost or reordered values.");
+            lib_prof_lap(PROF_VERIFY);
+            printf("Verified %ld values sorted, multiset hash %016llx.\n", digest.count,
+                    (unsigned long long)digest.hash);
+        }
 
-        lib_write_file(OUTPUT, root, root_size);
+        lib_write_file(OUTPUT, root, out_size);
+        lib_prof_lap(PROF_WRITE);
         printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
         free(root);
+        free(counts);
+        free(displs);
     }
 
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qParallel");
+
     free(recv);
     /* May have been entirely deallocated if has no more at process. */
     if (local != NULL)
         free(local);
 
-#ifdef QDEBUG
-    fclose(log);
-#endif
+    lib_trace_close();
 
     MPI_Finalize();
 
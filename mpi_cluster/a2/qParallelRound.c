@@ -1,19 +1,31 @@
 /**
- * Reference implementation of quicksort with serial implementation as baseline.
- * This program will only serially calculate the quicksort of the input file.
- * If you don't know the number of words in your input: cat input.txt | wc, second number is word count.
- * See mylib.h/.c for functions not in this file.
+ * One pass variant of the hyper quicksort. Root picks all 2^d - 1 pivots of a d dimensional cube up front
+ * from a sample of every task's medians, through lib_select_pivots_from_medians.
+ * The hypercube then spends d rounds partitioning on one pivot and trading halves with a partner.
+ * Here every value is classified once against all pivots with a branchless search tree (lib_classify), the
+ * buckets land in contiguous blocks and a single all to all delivers each to its task. d partition passes and
+ * d exchanges become one of each. See dist_ops.c.
  *
- * Use command: bsub -I -q COMP428 -n1 mpirun -srun ./demo/parallel <work> <mode>
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qParallelRound <numbers> <mode> <dist> <seed>
  *
- * Arguments to serial:
- * work: The amount of numbers per process, total = work * world size.
- * mode: Flag that optionally makes master generate a new input.
- * 		-> Use "gen" to generate new input.
- * 		-> Use "read" to use existing input.txt.
- * TODO:
- *  -> Resolve outstanding scaling issue. Memory limited?
- *  -> Resolve CUnit issue on cirrus.
+ * Arguments:
+ * tasks: The amount of number of processes to start. Only 2, 4 and 8 are acceptable.
+ * numbers: Amount of integers per task, total integers is tasks * numbers.
+ * mode: Flag that optionally makes every task generate its own share of the input in memory.
+ *      -> Use "gen" to generate new input, input.txt is neither read nor written.
+ *      -> To read from input.txt, simply omit 'mode'.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen, the same seed gives the same input on any number of tasks.
+ *
+ * Example sort 10000 generated numbers per process, 8 process.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qParallelRound 10000 gen
+ *
+ * Splitters:
+ * Set QSPLITTERS=sketch when starting to read the splitters off a merged quantile sketch of all values instead
+ * of root's sample of medians, see lib_sketch_splitters in dist_ops.c. The default is sample.
+ *
+ * Profile and logging work as in qParallel. Everything happens in round 0, the splitter sample is its
+ * pivot select and the classification plus all to all its exchange.
  */
 /********************* Header Files ***********************/
 /* C Headers */
@@ -25,25 +37,23 @@
 #include "mpi.h"
 #include "array_ops.h"
 #include "file_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "prof_ops.h"
+#include "trace_ops.h"
 
 /******************* Constants/Macros *********************/
-#define BUF_SIZE 			1000000
-#define GATHER_SCALE 		1.2
-#define QDEBUG 				1 // Enable this line for tracing code.
-#define LOG_SIZE			100
 /* Maximum dimension of the hypercube */
 #define MAX_DIM 			3
-/* A tag for use in the send and recv */
-#define PIVOT_TAG			0
-#define EXCHANGE_TAG 		1
+/* Environment variable choosing how splitters are found, see Splitters above. */
+#define SPLITTERS_ENV		"QSPLITTERS"
+#define SPLITTERS_SAMPLE	"sample"
+#define SPLITTERS_SKETCH	"sketch"
 
 /******************* Type Definitions *********************/
 
 
 /**************** Static Data Definitions *****************/
-/* Log file per process, buf used for anything not an array trace. */
-static FILE *log;
-static char log_buf[LOG_SIZE];
 
 /****************** Static Functions **********************/
 
@@ -52,86 +62,33 @@ static char log_buf[LOG_SIZE];
 
 
 /****************** Global Functions **********************/
-
 /*
- * Simple wrapper, acts as a multicast but only sends to members of a given subgroup.
- * Only ever called by root of a group, send to all ids above sender below group size.
+ * I only allow program to run if size is of a hypercube with dimension 1, 2 or 3.
+ * If not right size, return 0 and fail. Else return the dimension.
  */
-void send_pivot(int pivot, const subgroup_info_t * const info) {
-    MPI_Request mpi_request;
-
-    for (int i = 1; i < info->group_size; ++i)
-        MPI_Isend(&pivot, 1, MPI_INT, info->world_id+i, PIVOT_TAG, MPI_COMM_WORLD, &mpi_request);
-}
+int determine_dimension(const int world_size) {
+    int dimension = 0;
 
-/*
- * Implementation of the hyper quicksort for any given dimension. Topology is assumed to be entirely
- * in MPI_COMM_WORLD. Details follow traditional hypercube algorithm seen on page 422 of Parallel Computing (Gupta).
- * At the end, each processor with local_size elements in local will be ready to locally sort.
- */
-void hyper_quicksort(const int dimension, const int id, int *local[], int *local_size,
-        int recv[], const int recv_size) {
-    MPI_Status mpi_status;
-    MPI_Request mpi_request;
-    subgroup_info_t info = {0, 0, 0, 0, id};
-    int pivot = 0, lt_size = 0, gt_size = 0, received = 0;
-
-    /* Iterate for all dimensions of cube. */
-    for (int d = dimension-1; d >= 0; --d) {
-        /* Determine the group and member number of id, and its partner. */
-        lib_subgroup_info(d+1, &info);
-
-        /* Select and broadcast pivot only to subgroup. */
-        if (info.member_num == 0) {
-            pivot = lib_select_pivot(*local, *local_size);
-            snprintf(log_buf, LOG_SIZE, "ROUND: %d, GROUP: %d, pivot is: %d.\n", dimension-d, info.group_num, pivot);
-            lib_log(log, "PIVOT", log_buf);
-            send_pivot(pivot, &info);
-        } else {
-            MPI_Recv(&pivot, 1, MPI_INT, MPI_ANY_SOURCE, PIVOT_TAG, MPI_COMM_WORLD, &mpi_status);
-        }
-
-        /* Partition the array. */
-        lib_partition_by_pivot_val(pivot, *local, *local_size, &lt_size, &gt_size);
-
-        /* Barrier here ensures all outstanding pivot recvs complete. */
-#ifdef QDEBUG
-        lib_trace_array(log, "PARTITIONED", *local, *local_size);
-#endif
-
-        /* Determine position in the cube. If below is true, I am in upper part of this dimension. */
-        if (id & (1<<d)) {
-            MPI_Isend(*local, lt_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
-            MPI_Recv(recv, recv_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
-            /* We have sent lower portion, move elements greater down. Update local_size.*/
-            memmove(*local, *local+lt_size, gt_size*sizeof(int));
-            *local_size = gt_size;
-        } else {
-            MPI_Isend(*local+lt_size, gt_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_request);
-            MPI_Recv(recv, recv_size, MPI_INT, info.partner, EXCHANGE_TAG, MPI_COMM_WORLD, &mpi_status);
-            /* We have sent upper portion of array, merely update size and ignore older elements. */
-            *local_size = lt_size;
-        }
-
-        /* Get the received count and call array union function to merge into local. */
-        MPI_Get_count(&mpi_status, MPI_INT, &received);
-        lib_array_union(local, local_size, recv, received);
-
-        /* Ensure all partner exchanges complete before proceeding to the next round. */
-#ifdef QDEBUG
-        lib_trace_array(log, "RECV", recv, received);
-        lib_trace_array(log, "UNION", *local, *local_size);
-#endif
+    for (int d = 1; d <= MAX_DIM; ++d) {
+        if (world_size == lib_power(2, d))
+            dimension = d;
     }
+
+    return dimension;
 }
 
 /*
  * Main execution body.
  */
 int main(int argc, char **argv) {
-    int id = 0, world = 0, num_proc = 0, root_size = 0, recv_size = 0, local_size = 0;
-    int *root = NULL, *recv = NULL, *local = NULL;
-    char file[FILE_SIZE];
+    int id = 0, world = 0, num_per_proc = 0, root_size = 0, local_size = 0, dimension = 0;
+    int generate = 0, dist = GEN_RANGE;
+    int *root = NULL, *local = NULL, *counts = NULL, *displs = NULL;
+    int tree[(1 << MAX_DIM) - 1];
+    const char *splitters = getenv(SPLITTERS_ENV);
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    long offset = 0, count = 0;
     double start = 0.0;
 
     /* Standard init for MPI, start timer after init. Get rank and size too. */
@@ -139,101 +96,112 @@ int main(int argc, char **argv) {
     start = MPI_Wtime();
     MPI_Comm_rank(MPI_COMM_WORLD, &id);
     MPI_Comm_size(MPI_COMM_WORLD, &world);
+    lib_prof_init();
+    lib_trace_init(id);
 
-    /* Open log file, overwrite on each open. */
-    snprintf(file, FILE_SIZE, LOG_FORMAT, id);
-    if ((log = fopen(file, "w")) == NULL)
-        lib_error("MAIN: Could not open log file.");
+    /* Determine the dimension of the cube, one bucket per task. */
+    dimension = determine_dimension(world);
+    if (dimension == 0)
+        lib_error("MAIN: This hypercube program only supports running with 2, 4 or 8 processors.");
 
-    /* Protection from invalid use. */
-    if (argc < 3)
+    /* Get the work amount from command for each process, then the optional generate arguments. */
+    if (argc < 2)
         lib_error("MAIN: Bad usage, see top of respective c file.");
-
-    /* Get the work amount from command for each process. */
-    num_proc = atoi(*++argv);
-    root_size = num_proc * world;
-
-    /* Root only work, ensure good usage and proper input. */
+    num_per_proc = atoi(argv[1]);
+    root_size = num_per_proc * world;
+    generate = argc >= 3 && strcmp(argv[2], GENERATE_FLAG) == 0;
+    if (generate && argc >= 4 && (dist = lib_gen_parse(argv[3])) < 0)
+        lib_error("MAIN: Unknown distribution, see top of respective c file.");
+    if (generate && argc >= 5)
+        seed = strtoull(argv[4], NULL, 10);
+    if (splitters == NULL)
+        splitters = SPLITTERS_SAMPLE;
+    if (strcmp(splitters, SPLITTERS_SAMPLE) != 0 && strcmp(splitters, SPLITTERS_SKETCH) != 0)
+        lib_error("MAIN: Unknown QSPLITTERS, see top of respective c file.");
+
+    /* Root only work, ensure good usage and proper input. Generated input never goes through root. */
     if (id == ROOT) {
         /* Allocate the whole array on the heap, large amount of memory likely wouldn't fit on stack. */
         root = (int *)malloc(root_size * sizeof(int));
-        if (root == NULL)
+        counts = (int *)malloc(world * sizeof(int));
+        displs = (int *)malloc(world * sizeof(int));
+        if (root == NULL || counts == NULL || displs == NULL)
             lib_error("MAIN: Can't allocate root_vals array on heap.");
 
-        /* If requested, generate new input file. */
-        if (strcmp(*++argv, GENERATE_FLAG) == 0) {
-            lib_generate_numbers(root, root_size);
-            lib_write_file(INPUT, root, root_size);
-        }
-
-        /* Read back input from file into array on heap. */
-        lib_read_file(INPUT, root, root_size);
+        /* Read input from file into array on heap. */
+        if (!generate)
+            lib_read_file(INPUT, root, root_size);
     }
+    lib_prof_lap(PROF_READ);
 
-    /*
-     * Allocate a recv buf of root_size (though not likely needed) and a local size of n/p.
-     * The recv buf accounts for the unlikely but possible lop sideded partitioning.
-     */
-    recv_size = num_proc * GATHER_SCALE;
-    local_size = num_proc;
-    recv = (int *)malloc(recv_size * sizeof(int));
-    if (recv == NULL)
-        lib_error("MAIN: Can't allocate recv array on heap.");
-
-    local = (int *)malloc(local_size * sizeof(int));
+    /* Local is replaced by the exchange, start as num_per_proc. */
+    local_size = num_per_proc;
+    local = (int *)malloc((local_size > 0 ? local_size : 1) * sizeof(int));
     if (local == NULL)
         lib_error("MAIN: Can't allocate local array on heap.");
 
-    /* Scatter across the processes and then do hyper quicksort algorithm. */
-    MPI_Scatter(root, num_proc, MPI_INT, local, local_size, MPI_INT, ROOT, MPI_COMM_WORLD);
-
-#ifdef QDEBUG
-    lib_trace_array(log, "SCATTER", local, local_size);
-#endif
-
-    /* Rearrange the cube so that each processor has data strictly less than one with higher number.*/
-    hyper_quicksort(MAX_DIM, id, &local, &local_size, recv, recv_size);
-
-#ifdef QDEBUG
-    lib_trace_array(log, "HYPER", local, local_size);
-#endif
-
-    /*
-     * Reallocated root to be rescaled, mpi_gather doesn't know how many per process anymore.
-     * Set values to -1.
-     */
+    /* Each process generates its own share, else scatter across the processes. */
+    if (generate) {
+        lib_gen_params(&params, dist, seed, (long)root_size, world);
+        lib_gen_share(params.total, id, world, &offset, &count);
+        lib_gen_fill(&params, local, offset, count);
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        MPI_Scatter(root, num_per_proc, MPI_INT, local, local_size, MPI_INT, ROOT, MPI_COMM_WORLD);
+        lib_prof_lap(PROF_SCATTER);
+    }
+    TRACE_ARRAY(TRACE_SCATTER, local, local_size);
+
+    /* All pivots at once, from root's sample of every task's medians or from the merged sketches. */
+    lib_prof_round(0);
+    if (strcmp(splitters, SPLITTERS_SKETCH) == 0)
+        lib_sketch_splitters(MPI_COMM_WORLD, dimension, local, local_size, tree);
+    else
+        lib_sample_splitters(MPI_COMM_WORLD, dimension, local, local_size, tree);
+    lib_prof_lap(PROF_PIVOT_SELECT);
+    for (int i = 0; id == ROOT && i < world-1; ++i)
+        TRACE_EVENT(TRACE_PIVOT, 0, i, tree[i], 0);
+
+    /* One classification pass and one all to all, each task then holds only its own bucket. */
+    lib_bucket_exchange(MPI_COMM_WORLD, tree, dimension, &local, &local_size);
+    lib_prof_bytes((long)local_size * sizeof(int), (long)local_size * sizeof(int));
+    lib_prof_lap(PROF_EXCHANGE);
+
+    TRACE_ARRAY(TRACE_HYPER, local, local_size);
+
+    /* Sort local array, introsort with network base cases (lib_sort). */
+    lib_sort(local, local_size);
+    lib_prof_lap(PROF_LOCAL_SORT);
+
+    /* Bucket sizes are uneven, gather them first so root can place each process exactly. */
+    MPI_Gather(&local_size, 1, MPI_INT, counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
     if (id == ROOT) {
-        free(root);
-        root_size *= GATHER_SCALE;
-        root = (int *)malloc(root_size * sizeof(int));
-        if (root == NULL)
-            lib_error("MAIN: Can't allocate root array on heap.");
-        memset(root, -1, root_size * sizeof(int));
+        displs[0] = 0;
+        for (int i = 1; i < world; ++i)
+            displs[i] = displs[i-1] + counts[i-1];
     }
 
-    /* Quicksort local array and then send back to root. */
-    qsort(local, local_size, sizeof(int), lib_compare);
-    MPI_Gather(local, local_size, MPI_INT, root, GATHER_SCALE*num_proc, MPI_INT, ROOT, MPI_COMM_WORLD);
+    /* Send back to root. Then write to file. */
+    MPI_Gatherv(local, local_size, MPI_INT, root, counts, displs, MPI_INT, ROOT, MPI_COMM_WORLD);
+    lib_prof_lap(PROF_GATHER);
 
-	/* Last step, root has to compress array due to uneven nature after gather. Then write to file. */
     if (id == ROOT) {
-        lib_compress_array(world, root, root_size);
+        TRACE_ARRAY(TRACE_GATHER, root, root_size);
 
-#ifdef QDEBUG
-        lib_trace_array(log, "GATHER", root, root_size/GATHER_SCALE);
-#endif
-
-        lib_write_file(OUTPUT, root, root_size/GATHER_SCALE);
+        lib_write_file(OUTPUT, root, root_size);
+        lib_prof_lap(PROF_WRITE);
         printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
         free(root);
+        free(counts);
+        free(displs);
     }
 
-    free(recv);
-    /* May have been entirely deallocated if has no more at process. */
-    if (local != NULL)
-        free(local);
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qParallelRound");
+
+    free(local);
 
-    fclose(log);
+    lib_trace_close();
 
     MPI_Finalize();
 
@@ -0,0 +1,163 @@
+/**
+ * Exact percentiles of a distributed input without sorting it. All requested percentiles are answered by one
+ * distributed multiselect, see lib_dist_multiselect in dist_ops.c. No values move between tasks, each round
+ * agrees on a pivot, partitions in place and sums the counts, so only a few ints per round cross the network.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qPercentile <numbers> <percentiles> <mode> <dist> <seed>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works.
+ * numbers: Amount of integers per task, total integers is tasks * numbers.
+ * percentiles: Comma separated percentiles between 0 and 100, like 50,90,99,99.9.
+ *      Percentile p is the value of rank ceil(p/100 * total) in sorted order, the smallest value for 0.
+ * mode: Flag that optionally makes every task generate its own share of the input in memory.
+ *      -> Use "gen" to generate new input, input.txt is not read.
+ *      -> To read from input.txt, simply omit 'mode'.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen, the same seed gives the same input on any number of tasks.
+ *
+ * Example p50, p90, p99 and p99.9 of 10000000 generated zipf numbers per process, 8 process.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qPercentile 10000000 50,90,99,99.9 gen zipf
+ *
+ * Root prints one line per percentile. Profile works as in qParallel, each select round is a round.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "prof_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Most percentiles in one query. */
+#define MAX_PERCENTILES		64
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Parse a comma separated list of percentiles into percents, returns how many.
+ */
+int parse_percentiles(const char *list, double percents[]) {
+    int count = 0;
+    char *end = NULL;
+
+    while (*list != '\0') {
+        if (count == MAX_PERCENTILES)
+            lib_error("MAIN: Too many percentiles, see top of respective c file.");
+        percents[count] = strtod(list, &end);
+        if (end == list || percents[count] < 0 || percents[count] > 100)
+            lib_error("MAIN: Bad percentile, see top of respective c file.");
+        ++count;
+        list = *end == ',' ? end+1 : end;
+    }
+
+    return count;
+}
+
+/*
+ * Rank in sorted order, counting from 1, of percentile p of total values.
+ */
+long percentile_rank(const double p, const long total) {
+    long rank = (long)ceil(p / 100.0 * total);
+
+    return rank < 1 ? 1 : (rank > total ? total : rank);
+}
+
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, num_per_proc = 0, root_size = 0, count = 0;
+    int generate = 0, dist = GEN_RANGE;
+    int *root = NULL, *local = NULL;
+    int answers[MAX_PERCENTILES];
+    double percents[MAX_PERCENTILES];
+    long kths[MAX_PERCENTILES];
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    long offset = 0, share = 0;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank and size too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    lib_prof_init();
+
+    /* Get the work amount and percentiles from command, then the optional generate arguments. */
+    if (argc < 3)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+    num_per_proc = atoi(argv[1]);
+    root_size = num_per_proc * world;
+    count = parse_percentiles(argv[2], percents);
+    generate = argc >= 4 && strcmp(argv[3], GENERATE_FLAG) == 0;
+    if (generate && argc >= 5 && (dist = lib_gen_parse(argv[4])) < 0)
+        lib_error("MAIN: Unknown distribution, see top of respective c file.");
+    if (generate && argc >= 6)
+        seed = strtoull(argv[5], NULL, 10);
+    if (root_size < 1)
+        lib_error("MAIN: Need at least one number for a percentile.");
+
+    /* Root reads the input file, generated input never goes through root. */
+    if (id == ROOT && !generate) {
+        if ((root = (int *)malloc(root_size * sizeof(int))) == NULL)
+            lib_error("MAIN: Can't allocate root_vals array on heap.");
+        lib_read_file(INPUT, root, root_size);
+    }
+    lib_prof_lap(PROF_READ);
+
+    local = (int *)malloc((num_per_proc > 0 ? num_per_proc : 1) * sizeof(int));
+    if (local == NULL)
+        lib_error("MAIN: Can't allocate local array on heap.");
+
+    /* Each process generates its own share, else scatter across the processes. */
+    if (generate) {
+        lib_gen_params(&params, dist, seed, (long)root_size, world);
+        lib_gen_share(params.total, id, world, &offset, &share);
+        lib_gen_fill(&params, local, offset, share);
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        MPI_Scatter(root, num_per_proc, MPI_INT, local, num_per_proc, MPI_INT, ROOT, MPI_COMM_WORLD);
+        lib_prof_lap(PROF_SCATTER);
+    }
+
+    /* Every percentile in one multiselect. */
+    for (int i = 0; i < count; ++i)
+        kths[i] = percentile_rank(percents[i], (long)root_size);
+    lib_dist_multiselect(MPI_COMM_WORLD, local, num_per_proc, kths, count, answers);
+
+    if (id == ROOT) {
+        for (int i = 0; i < count; ++i)
+            printf("p%g: %d\n", percents[i], answers[i]);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+        free(root);
+    }
+
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qPercentile");
+
+    free(local);
+
+    MPI_Finalize();
+
+    return 0;
+}
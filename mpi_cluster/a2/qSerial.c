@@ -74,8 +74,8 @@ int main(int argc, char **argv) {
 		/* Read back input from file into array on heap. */
 		lib_read_file(INPUT, vals, num_vals);
 
-		/* Sort and output to file. */
-		qsort(vals, num_vals, sizeof(int), lib_compare);
+		/* Sort and output to file, sorted or nearly sorted input costs about one pass. */
+		lib_adaptive_sort(vals, num_vals);
 		lib_write_file(OUTPUT, vals, num_vals);
 
 		free(vals);
@@ -0,0 +1,171 @@
+/**
+ * Sort driver that picks the parallel sort itself. It measures the input and the machine first, the key range,
+ * an estimate of distinct keys, how far from sorted the input is and how many tasks share a node, then runs
+ * local only, counting, bitonic, sample sort or the hypercube, whichever suits, see auto_ops.c.
+ *
+ * Use command: bsub -I -q COMP428 -n <tasks> mpirun -srun ./demo/qSort <numbers> <mode> <dist> <seed>
+ *
+ * Arguments:
+ * tasks: The amount of number of processes to start, any count works. Counts that aren't a power of two
+ *      fold the extra tasks onto the largest power of two for the hypercube sorts, those end empty.
+ * numbers: Amount of integers per task, total integers is tasks * numbers.
+ * mode: Flag that optionally makes every task generate its own share of the input in memory.
+ *      -> Use "gen" to generate new input, input.txt is neither read nor written.
+ *      -> To read from input.txt, simply omit 'mode'.
+ * dist: Optional distribution for gen, defaults to range. See qGenerate.c for the list.
+ * seed: Optional seed for gen, the same seed gives the same input on any number of tasks.
+ *
+ * Example 1000000 uniform numbers per process, 8 process.
+ * Use command: bsub -I -q COMP428 -n 8 mpirun -srun ./demo/qSort 1000000 gen uniform
+ *
+ * Input and output are as for qParallel, output.txt holds all numbers in increasing order.
+ *
+ * Override:
+ * Set QALGO when starting to skip the choice, the measurements are still printed.
+ *      -> auto, the default.
+ *      -> local, count, bitonic, sample or hyper, see lib_auto_sort for what each needs.
+ *
+ * Root prints the measurements and the strategy before sorting. Profile works as in qParallel, the
+ * measurements count as pivot select and the whole sort as the exchange.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+#include "prof_ops.h"
+#include "auto_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Environment variable overriding the strategy, see Override above. */
+#define ALGO_ENV			"QALGO"
+#define ALGO_AUTO			"auto"
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    int id = 0, world = 0, num_per_proc = 0, root_size = 0, local_size = 0, generate = 0, dist = GEN_RANGE;
+    int algo = 0;
+    const char *algo_env = getenv(ALGO_ENV);
+    int *root = NULL, *local = NULL, *counts = NULL, *displs = NULL;
+    uint64_t seed = GEN_SEED;
+    gen_params_t params;
+    auto_stats_t stats;
+    long offset = 0, count = 0;
+    double start = 0.0;
+
+    /* Standard init for MPI, start timer after init. Get rank and size too. */
+    MPI_Init(&argc, &argv);
+    start = MPI_Wtime();
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    lib_prof_init();
+
+    /* Get the work amount from command for each process, then the optional generate arguments. */
+    if (argc < 2)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+    num_per_proc = atoi(argv[1]);
+    root_size = num_per_proc * world;
+    generate = argc >= 3 && strcmp(argv[2], GENERATE_FLAG) == 0;
+    if (generate && argc >= 4 && (dist = lib_gen_parse(argv[3])) < 0)
+        lib_error("MAIN: Unknown distribution, see top of respective c file.");
+    if (generate && argc >= 5)
+        seed = strtoull(argv[4], NULL, 10);
+    if (algo_env != NULL && strcmp(algo_env, ALGO_AUTO) != 0 && lib_auto_parse(algo_env) < 0)
+        lib_error("MAIN: Unknown QALGO, see top of respective c file.");
+
+    /* Root only work, generated input never goes through root. */
+    if (id == ROOT) {
+        root = (int *)malloc((root_size > 0 ? root_size : 1) * sizeof(int));
+        counts = (int *)malloc(world * sizeof(int));
+        displs = (int *)malloc(world * sizeof(int));
+        if (root == NULL || counts == NULL || displs == NULL)
+            lib_error("MAIN: Can't allocate root_vals array on heap.");
+
+        if (!generate)
+            lib_read_file(INPUT, root, root_size);
+    }
+    lib_prof_lap(PROF_READ);
+
+    local_size = num_per_proc;
+    if ((local = (int *)malloc((local_size > 0 ? local_size : 1) * sizeof(int))) == NULL)
+        lib_error("MAIN: Can't allocate local array on heap.");
+
+    if (generate) {
+        lib_gen_params(&params, dist, seed, (long)root_size, world);
+        lib_gen_share(params.total, id, world, &offset, &count);
+        lib_gen_fill(&params, local, offset, count);
+        lib_prof_lap(PROF_GENERATE);
+    } else {
+        MPI_Scatter(root, num_per_proc, MPI_INT, local, local_size, MPI_INT, ROOT, MPI_COMM_WORLD);
+        lib_prof_lap(PROF_SCATTER);
+    }
+
+    /* Measure, then choose unless told. */
+    lib_auto_stats(MPI_COMM_WORLD, local, local_size, &stats);
+    if (algo_env != NULL && strcmp(algo_env, ALGO_AUTO) != 0)
+        algo = lib_auto_parse(algo_env);
+    else
+        algo = lib_auto_choose(&stats);
+    lib_prof_lap(PROF_PIVOT_SELECT);
+
+    if (id == ROOT) {
+        printf("Total %ld on %d tasks, at most %d per node, %s.\n", stats.total, stats.world, stats.per_node,
+                stats.even ? "even" : "uneven");
+        printf("Range %ld, about %.0f distinct of %ld sampled, %.4f of neighbours out of order.\n",
+                stats.range, stats.distinct, stats.sampled, stats.disorder);
+        printf("Sorting with %s%s.\n", lib_auto_name(algo), algo_env != NULL && strcmp(algo_env, ALGO_AUTO) != 0 ?
+                " (QALGO)" : "");
+    }
+
+    lib_auto_sort(MPI_COMM_WORLD, algo, &local, &local_size);
+    lib_prof_lap(PROF_EXCHANGE);
+
+    /* Sizes are uneven after most strategies, gather them first so root can place each process exactly. */
+    MPI_Gather(&local_size, 1, MPI_INT, counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+    if (id == ROOT) {
+        displs[0] = 0;
+        for (int i = 1; i < world; ++i)
+            displs[i] = displs[i-1] + counts[i-1];
+    }
+    MPI_Gatherv(local, local_size, MPI_INT, root, counts, displs, MPI_INT, ROOT, MPI_COMM_WORLD);
+    lib_prof_lap(PROF_GATHER);
+
+    if (id == ROOT) {
+        lib_write_file(OUTPUT, root, root_size);
+        lib_prof_lap(PROF_WRITE);
+        printf("Time elapsed from MPI_Init to MPI_Finalize is %.10f seconds.\n", MPI_Wtime() - start);
+        free(root);
+        free(counts);
+        free(displs);
+    }
+
+    /* Min, max and mean of each phase over all processes. */
+    lib_prof_report(MPI_COMM_WORLD, PROF_REPORT, "qSort");
+
+    free(local);
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * Offline decoder for the binary traces. A run started with QTRACE=1 leaves trace.<rank>.bin per task,
+ * this renders each into log.<rank>.txt in the same text format the old compile time logging wrote.
+ *
+ * Use command: ./demo/qTrace <tasks>
+ *
+ * Arguments:
+ * tasks: The number of tasks of the traced run, decodes ranks 0 to tasks-1. Missing traces are skipped.
+ *
+ * Example trace a run of 4 tasks, then decode.
+ * Use command: QTRACE=1 mpirun -n 4 ./demo/qParallel 1000 gen
+ * Use command: ./demo/qTrace 4
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Project Headers */
+#include "array_ops.h"
+#include "trace_ops.h"
+
+/******************* Constants/Macros *********************/
+#define NAME_SIZE           64
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Main execution body.
+ */
+int main(int argc, char **argv) {
+    char input[NAME_SIZE], output[NAME_SIZE];
+    FILE *f;
+    long records = 0;
+
+    /* Protection from invalid use. */
+    if (argc < 2)
+        lib_error("MAIN: Bad usage, see top of respective c file.");
+
+    for (int rank = 0; rank < atoi(argv[1]); ++rank) {
+        snprintf(input, NAME_SIZE, TRACE_FORMAT, rank);
+        snprintf(output, NAME_SIZE, TRACE_LOG_FORMAT, rank);
+
+        /* Tracing may have been off or the task may have died before exit. */
+        if ((f = fopen(input, "rb")) == NULL) {
+            printf("No trace for rank %d.\n", rank);
+            continue;
+        }
+        fclose(f);
+
+        records = lib_trace_decode(input, output);
+        printf("Decoded %ld records into %s.\n", records, output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+/**
+ * Tests for the distributed aggregation. Run under mpirun with a few tasks, any count works.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+#include "typed_ops.h"
+#include "agg_ops.h"
+
+/******************* Constants/Macros *********************/
+#define PER_RANK		2000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Aggregate size records per rank from dist over [0, range), 0 keeps the default, and check the rows at root
+ * against sorting everything.
+ */
+static void check_aggregate(const gen_dist_t dist, const int range, const int size) {
+    gen_params_t params;
+    kv64_t *vals = malloc((size > 0 ? size : 1) * sizeof(kv64_t)), *all = NULL;
+    agg_row_t *rows = NULL, *expect = NULL, *got = NULL;
+    int total = 0, first = 0, count = 0, expect_size = 0, ok = 1, *counts = NULL, *displs = NULL;
+    int64_t prev = INT64_MIN, last = INT64_MIN, below = INT64_MIN;
+    MPI_Datatype row_type;
+
+    /* Ranks may hold different amounts, each takes the slice after every lower rank's. */
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    MPI_Allreduce(&size, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Exscan(&size, &first, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    lib_gen_params(&params, dist, 21, (long)total, world);
+    if (range > 0) {
+        params.range = range;
+        params.unique = params.unique < range ? params.unique : range;
+    }
+    lib_gen_fill_kv64(&params, vals, id > 0 ? first : 0, size);
+
+    if (id == ROOT) {
+        all = malloc((total > 0 ? total : 1) * sizeof(kv64_t));
+        expect = malloc((total > 0 ? total : 1) * sizeof(agg_row_t));
+        got = malloc((total > 0 ? total : 1) * sizeof(agg_row_t));
+        counts = malloc(2 * world * sizeof(int));
+        CU_ASSERT_FATAL(all != NULL && expect != NULL && got != NULL && counts != NULL);
+        displs = counts + world;
+    }
+    MPI_Gather(&size, 1, MPI_INT, counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+    if (id == ROOT) {
+        for (int r = 0; r < world; ++r)
+            displs[r] = r == 0 ? 0 : displs[r-1] + counts[r-1];
+    }
+    MPI_Gatherv(vals, size, lib_mpi_type_kv64(), all, counts, displs, lib_mpi_type_kv64(), ROOT, MPI_COMM_WORLD);
+
+    count = lib_aggregate(MPI_COMM_WORLD, vals, size, &rows);
+
+    /* Keys increase within each rank. */
+    for (int i = 0; i < count; ++i) {
+        ok &= prev < rows[i].key;
+        prev = rows[i].key;
+    }
+
+    /* Every rank's rows at root, in rank order. */
+    MPI_Type_contiguous(3, MPI_INT64_T, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+    if (id == ROOT) {
+        for (int r = 0; r < world; ++r)
+            displs[r] = r == 0 ? 0 : displs[r-1] + counts[r-1];
+    }
+    MPI_Gatherv(rows, count, row_type, got, counts, displs, row_type, ROOT, MPI_COMM_WORLD);
+    MPI_Type_free(&row_type);
+
+    if (id == ROOT) {
+        lib_sort_kv64(all, total);
+        expect_size = lib_agg_combine(all, total, expect);
+        CU_ASSERT(displs[world-1] + counts[world-1] == expect_size);
+        CU_ASSERT(memcmp(got, expect, expect_size * sizeof(agg_row_t)) == 0);
+    }
+
+    /* A later rank's first key must beat every earlier rank's last. */
+    last = count > 0 ? rows[count-1].key : INT64_MIN;
+    MPI_Exscan(&last, &below, 1, MPI_INT64_T, MPI_MAX, MPI_COMM_WORLD);
+    if (id > 0 && count > 0)
+        ok &= below < rows[0].key;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    CU_ASSERT(ok);
+
+    free(vals);
+    free(rows);
+    free(all);
+    free(expect);
+    free(got);
+    free(counts);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Runs of equal keys fold into one row, counts and payloads summed.
+ */
+void test_agg_combine(void) {
+    const kv64_t vals[] = {{-3, 1}, {-3, 2}, {0, 5}, {7, 1}, {7, 1}, {7, -4}};
+    agg_row_t rows[6];
+
+    CU_ASSERT_FATAL(lib_agg_combine(vals, 6, rows) == 3);
+    CU_ASSERT(rows[0].key == -3 && rows[0].count == 2 && rows[0].sum == 3);
+    CU_ASSERT(rows[1].key == 0 && rows[1].count == 1 && rows[1].sum == 5);
+    CU_ASSERT(rows[2].key == 7 && rows[2].count == 3 && rows[2].sum == -2);
+    CU_ASSERT(lib_agg_combine(vals, 0, rows) == 0);
+}
+
+/*
+ * Keys in a small range go through the histogram, heavy duplicates included.
+ */
+void test_agg_histogram(void) {
+    check_aggregate(GEN_RANGE, PER_RANK, PER_RANK);
+    check_aggregate(GEN_ZIPF, PER_RANK, PER_RANK);
+    check_aggregate(GEN_FEW_UNIQUE, PER_RANK / 3, PER_RANK / 3);
+}
+
+/*
+ * A range within AGG_RANGE but wider than the number of keys goes through the sort, even a few keys per rank.
+ */
+void test_agg_sparse(void) {
+    check_aggregate(GEN_RANGE, AGG_RANGE / 2, 2);
+    check_aggregate(GEN_RANGE, AGG_RANGE, 1);
+    check_aggregate(GEN_RANGE, 4 * world, id == 0 ? 3 : 1);
+}
+
+/*
+ * Keys over the whole int range go through the sort, and nothing anywhere gives no rows.
+ */
+void test_agg_sort(void) {
+    check_aggregate(GEN_UNIFORM, 0, PER_RANK);
+    check_aggregate(GEN_UNIFORM, 0, id % 2 == 0 ? 0 : PER_RANK);
+    check_aggregate(GEN_UNIFORM, 0, 0);
+}
+
+/*
+ * The merged estimate is within a few standard errors of the true distinct count, duplicates ignored.
+ */
+void test_hll(void) {
+    hll_t hll;
+    const long distinct = 50000L;
+    double estimate = 0.0;
+
+    /* Every rank counts an overlapping window, together exactly the keys 0 .. distinct-1. */
+    lib_hll_init(&hll);
+    for (long k = (long)id * distinct / world; k < distinct; ++k)
+        lib_hll_add(&hll, k * 7919);
+    lib_hll_allreduce(MPI_COMM_WORLD, &hll);
+    estimate = lib_hll_estimate(&hll);
+    CU_ASSERT(fabs(estimate - distinct) < 0.05 * distinct);
+
+    /* Small counts use linear counting and are near exact. */
+    lib_hll_init(&hll);
+    for (int k = 0; k < 100; ++k)
+        lib_hll_add(&hll, k);
+    CU_ASSERT(fabs(lib_hll_estimate(&hll) - 100) < 5);
+
+    lib_hll_init(&hll);
+    CU_ASSERT(lib_hll_estimate(&hll) == 0.0);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite aggSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   aggSuite = CU_add_suite("Distributed Aggregate Suite", suite_init, suite_clean);
+   if (NULL == aggSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(aggSuite, "Combine.....................", test_agg_combine)) ||
+       (NULL == CU_add_test(aggSuite, "Aggregate: Histogram........", test_agg_histogram)) ||
+       (NULL == CU_add_test(aggSuite, "Aggregate: Sparse Range.....", test_agg_sparse)) ||
+       (NULL == CU_add_test(aggSuite, "Aggregate: Sort.............", test_agg_sort)) ||
+       (NULL == CU_add_test(aggSuite, "HyperLogLog.................", test_hll))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
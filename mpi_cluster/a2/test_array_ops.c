@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <time.h>
 
 /* Project Headers */
@@ -16,6 +17,8 @@
 /******************* Constants/Macros *********************/
 #define TEMP_FILE 		"temp.txt"
 #define VALS_SIZE		20
+#define BIG_SIZE		5000
+#define SKETCH_SIZE		200000
 
 /******************* Type Definitions *********************/
 
@@ -23,8 +26,92 @@
 /**************** Static Data Definitions *****************/
 static int vals_orig[] = {62, 58, 41, 85, 39, 10, 64, 69, 41, 5, 98, 27, 2, 97, 30, 22, 39, 94, 56, 21};
 static int vals[VALS_SIZE];
+static int big[BIG_SIZE];
+static int stream[SKETCH_SIZE];
+static quantile_sketch_t sketch, other;
 
 /****************** Static Functions **********************/
+/*
+ * Fill big with random values, sum returned to check nothing was lost by a partition.
+ */
+static long fill_big(void) {
+    long sum = 0;
+
+    for (int i = 0; i < BIG_SIZE; ++i) {
+        big[i] = rand() % 1000 - 500;
+        sum += big[i];
+    }
+
+    return sum;
+}
+
+/*
+ * Check big is partitioned around pivot at lt_size, and still has the same sum.
+ */
+static void check_big_partition(int pivot, int lt_size, long sum) {
+    for (int i = 0; i < BIG_SIZE; ++i) {
+        sum -= big[i];
+        if (i < lt_size)
+            CU_ASSERT_FATAL(big[i] <= pivot)
+        else
+            CU_ASSERT_FATAL(big[i] > pivot);
+    }
+
+    CU_ASSERT(sum == 0);
+}
+
+/*
+ * Partition big by value with the given kernel.
+ */
+static void run_big_partition_val(partition_kernel_t kernel) {
+    int lt_size = 0, gt_size = 0, pivot = 0;
+    long sum = 0;
+    const partition_kernel_t chosen = lib_partition_init(kernel);
+
+    /* Avx2 falls back to the block kernel on cpus without it, nothing else changes the request. */
+    CU_ASSERT(chosen == kernel || (kernel == PARTITION_AVX2 && chosen == PARTITION_BLOCK));
+    for (int round = 0; round < 20; ++round) {
+        sum = fill_big();
+        pivot = rand() % 1200 - 600;
+        lib_partition_by_pivot_val(pivot, big, BIG_SIZE, &lt_size, &gt_size);
+
+        CU_ASSERT(lt_size + gt_size == BIG_SIZE);
+        check_big_partition(pivot, lt_size, sum);
+    }
+    CU_ASSERT(lib_partition_init(PARTITION_AUTO) != PARTITION_AUTO);
+}
+
+/*
+ * Every percentile of sketch lands within 1% of its true rank in the sorted stream of size values.
+ */
+static void check_sketch_ranks(const quantile_sketch_t *s, const int size) {
+    double qs[99];
+    int out[99], *sorted = malloc(size * sizeof(int));
+    long lo = 0, hi = 0, want = 0;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(sorted, NULL);
+    memcpy(sorted, stream, size * sizeof(int));
+    qsort(sorted, size, sizeof(int), lib_compare);
+
+    for (int i = 0; i < 99; ++i)
+        qs[i] = (i+1) / 100.0;
+    lib_sketch_quantiles(s, qs, 99, out);
+
+    /* Duplicates give a value a band of ranks, the wanted rank only has to be near the band. */
+    for (int i = 0; i < 99; ++i) {
+        want = (long)(qs[i] * size);
+        lo = 0;
+        while (lo < size && sorted[lo] < out[i])
+            ++lo;
+        hi = lo;
+        while (hi < size && sorted[hi] == out[i])
+            ++hi;
+        CU_ASSERT(hi > lo);
+        CU_ASSERT(want >= lo - size / 100 && want <= hi + size / 100);
+    }
+
+    free(sorted);
+}
 
 
 /**************** Global Data Definitions *****************/
@@ -71,6 +158,15 @@ void test_compare_more(void) {
     CU_ASSERT(lib_compare(&a, &b) > 0);
 }
 
+/*
+ * Compare function, values far apart must not overflow.
+ */
+void test_compare_extremes(void) {
+    int a = INT_MIN, b = INT_MAX;
+    CU_ASSERT(lib_compare(&a, &b) < 0);
+    CU_ASSERT(lib_compare(&b, &a) > 0);
+}
+
 /*
  * Test pivot selection, case where numbers are odd.
  */
@@ -139,6 +235,158 @@ void test_partition_by_val(void) {
         CU_ASSERT(orig_data[i] == expected_data[i]);
 }
 
+/*
+ * Scan used to miss the last element when every value was <= pivot.
+ */
+void test_partition_by_val_all_less(void) {
+    int data[] = {1, 2, 3}, lt = 0, gt = 0;
+
+    lib_partition_by_pivot_val(10, data, 3, &lt, &gt);
+
+    CU_ASSERT(lt == 3);
+    CU_ASSERT(gt == 0);
+}
+
+/*
+ * Partition a large array by value with each of the kernels.
+ */
+void test_partition_by_val_block(void) {
+    run_big_partition_val(PARTITION_BLOCK);
+}
+
+void test_partition_by_val_avx2(void) {
+    run_big_partition_val(PARTITION_AVX2);
+}
+
+/*
+ * Partition a large array around one of its elements, pivot must end up at returned index.
+ */
+void test_partition_by_index_big(void) {
+    int index = 0, pivot = 0, pos = 0;
+    long sum = 0;
+
+    for (int round = 0; round < 20; ++round) {
+        sum = fill_big();
+        index = rand() % BIG_SIZE;
+        pivot = big[index];
+        pos = lib_partition_by_pivot_index(index, big, big+BIG_SIZE-1);
+
+        CU_ASSERT(big[pos] == pivot);
+        check_big_partition(pivot, pos+1, sum);
+    }
+}
+
+/*
+ * Three way partition of a large array with heavy duplicates, small and large pivots included.
+ */
+void test_partition3_by_val(void) {
+    int pivots[] = {INT_MIN, -600, -3, 0, 7, 600};
+    int lt_size = 0, eq_size = 0, gt_size = 0, ok = 1;
+
+    for (int p = 0; p < (int)(sizeof(pivots)/sizeof(pivots[0])); ++p) {
+        for (int i = 0; i < BIG_SIZE; ++i)
+            big[i] = rand() % 20 - 10;
+        lib_partition3_by_pivot_val(pivots[p], big, BIG_SIZE, &lt_size, &eq_size, &gt_size);
+
+        CU_ASSERT(lt_size + eq_size + gt_size == BIG_SIZE);
+        for (int i = 0; i < BIG_SIZE; ++i) {
+            if (i < lt_size)
+                ok &= big[i] < pivots[p];
+            else if (i < lt_size + eq_size)
+                ok &= big[i] == pivots[p];
+            else
+                ok &= big[i] > pivots[p];
+        }
+    }
+    CU_ASSERT(ok);
+}
+
+/*
+ * Equal band is split so partners end up even, both sides agree on what crosses.
+ */
+void test_split_equal(void) {
+    int low[3] = {10, 100, 0}, high[3] = {0, 50, 20};
+    int keep_from = 0, keep_size = 0, send_from = 0, send_size = 0;
+    int low_keep = 0, low_send = 0, high_keep = 0, high_send = 0;
+
+    /* 180 in total, lower should end with 90: its 10 lt plus 80 of its own equal keys. */
+    lib_split_equal(low, high, 0, &keep_from, &keep_size, &send_from, &send_size);
+    CU_ASSERT(keep_from == 0 && keep_size == 90);
+    CU_ASSERT(send_from == 90 && send_size == 20);
+    low_keep = keep_size;
+    low_send = send_size;
+
+    lib_split_equal(high, low, 1, &keep_from, &keep_size, &send_from, &send_size);
+    CU_ASSERT(send_from == 0 && send_size == 0);
+    CU_ASSERT(keep_from == 0 && keep_size == 70);
+    high_keep = keep_size;
+    high_send = send_size;
+    CU_ASSERT(low_keep + high_send == high_keep + low_send);
+
+    /* Lower has no equal keys and little else, upper gives it part of its band. */
+    low[0] = 5; low[1] = 0; low[2] = 5;
+    high[0] = 5; high[1] = 40; high[2] = 5;
+    lib_split_equal(high, low, 1, &keep_from, &keep_size, &send_from, &send_size);
+    CU_ASSERT(send_from == 0 && send_size == 5 + 20);
+    CU_ASSERT(keep_from == 25 && keep_size == 25);
+
+    /* No equal keys, plain two way split. */
+    low[0] = 30; low[1] = 0; low[2] = 10;
+    lib_split_equal(low, low, 0, &keep_from, &keep_size, &send_from, &send_size);
+    CU_ASSERT(keep_size == 30 && send_from == 30 && send_size == 10);
+}
+
+/*
+ * Classify against a two level tree, buckets come out grouped and in bucket order.
+ * Tree is 50 at the root, 20 and 80 below, so buckets are <= 20, <= 50, <= 80 and above.
+ */
+void test_classify(void) {
+    int tree[3] = {50, 20, 80};
+    int vals[13] = {90, 20, 21, 50, 5, 81, 80, 51, 100, -3, 49, 50, 79};
+    int out[13], counts[4];
+    int expect[4] = {3, 4, 3, 3};
+
+    lib_classify(tree, 2, vals, 13, counts, out);
+    for (int b = 0; b < 4; ++b)
+        CU_ASSERT(counts[b] == expect[b]);
+
+    /* Stable within a bucket, the first block is 20, 5, -3. */
+    CU_ASSERT(out[0] == 20 && out[1] == 5 && out[2] == -3);
+    for (int i = 3; i < 7; ++i)
+        CU_ASSERT(out[i] > 20 && out[i] <= 50);
+    for (int i = 7; i < 10; ++i)
+        CU_ASSERT(out[i] > 50 && out[i] <= 80);
+    for (int i = 10; i < 13; ++i)
+        CU_ASSERT(out[i] > 80);
+}
+
+/*
+ * Unrolled and tail paths agree, three levels over many values and an empty tree.
+ */
+void test_classify_big(void) {
+    int tree[7] = {400, 200, 600, 100, 300, 500, 700};
+    int *vals = malloc(BIG_SIZE * sizeof(int)), *out = malloc(BIG_SIZE * sizeof(int));
+    int counts[8], pos = 0;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(out, NULL);
+    for (int i = 0; i < BIG_SIZE; ++i)
+        vals[i] = (i * 7919) % 800;
+
+    lib_classify(tree, 3, vals, BIG_SIZE - 3, counts, out);
+    for (int b = 0; b < 8; ++b) {
+        for (int i = 0; i < counts[b]; ++i, ++pos)
+            CU_ASSERT((b == 0 || out[pos] > b*100) && (b == 7 || out[pos] <= (b+1)*100));
+    }
+    CU_ASSERT(pos == BIG_SIZE - 3);
+
+    lib_classify(tree, 0, vals, 10, counts, out);
+    CU_ASSERT(counts[0] == 10 && out[9] == vals[9]);
+
+    free(vals);
+    free(out);
+}
+
 /*
  * Test array union, takes two arrays and put them into one larger merged array.
  */
@@ -288,6 +536,239 @@ void test_select_kth(void) {
     CU_ASSERT(pos == e_pos);
 }
 
+/*
+ * Check kth of big against a sorted copy for a few k with the given select function.
+ */
+static void run_big_select(int (*select)(int, int *, int *)) {
+    int sorted[BIG_SIZE], ks[] = {1, 2, BIG_SIZE/3, BIG_SIZE/2, BIG_SIZE-1, BIG_SIZE}, pos = 0;
+
+    for (int j = 0; j < (int)(sizeof(ks)/sizeof(int)); ++j) {
+        fill_big();
+        memcpy(sorted, big, BIG_SIZE*sizeof(int));
+        qsort(sorted, BIG_SIZE, sizeof(int), lib_compare);
+
+        pos = select(ks[j], big, big+BIG_SIZE-1);
+        CU_ASSERT(pos == ks[j]-1);
+        CU_ASSERT(big[pos] == sorted[ks[j]-1]);
+        for (int i = 0; i < BIG_SIZE; ++i)
+            CU_ASSERT_FATAL(i < pos ? big[i] <= big[pos] : big[i] >= big[pos]);
+    }
+}
+
+/*
+ * Floyd-Rivest selection on a large random array.
+ */
+void test_select_floyd_rivest(void) {
+    run_big_select(lib_select_floyd_rivest);
+}
+
+/*
+ * Introselect on a large random array.
+ */
+void test_introselect(void) {
+    run_big_select(lib_introselect);
+}
+
+/*
+ * Introselect on sorted and all equal input, where random pivots have no edge.
+ */
+void test_introselect_adversarial(void) {
+    for (int i = 0; i < BIG_SIZE; ++i)
+        big[i] = i;
+    CU_ASSERT(big[lib_introselect(BIG_SIZE/2, big, big+BIG_SIZE-1)] == BIG_SIZE/2-1);
+
+    for (int i = 0; i < BIG_SIZE; ++i)
+        big[i] = 7;
+    CU_ASSERT(big[lib_introselect(BIG_SIZE/2, big, big+BIG_SIZE-1)] == 7);
+}
+
+/*
+ * A million equal keys, or only three distinct ones, select in linear time. One equal key per pass took
+ * seconds at a tenth of the size.
+ */
+void test_introselect_duplicates(void) {
+    const int size = 1 << 20;
+    int *vals = malloc(size * sizeof(int)), ok = 1;
+    clock_t start = clock();
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    for (int i = 0; i < size; ++i)
+        vals[i] = 7;
+    ok &= vals[lib_introselect(size/2, vals, vals+size-1)] == 7;
+    ok &= vals[lib_introselect(1, vals, vals+size-1)] == 7;
+
+    /* Thirds of 0, 1 and 2, the kth smallest is known. */
+    for (int k = 1; k <= size; k += size/7) {
+        for (int i = 0; i < size; ++i)
+            vals[i] = (int)((long)i * 3 / size);
+        ok &= vals[lib_introselect(k, vals, vals+size-1)] == (int)((long)(k-1) * 3 / size);
+    }
+
+    CU_ASSERT(ok);
+    CU_ASSERT((double)(clock() - start) / CLOCKS_PER_SEC < 1.0);
+
+    free(vals);
+}
+
+/*
+ * Sorting network for five must sort every permutation of five distinct values.
+ */
+void test_sort5(void) {
+    int perm[5], ok = 1;
+
+    for (int code = 0; code < 5*5*5*5*5; ++code) {
+        int c = code, used = 0, dup = 0;
+        for (int i = 0; i < 5; ++i) {
+            perm[i] = c % 5;
+            c /= 5;
+            dup |= used & (1 << perm[i]);
+            used |= 1 << perm[i];
+        }
+        if (dup)
+            continue;
+
+        lib_sort5(perm);
+        for (int i = 0; i < 5; ++i)
+            ok &= perm[i] == i;
+    }
+
+    CU_ASSERT(ok);
+}
+
+/*
+ * By the 0-1 principle a network that sorts every 0/1 input sorts everything, exhaustive up to 20 values.
+ * Larger sizes get random values instead.
+ */
+void test_sort_small(void) {
+    int bits[NETWORK_MAX], ok = 1, ones = 0;
+
+    for (int n = 0; n <= 20; ++n) {
+        for (int code = 0; code < (1 << n); ++code) {
+            ones = 0;
+            for (int i = 0; i < n; ++i) {
+                bits[i] = (code >> i) & 1;
+                ones += bits[i];
+            }
+            lib_sort_small(bits, n);
+            for (int i = 0; i < n; ++i)
+                ok &= bits[i] == (i >= n - ones);
+        }
+    }
+    CU_ASSERT(ok);
+
+    for (int n = 21; n <= NETWORK_MAX; ++n) {
+        for (int round = 0; round < 1000; ++round) {
+            for (int i = 0; i < n; ++i)
+                bits[i] = rand() % 50 - 25;
+            lib_sort_small(bits, n);
+            for (int i = 1; i < n; ++i)
+                ok &= bits[i-1] <= bits[i];
+        }
+    }
+    CU_ASSERT(ok);
+}
+
+/*
+ * Introsort agrees with qsort on random, duplicate heavy, sorted, reversed and extreme inputs.
+ */
+void test_sort(void) {
+    int sorted[BIG_SIZE];
+
+    for (int pattern = 0; pattern < 6; ++pattern) {
+        for (int i = 0; i < BIG_SIZE; ++i) {
+            switch (pattern) {
+            case 0: big[i] = rand() - RAND_MAX / 2; break;
+            case 1: big[i] = rand() % 3; break;
+            case 2: big[i] = i; break;
+            case 3: big[i] = BIG_SIZE - i; break;
+            case 4: big[i] = i % 2 == 0 ? INT_MIN : INT_MAX; break;
+            default: big[i] = i < BIG_SIZE / 2 ? i : BIG_SIZE - i; break;
+            }
+        }
+        memcpy(sorted, big, BIG_SIZE * sizeof(int));
+        qsort(sorted, BIG_SIZE, sizeof(int), lib_compare);
+
+        lib_sort(big, BIG_SIZE);
+        CU_ASSERT(memcmp(big, sorted, BIG_SIZE * sizeof(int)) == 0);
+    }
+
+    /* Tiny and empty inputs stay as they are. */
+    lib_sort(big, 0);
+    big[0] = 7;
+    lib_sort(big, 1);
+    CU_ASSERT(big[0] == 7);
+}
+
+/*
+ * Runs are counted exactly, and the adaptive sort agrees with qsort whether it merges runs or falls back.
+ */
+void test_adaptive_sort(void) {
+    int sorted[BIG_SIZE];
+
+    CU_ASSERT(lib_count_runs(vals_orig, 0) == 0);
+    CU_ASSERT(lib_count_runs(vals_orig, 1) == 1);
+    CU_ASSERT(lib_count_runs(vals_orig, VALS_SIZE) == 13);
+
+    /* Sorted, appended sorted blocks, a few swaps, reversed, random and duplicate heavy. */
+    for (int pattern = 0; pattern < 6; ++pattern) {
+        for (int i = 0; i < BIG_SIZE; ++i) {
+            switch (pattern) {
+            case 0: big[i] = i / 3; break;
+            case 1: big[i] = i % (BIG_SIZE / 7); break;
+            case 2: big[i] = i; break;
+            case 3: big[i] = BIG_SIZE - i; break;
+            case 4: big[i] = rand() - RAND_MAX / 2; break;
+            default: big[i] = rand() % 3; break;
+            }
+        }
+        if (pattern == 2)
+            for (int s = 0; s < 20; ++s)
+                lib_swap(big + rand() % BIG_SIZE, big + rand() % BIG_SIZE);
+        memcpy(sorted, big, BIG_SIZE * sizeof(int));
+        qsort(sorted, BIG_SIZE, sizeof(int), lib_compare);
+
+        lib_adaptive_sort(big, BIG_SIZE);
+        CU_ASSERT(memcmp(big, sorted, BIG_SIZE * sizeof(int)) == 0);
+        CU_ASSERT(lib_count_runs(big, BIG_SIZE) == 1);
+    }
+
+    /* Tiny and empty inputs stay as they are. */
+    lib_adaptive_sort(big, 0);
+    big[0] = 7;
+    lib_adaptive_sort(big, 1);
+    CU_ASSERT(big[0] == 7);
+}
+
+/*
+ * Random range stays within bound and seeding repeats the stream.
+ */
+void test_rand_range(void) {
+    int first[10], ok = 1;
+
+    lib_rand_seed(42);
+    for (int i = 0; i < 10; ++i)
+        first[i] = lib_rand_range(1000);
+    lib_rand_seed(42);
+    for (int i = 0; i < 10; ++i)
+        ok &= first[i] == lib_rand_range(1000);
+    for (int i = 0; i < 10000; ++i) {
+        int r = lib_rand_range(7);
+        ok &= r >= 0 && r < 7;
+    }
+
+    CU_ASSERT(ok);
+}
+
+/*
+ * The mixer is splitmix64, its outputs along the sequence from seed 0 are known. 0 mixes to 0, which is why
+ * callers add MIX_GOLDEN first.
+ */
+void test_mix64(void) {
+    CU_ASSERT(lib_mix64(MIX_GOLDEN) == 0xE220A8397B1DCDAFULL);
+    CU_ASSERT(lib_mix64(2 * MIX_GOLDEN) == 0x6E789E6AA1B965F4ULL);
+    CU_ASSERT(lib_mix64(0) == 0);
+}
+
 /*
  * Test the partitioning of the array when pivot is first element.
  */
@@ -303,6 +784,59 @@ void test_median_of_medians(void) {
     CU_ASSERT(pos == e_pos);
 }
 
+/*
+ * One streaming pass, random, sorted and duplicate heavy streams all answer within 1% of rank.
+ */
+void test_sketch_quantiles(void) {
+    int q[2] = {0, 0};
+    double ends[2] = {0.0, 1.0};
+
+    for (int i = 0; i < SKETCH_SIZE; ++i)
+        stream[i] = rand() - RAND_MAX / 2;
+    lib_sketch_init(&sketch);
+    lib_sketch_update(&sketch, stream, SKETCH_SIZE);
+    CU_ASSERT(sketch.count == SKETCH_SIZE);
+    CU_ASSERT(sketch.levels > 1);
+    check_sketch_ranks(&sketch, SKETCH_SIZE);
+
+    for (int i = 0; i < SKETCH_SIZE; ++i)
+        stream[i] = i;
+    lib_sketch_init(&sketch);
+    lib_sketch_update(&sketch, stream, SKETCH_SIZE);
+    check_sketch_ranks(&sketch, SKETCH_SIZE);
+
+    for (int i = 0; i < SKETCH_SIZE; ++i)
+        stream[i] = rand() % 7;
+    lib_sketch_init(&sketch);
+    lib_sketch_update(&sketch, stream, SKETCH_SIZE);
+    check_sketch_ranks(&sketch, SKETCH_SIZE);
+
+    /* Nothing seen answers 0, a few values are kept exactly. */
+    lib_sketch_init(&sketch);
+    lib_sketch_quantiles(&sketch, ends, 2, q);
+    CU_ASSERT(q[0] == 0 && q[1] == 0);
+    lib_sketch_update(&sketch, vals_orig, VALS_SIZE);
+    lib_sketch_quantiles(&sketch, ends, 2, q);
+    CU_ASSERT(q[0] == 2 && q[1] == 98);
+}
+
+/*
+ * Sketches of two halves merged answer like a sketch of the whole.
+ */
+void test_sketch_merge(void) {
+    for (int i = 0; i < SKETCH_SIZE; ++i)
+        stream[i] = rand() % 100000;
+
+    lib_sketch_init(&sketch);
+    lib_sketch_init(&other);
+    lib_sketch_update(&sketch, stream, SKETCH_SIZE / 3);
+    lib_sketch_update(&other, stream + SKETCH_SIZE / 3, SKETCH_SIZE - SKETCH_SIZE / 3);
+    lib_sketch_merge(&sketch, &other);
+
+    CU_ASSERT(sketch.count == SKETCH_SIZE);
+    check_sketch_ranks(&sketch, SKETCH_SIZE);
+}
+
 /* The main() function for setting up and running the tests.
  * Returns a CUE_SUCCESS on successful running, another
  * CUnit error code on failure.
@@ -326,12 +860,23 @@ int main() {
        (NULL == CU_add_test(sharedSuite, "Compare: Equal..............", test_compare_equal)) ||
        (NULL == CU_add_test(sharedSuite, "Compare: Less...............", test_compare_less)) ||
        (NULL == CU_add_test(sharedSuite, "Compare: Greater............", test_compare_more)) ||
+       (NULL == CU_add_test(sharedSuite, "Compare: Extremes...........", test_compare_extremes)) ||
        (NULL == CU_add_test(sharedSuite, "Select Pivot, Odd...........", test_select_pivot_odd)) ||
        (NULL == CU_add_test(sharedSuite, "Select Pivot, Even..........", test_select_pivot_even)) ||
        (NULL == CU_add_test(sharedSuite, "Swap Ints...................", test_swap_ints)) ||
        (NULL == CU_add_test(sharedSuite, "Power Function, Even........", test_power_even)) ||
        (NULL == CU_add_test(sharedSuite, "Power Function, Odd.........", test_power_odd)) ||
        (NULL == CU_add_test(sharedSuite, "Value Partitiony............", test_partition_by_val)) ||
+       (NULL == CU_add_test(sharedSuite, "Value Partition: All Less...", test_partition_by_val_all_less)) ||
+       (NULL == CU_add_test(sharedSuite, "Value Partition: Block......", test_partition_by_val_block)) ||
+       (NULL == CU_add_test(sharedSuite, "Value Partition: AVX2.......", test_partition_by_val_avx2)) ||
+       (NULL == CU_add_test(sharedSuite, "Index Partition: Big........", test_partition_by_index_big)) ||
+       (NULL == CU_add_test(sharedSuite, "Three Way Partition.........", test_partition3_by_val)) ||
+       (NULL == CU_add_test(sharedSuite, "Split Equal Band............", test_split_equal)) ||
+       (NULL == CU_add_test(sharedSuite, "Classify....................", test_classify)) ||
+       (NULL == CU_add_test(sharedSuite, "Classify: Big...............", test_classify_big)) ||
+       (NULL == CU_add_test(sharedSuite, "Sketch: Quantiles...........", test_sketch_quantiles)) ||
+       (NULL == CU_add_test(sharedSuite, "Sketch: Merge...............", test_sketch_merge)) ||
        (NULL == CU_add_test(sharedSuite, "Array Union.................", test_array_union)) ||
        (NULL == CU_add_test(sharedSuite, "Subgroup Info...............", test_subgroup_info)) ||
        (NULL == CU_add_test(sharedSuite, "Compress Array..............", test_compress_array)) ||
@@ -341,7 +886,17 @@ int main() {
        (NULL == CU_add_test(sharedSuite, "Index Partition: Small Val..", test_partition_by_index_smallest_val)) ||
        (NULL == CU_add_test(sharedSuite, "Index Partition: Large Val..", test_partition_by_index_largest_val)) ||
        (NULL == CU_add_test(sharedSuite, "Select Index: First.........", test_select_kth)) ||
-       (NULL == CU_add_test(sharedSuite, "Median of Medians: First....", test_median_of_medians))
+       (NULL == CU_add_test(sharedSuite, "Median of Medians: First....", test_median_of_medians)) ||
+       (NULL == CU_add_test(sharedSuite, "Select: Floyd-Rivest........", test_select_floyd_rivest)) ||
+       (NULL == CU_add_test(sharedSuite, "Select: Introselect.........", test_introselect)) ||
+       (NULL == CU_add_test(sharedSuite, "Select: Adversarial.........", test_introselect_adversarial)) ||
+       (NULL == CU_add_test(sharedSuite, "Select: Duplicates..........", test_introselect_duplicates)) ||
+       (NULL == CU_add_test(sharedSuite, "Sorting Network: Five.......", test_sort5)) ||
+       (NULL == CU_add_test(sharedSuite, "Sorting Network: Small......", test_sort_small)) ||
+       (NULL == CU_add_test(sharedSuite, "Sort: Introsort.............", test_sort)) ||
+       (NULL == CU_add_test(sharedSuite, "Sort: Adaptive..............", test_adaptive_sort)) ||
+       (NULL == CU_add_test(sharedSuite, "Random Range................", test_rand_range)) ||
+       (NULL == CU_add_test(sharedSuite, "Mix64.......................", test_mix64))
       )
    {
       CU_cleanup_registry();
@@ -0,0 +1,252 @@
+/**
+ * Tests for the sort strategy selection. Run under mpirun with a few tasks, any count works.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+#include "auto_ops.h"
+
+/******************* Constants/Macros *********************/
+#define PER_RANK		3000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Sort size keys per rank from dist over comm with algo. Checks every rank is sorted, each rank's first key is
+ * at least every earlier rank's last and that the sum and count of keys are kept.
+ */
+static void check_sort(MPI_Comm comm, const auto_algo_t algo, const gen_dist_t dist, const int size) {
+    gen_params_t params;
+    int rank = 0, ranks = 0, local_size = size, ok = 1, *local = malloc((size > 0 ? size : 1) * sizeof(int));
+    long offset = 0, count = 0, before[2] = {0, 0}, after[2] = {0, 0}, last = LONG_MIN, below = LONG_MIN;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(local, NULL);
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ranks);
+    lib_gen_params(&params, dist, 5, (long)size * ranks, ranks);
+    lib_gen_share(params.total, rank, ranks, &offset, &count);
+    lib_gen_fill(&params, local, offset, count);
+
+    before[0] = local_size;
+    for (int i = 0; i < local_size; ++i)
+        before[1] += local[i];
+    MPI_Allreduce(MPI_IN_PLACE, before, 2, MPI_LONG, MPI_SUM, comm);
+
+    lib_auto_sort(comm, algo, &local, &local_size);
+
+    after[0] = local_size;
+    for (int i = 0; i < local_size; ++i) {
+        after[1] += local[i];
+        ok &= i == 0 || local[i-1] <= local[i];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, after, 2, MPI_LONG, MPI_SUM, comm);
+
+    /* A later rank's first key must be at least every earlier rank's last. */
+    last = local_size > 0 ? local[local_size-1] : LONG_MIN;
+    MPI_Exscan(&last, &below, 1, MPI_LONG, MPI_MAX, comm);
+    if (rank > 0 && local_size > 0)
+        ok &= below <= local[0];
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(before[0] == after[0] && before[1] == after[1]);
+
+    free(local);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Each rule of lib_auto_choose on hand made measurements.
+ */
+void test_auto_choose(void) {
+    auto_stats_t stats = {1L << 24, 8, 8, 1, 1L << 31, 8 * AUTO_SAMPLE, 8.0 * AUTO_SAMPLE, 0.5};
+
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_HYPER);
+
+    stats.world = 1;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_LOCAL);
+    stats.world = 8;
+    stats.total = AUTO_LOCAL_MAX;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_LOCAL);
+    stats.total = 1L << 24;
+
+    stats.range = DIST_COUNT_RANGE;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_COUNT);
+    stats.range = 1L << 31;
+
+    stats.world = stats.per_node = 16;
+    stats.total = 16L * AUTO_BITONIC_MAX;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_BITONIC);
+    stats.even = 0;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_HYPER);
+    stats.even = 1;
+    stats.world = stats.per_node = 12;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_HYPER);
+    stats.world = stats.per_node = 8;
+    stats.total = 1L << 24;
+
+    stats.per_node = 4;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_SAMPLE_SORT);
+    stats.distinct = 100.0;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_HYPER);
+    stats.distinct = 8.0 * AUTO_SAMPLE;
+    stats.per_node = 8;
+    stats.disorder = AUTO_NEARLY_SORTED / 2;
+    CU_ASSERT(lib_auto_choose(&stats) == AUTO_SAMPLE_SORT);
+}
+
+/*
+ * Names round trip and unknown ones are refused.
+ */
+void test_auto_parse(void) {
+    for (int a = 0; a < AUTO_ALGOS; ++a)
+        CU_ASSERT(lib_auto_parse(lib_auto_name(a)) == a);
+    CU_ASSERT(lib_auto_parse("quick") == -1);
+    CU_ASSERT(strcmp(lib_auto_name(AUTO_ALGOS), "unknown") == 0);
+}
+
+/*
+ * Measurements of inputs with a known answer.
+ */
+void test_auto_stats(void) {
+    auto_stats_t stats;
+    int local[PER_RANK];
+
+    /* Keys id * PER_RANK .. (id + 1) * PER_RANK - 1 in order, all distinct and sorted across ranks. */
+    for (int i = 0; i < PER_RANK; ++i)
+        local[i] = id * PER_RANK + i;
+    lib_auto_stats(MPI_COMM_WORLD, local, PER_RANK, &stats);
+    CU_ASSERT(stats.total == (long)PER_RANK * world);
+    CU_ASSERT(stats.world == world);
+    CU_ASSERT(stats.per_node >= 1 && stats.per_node <= world);
+    CU_ASSERT(stats.even);
+    CU_ASSERT(stats.range == (long)PER_RANK * world);
+    CU_ASSERT(stats.sampled == (long)PER_RANK * world);
+    CU_ASSERT(stats.distinct > 0.95 * stats.sampled && stats.distinct < 1.05 * stats.sampled);
+    CU_ASSERT(stats.disorder == 0.0);
+
+    /* Reversed and only ten keys, uneven when there are several ranks. */
+    for (int i = 0; i < PER_RANK; ++i)
+        local[i] = 9 - (i * 10 / PER_RANK);
+    lib_auto_stats(MPI_COMM_WORLD, local, id == 0 ? PER_RANK / 2 : PER_RANK, &stats);
+    CU_ASSERT(stats.even == (world == 1));
+    CU_ASSERT(stats.range == (world == 1 ? 5 : 10));
+    CU_ASSERT(stats.distinct < 20);
+    CU_ASSERT(stats.disorder > 0.0 && stats.disorder < 0.01);
+}
+
+/*
+ * Every strategy sorts over all ranks.
+ */
+void test_auto_sort(void) {
+    check_sort(MPI_COMM_WORLD, AUTO_LOCAL, GEN_UNIFORM, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_COUNT, GEN_RANGE, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_COUNT, GEN_UNIFORM, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_SAMPLE_SORT, GEN_UNIFORM, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_SAMPLE_SORT, GEN_ZIPF, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_HYPER, GEN_UNIFORM, PER_RANK);
+    check_sort(MPI_COMM_WORLD, AUTO_HYPER, GEN_FEW_UNIQUE, PER_RANK);
+    if ((world & (world - 1)) == 0)
+        check_sort(MPI_COMM_WORLD, AUTO_BITONIC, GEN_UNIFORM, PER_RANK);
+}
+
+/*
+ * Three ranks fold the third onto the first for the hypercube sorts.
+ */
+void test_auto_fold(void) {
+    MPI_Comm three;
+
+    if (world < 3)
+        return;
+    MPI_Comm_split(MPI_COMM_WORLD, id < 3 ? 0 : MPI_UNDEFINED, id, &three);
+    if (id >= 3)
+        return;
+
+    check_sort(three, AUTO_SAMPLE_SORT, GEN_UNIFORM, PER_RANK);
+    check_sort(three, AUTO_HYPER, GEN_UNIFORM, PER_RANK);
+    check_sort(three, AUTO_COUNT, GEN_RANGE, PER_RANK);
+    check_sort(three, AUTO_LOCAL, GEN_UNIFORM, PER_RANK);
+
+    MPI_Comm_free(&three);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite autoSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   autoSuite = CU_add_suite("Sort Selection Suite", suite_init, suite_clean);
+   if (NULL == autoSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(autoSuite, "Choose......................", test_auto_choose)) ||
+       (NULL == CU_add_test(autoSuite, "Parse.......................", test_auto_parse)) ||
+       (NULL == CU_add_test(autoSuite, "Stats.......................", test_auto_stats)) ||
+       (NULL == CU_add_test(autoSuite, "Sort........................", test_auto_sort)) ||
+       (NULL == CU_add_test(autoSuite, "Fold........................", test_auto_fold))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
@@ -0,0 +1,168 @@
+/**
+ * Tests for the wire codec, every block must decode to exactly what was encoded.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "array_ops.h"
+#include "codec_ops.h"
+
+/******************* Constants/Macros *********************/
+#define BIG_SIZE		5000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int big[BIG_SIZE], back[BIG_SIZE];
+static unsigned char wire[CODEC_HEADER + BIG_SIZE * sizeof(int)];
+
+/****************** Static Functions **********************/
+/*
+ * Encode the first size values of big, check the kind and that they decode unchanged. Returns bytes used.
+ */
+static long round_trip(const int size, const codec_kind_t kind) {
+    long bytes = lib_codec_encode(big, size, wire);
+
+    CU_ASSERT(bytes <= lib_codec_bound(size));
+    CU_ASSERT(lib_codec_kind(wire) == kind);
+    CU_ASSERT(lib_codec_count(wire) == size);
+
+    memset(back, 0, sizeof(back));
+    CU_ASSERT_FATAL(lib_codec_decode(wire, back) == size);
+    CU_ASSERT(memcmp(big, back, size * sizeof(int)) == 0);
+
+    return bytes;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+    srand(time(NULL));
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Unsorted values from a small range pack relative to the minimum.
+ */
+void test_codec_for(void) {
+    long bytes = 0;
+
+    for (int i = 0; i < BIG_SIZE; ++i)
+        big[i] = rand() % 1000 - 500;
+
+    /* 1000 values need 10 bits. */
+    bytes = round_trip(BIG_SIZE, CODEC_FOR);
+    CU_ASSERT(bytes <= CODEC_HEADER + (BIG_SIZE * 10 + 7) / 8);
+}
+
+/*
+ * Sorted values pack as gaps, far narrower than their range.
+ */
+void test_codec_delta(void) {
+    long bytes = 0;
+
+    big[0] = -100000;
+    for (int i = 1; i < BIG_SIZE; ++i)
+        big[i] = big[i-1] + rand() % 8;
+
+    /* Gaps below 8 need 3 bits. */
+    bytes = round_trip(BIG_SIZE, CODEC_DELTA);
+    CU_ASSERT(bytes <= CODEC_HEADER + (BIG_SIZE * 3 + 7) / 8);
+
+    /* Odd sizes leave a partial last byte, a single value has no gaps and ties go to frame of reference. */
+    round_trip(7, CODEC_DELTA);
+    round_trip(1, CODEC_FOR);
+}
+
+/*
+ * Values spanning the whole int range gain nothing and go raw.
+ */
+void test_codec_raw(void) {
+    for (int i = 0; i < BIG_SIZE; ++i)
+        big[i] = (i % 2 == 0 ? INT_MIN : INT_MAX) + i / 2 * (i % 2 == 0 ? 1 : -1);
+
+    CU_ASSERT(round_trip(BIG_SIZE, CODEC_RAW) == lib_codec_bound(BIG_SIZE));
+
+    /* Sorted, but a single full width gap. */
+    big[0] = INT_MIN;
+    big[1] = INT_MAX;
+    round_trip(2, CODEC_RAW);
+}
+
+/*
+ * A run of one value needs no bits past the header, an empty block only the header.
+ */
+void test_codec_edges(void) {
+    for (int i = 0; i < BIG_SIZE; ++i)
+        big[i] = 42;
+
+    CU_ASSERT(round_trip(BIG_SIZE, CODEC_FOR) == CODEC_HEADER);
+    CU_ASSERT(lib_codec_encode(big, 0, wire) == CODEC_HEADER);
+    CU_ASSERT(lib_codec_count(wire) == 0);
+    CU_ASSERT(lib_codec_decode(wire, back) == 0);
+
+    /* Widest packed width, sorted from INT_MIN with gaps just under 2^31. */
+    big[0] = INT_MIN;
+    big[1] = -1;
+    big[2] = INT_MAX - 1;
+    round_trip(3, CODEC_DELTA);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main() {
+   CU_pSuite sharedSuite = NULL;
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   sharedSuite = CU_add_suite("Shared Suite", suite_init, suite_clean);
+   if (NULL == sharedSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(sharedSuite, "Codec: Frame of Reference...", test_codec_for)) ||
+       (NULL == CU_add_test(sharedSuite, "Codec: Delta................", test_codec_delta)) ||
+       (NULL == CU_add_test(sharedSuite, "Codec: Raw..................", test_codec_raw)) ||
+       (NULL == CU_add_test(sharedSuite, "Codec: Edges................", test_codec_edges))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface */
+   CU_basic_set_mode(CU_BRM_VERBOSE);
+   CU_basic_run_tests();
+   CU_cleanup_registry();
+   return CU_get_error();
+}
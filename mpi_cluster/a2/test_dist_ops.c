@@ -0,0 +1,628 @@
+/**
+ * Tests for the distributed sorts. Run under mpirun with a few tasks, any count works.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "gen_ops.h"
+#include "dist_ops.h"
+
+/******************* Constants/Macros *********************/
+#define PER_RANK		1000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Sum and xor of the values over all ranks, a cheap check that nothing was lost or made up.
+ */
+static void global_digest(const int vals[], const int size, long digest[2]) {
+    digest[0] = digest[1] = 0;
+    for (int i = 0; i < size; ++i) {
+        digest[0] += vals[i];
+        digest[1] ^= (long)vals[i] * 2654435761L;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &digest[0], 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &digest[1], 1, MPI_LONG, MPI_BXOR, MPI_COMM_WORLD);
+}
+
+/*
+ * 1 on every rank if vals is sorted here and its first value is not below the previous rank's last.
+ * Empty ranks pass their neighbour's last value along.
+ */
+static int globally_sorted(const int vals[], const int size) {
+    int ok = 1, last = INT_MIN, prev = INT_MIN;
+
+    for (int i = 1; i < size; ++i)
+        ok &= vals[i-1] <= vals[i];
+
+    /* Ranks in order, each learns the largest value so far. */
+    if (id > 0)
+        MPI_Recv(&prev, 1, MPI_INT, id-1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (size > 0)
+        ok &= prev <= vals[0];
+    last = size > 0 ? vals[size-1] : prev;
+    if (id < world-1)
+        MPI_Send(&last, 1, MPI_INT, id+1, 0, MPI_COMM_WORLD);
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return ok;
+}
+
+/*
+ * Counting sort size values per rank from params, checks order, shares and contents.
+ */
+static void check_count_sort(gen_params_t *params, const int size) {
+    int *vals = NULL, vals_size = size, total = 0, first = 0;
+    long before[2], after[2], offset = 0, count = 0;
+
+    /* Any global layout will do, ranks take consecutive slices of the input. */
+    MPI_Allreduce(&vals_size, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Exscan(&vals_size, &first, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    params->total = total;
+
+    vals = malloc((size > 0 ? size : 1) * sizeof(int));
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    lib_gen_fill(params, vals, id > 0 ? first : 0, size);
+    global_digest(vals, size, before);
+
+    CU_ASSERT(lib_count_sort(MPI_COMM_WORLD, &vals, &vals_size) == 1);
+
+    lib_gen_share(total, id, world, &offset, &count);
+    CU_ASSERT(vals_size == count);
+    CU_ASSERT(globally_sorted(vals, vals_size));
+    global_digest(vals, vals_size, after);
+    CU_ASSERT(before[0] == after[0] && before[1] == after[1]);
+
+    free(vals);
+}
+
+/*
+ * Top k of size values per rank from dist, checked at root against sorting everything.
+ */
+static void check_top_k(const gen_dist_t dist, const int size, const int k, const int largest) {
+    gen_params_t params;
+    int *vals = malloc((size > 0 ? size : 1) * sizeof(int)), *all = NULL, *out = NULL;
+    int total = size * world, found = 0, expect = total < k ? total : k;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    lib_gen_params(&params, dist, 16, (long)total, world);
+    lib_gen_fill(&params, vals, (long)id * size, size);
+
+    /* Reference first, the top k reorders vals. */
+    if (id == ROOT) {
+        all = malloc((total > 0 ? total : 1) * sizeof(int));
+        out = malloc((k > 0 ? k : 1) * sizeof(int));
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(all, NULL);
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(out, NULL);
+    }
+    MPI_Gather(vals, size, MPI_INT, all, size, MPI_INT, ROOT, MPI_COMM_WORLD);
+
+    found = lib_top_k(MPI_COMM_WORLD, vals, size, k, largest, out);
+
+    if (id == ROOT) {
+        qsort(all, total, sizeof(int), lib_compare);
+        CU_ASSERT(found == expect);
+        CU_ASSERT(memcmp(out, largest ? all+total-expect : all, expect * sizeof(int)) == 0);
+    } else {
+        CU_ASSERT(found == 0);
+    }
+
+    free(vals);
+    free(all);
+    free(out);
+}
+
+/*
+ * Multiselect size values per rank from dist at the given ranks, checked on every rank against sorting all.
+ */
+static void check_select(const gen_dist_t dist, const int size, const long kths[], const int count) {
+    gen_params_t params;
+    int total = size * world, out[8] = {0};
+    int *vals = malloc((size > 0 ? size : 1) * sizeof(int)), *all = malloc((total > 0 ? total : 1) * sizeof(int));
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(all, NULL);
+    lib_gen_params(&params, dist, 17, (long)total, world);
+    lib_gen_fill(&params, vals, (long)id * size, size);
+    MPI_Allgather(vals, size, MPI_INT, all, size, MPI_INT, MPI_COMM_WORLD);
+    qsort(all, total, sizeof(int), lib_compare);
+
+    lib_dist_multiselect(MPI_COMM_WORLD, vals, size, kths, count, out);
+    for (int i = 0; i < count; ++i)
+        CU_ASSERT(out[i] == all[kths[i]-1]);
+
+    free(vals);
+    free(all);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Random values in a range narrower than their count end up evenly shared and sorted.
+ */
+void test_count_range(void) {
+    gen_params_t params;
+
+    lib_gen_params(&params, GEN_RANGE, 11, 0, world);
+    params.range = PER_RANK / 2;
+    check_count_sort(&params, PER_RANK);
+}
+
+/*
+ * Few distinct values, runs of one key straddle many rank boundaries.
+ */
+void test_count_few(void) {
+    gen_params_t params;
+
+    lib_gen_params(&params, GEN_FEW_UNIQUE, 12, 0, world);
+    params.unique = 3;
+    params.range = 30;
+    check_count_sort(&params, PER_RANK);
+}
+
+/*
+ * Uneven input, rank 0 holds nothing and the others different amounts.
+ */
+void test_count_uneven(void) {
+    gen_params_t params;
+
+    lib_gen_params(&params, GEN_RANGE, 13, 0, world);
+    params.range = 30;
+    check_count_sort(&params, id * 37);
+}
+
+/*
+ * Keys spanning more than DIST_COUNT_RANGE are refused and left as they were.
+ */
+void test_count_wide(void) {
+    int *vals = malloc(2 * sizeof(int)), size = 2;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    vals[0] = 7;
+    vals[1] = id == world-1 ? DIST_COUNT_RANGE + 7 : -5;
+
+    CU_ASSERT(lib_count_sort(MPI_COMM_WORLD, &vals, &size) == 0);
+    CU_ASSERT(size == 2 && vals[0] == 7);
+
+    free(vals);
+}
+
+/*
+ * A range within DIST_COUNT_RANGE but wider than the number of keys is refused too, even by a single key.
+ */
+void test_count_sparse(void) {
+    int *vals = malloc(2 * sizeof(int)), size = 2;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    vals[0] = 0;
+    vals[1] = DIST_COUNT_RANGE / 2;
+    CU_ASSERT(lib_count_sort(MPI_COMM_WORLD, &vals, &size) == 0);
+    CU_ASSERT(size == 2 && vals[1] == DIST_COUNT_RANGE / 2);
+
+    vals[1] = 2 * world;
+    CU_ASSERT(lib_count_sort(MPI_COMM_WORLD, &vals, &size) == 0);
+    CU_ASSERT(lib_count_fits(2 * world, 2 * world) && !lib_count_fits(2 * world + 1, 2 * world));
+    CU_ASSERT(!lib_count_fits(DIST_COUNT_RANGE + 1L, 1L << 30) && !lib_count_fits(0, 1));
+
+    free(vals);
+}
+
+/*
+ * No values anywhere is trivially sorted.
+ */
+void test_count_empty(void) {
+    int *vals = malloc(sizeof(int)), size = 0;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT(lib_count_sort(MPI_COMM_WORLD, &vals, &size) == 1);
+    CU_ASSERT(size == 0);
+
+    free(vals);
+}
+
+/*
+ * Splitters from the sample, one classification and one exchange leave the ranks in order.
+ * Needs a power of two tasks, a single task keeps everything in its one bucket.
+ */
+void test_bucket_exchange(void) {
+    gen_params_t params;
+    int *vals = malloc(PER_RANK * sizeof(int)), vals_size = PER_RANK, levels = 0;
+    int tree[(1 << DIST_MAX_LEVELS) - 1] = {0};
+    long before[2], after[2], total = 0;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    while ((1 << levels) < world)
+        ++levels;
+    if ((1 << levels) != world || levels > DIST_MAX_LEVELS) {
+        free(vals);
+        return;
+    }
+
+    lib_gen_params(&params, GEN_SKEWED, 14, (long)PER_RANK * world, world);
+    lib_gen_fill(&params, vals, (long)id * PER_RANK, PER_RANK);
+    global_digest(vals, vals_size, before);
+
+    if (levels > 0)
+        lib_sample_splitters(MPI_COMM_WORLD, levels, vals, vals_size, tree);
+    if (levels >= 2)
+        CU_ASSERT(tree[1] <= tree[0] && tree[0] <= tree[2]);
+    lib_bucket_exchange(MPI_COMM_WORLD, tree, levels, &vals, &vals_size);
+    qsort(vals, vals_size, sizeof(int), lib_compare);
+
+    CU_ASSERT(globally_sorted(vals, vals_size));
+    global_digest(vals, vals_size, after);
+    CU_ASSERT(before[0] == after[0] && before[1] == after[1]);
+    total = vals_size;
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    CU_ASSERT(total == (long)PER_RANK * world);
+
+    free(vals);
+}
+
+/*
+ * Bitonic sort keeps every rank at exactly its size and orders the ranks, duplicates included.
+ * Needs a power of two tasks.
+ */
+void test_bitonic(void) {
+    gen_params_t params;
+    int *vals = malloc(PER_RANK * sizeof(int));
+    long before[2], after[2];
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    if ((world & (world-1)) != 0) {
+        free(vals);
+        return;
+    }
+
+    for (int dist = GEN_REVERSE; dist <= GEN_FEW_UNIQUE; ++dist) {
+        lib_gen_params(&params, dist, 15, (long)PER_RANK * world, world);
+        lib_gen_fill(&params, vals, (long)id * PER_RANK, PER_RANK);
+        global_digest(vals, PER_RANK, before);
+
+        lib_bitonic_sort(MPI_COMM_WORLD, vals, PER_RANK);
+
+        CU_ASSERT(globally_sorted(vals, PER_RANK));
+        global_digest(vals, PER_RANK, after);
+        CU_ASSERT(before[0] == after[0] && before[1] == after[1]);
+    }
+
+    free(vals);
+}
+
+/*
+ * The k smallest and largest of random values match the ends of the full sort.
+ */
+void test_top_k(void) {
+    check_top_k(GEN_UNIFORM, PER_RANK, 10, 0);
+    check_top_k(GEN_UNIFORM, PER_RANK, 10, 1);
+    check_top_k(GEN_SKEWED, PER_RANK, 3 * PER_RANK / 2, 0);
+    check_top_k(GEN_SKEWED, PER_RANK, 1, 1);
+}
+
+/*
+ * Many values tie at the threshold, root still returns exactly k.
+ */
+void test_top_k_ties(void) {
+    check_top_k(GEN_FEW_UNIQUE, PER_RANK, 100, 0);
+    check_top_k(GEN_FEW_UNIQUE, PER_RANK, 100, 1);
+}
+
+/*
+ * No k, or more k than values, returns what there is.
+ */
+void test_top_k_edges(void) {
+    check_top_k(GEN_UNIFORM, PER_RANK, 0, 0);
+    check_top_k(GEN_UNIFORM, 5, 5 * world + 7, 0);
+    check_top_k(GEN_UNIFORM, 0, 3, 1);
+}
+
+/*
+ * Single ranks match the full sort at the ends and the middle.
+ */
+void test_dist_select(void) {
+    gen_params_t params;
+    int *vals = malloc(PER_RANK * sizeof(int)), *all = malloc(PER_RANK * world * sizeof(int));
+    long kths[] = {1, PER_RANK * world / 2, PER_RANK * world};
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(all, NULL);
+    lib_gen_params(&params, GEN_UNIFORM, 18, (long)PER_RANK * world, world);
+    lib_gen_fill(&params, vals, (long)id * PER_RANK, PER_RANK);
+    MPI_Allgather(vals, PER_RANK, MPI_INT, all, PER_RANK, MPI_INT, MPI_COMM_WORLD);
+    qsort(all, PER_RANK * world, sizeof(int), lib_compare);
+
+    for (int i = 0; i < 3; ++i)
+        CU_ASSERT(lib_dist_select(MPI_COMM_WORLD, vals, PER_RANK, kths[i]) == all[kths[i]-1]);
+
+    free(vals);
+    free(all);
+}
+
+/*
+ * A batch in any order with repeats, on skewed, duplicate heavy and presorted inputs.
+ */
+void test_dist_multiselect(void) {
+    long n = (long)PER_RANK * world;
+    long kths[] = {n, n / 2, 1, (n * 99 + 99) / 100, n / 2, (n * 9 + 9) / 10};
+
+    check_select(GEN_SKEWED, PER_RANK, kths, 6);
+    check_select(GEN_FEW_UNIQUE, PER_RANK, kths, 6);
+    check_select(GEN_SORTED, PER_RANK, kths, 6);
+    check_select(GEN_ZIPF, PER_RANK, kths, 6);
+}
+
+/*
+ * A single value, and ranks holding nothing at all.
+ */
+void test_dist_multiselect_sparse(void) {
+    long one[] = {1}, all[] = {1, world};
+
+    check_select(GEN_UNIFORM, 1, one, 1);
+    check_select(GEN_UNIFORM, 1, all, 2);
+    check_select(GEN_UNIFORM, 0, all, 0);
+}
+
+/*
+ * Every rank ends with the same sketch of all values, and its splitters order the buckets like the sample's.
+ */
+void test_sketch_splitters(void) {
+    gen_params_t params;
+    quantile_sketch_t *sketch = malloc(sizeof(quantile_sketch_t));
+    int *vals = malloc(PER_RANK * sizeof(int)), tree[7] = {0}, median[2] = {0, 0};
+    double half = 0.5;
+    long n = (long)PER_RANK * world;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(sketch, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    lib_gen_params(&params, GEN_UNIFORM, 19, n, world);
+    lib_gen_fill(&params, vals, (long)id * PER_RANK, PER_RANK);
+
+    lib_sketch_init(sketch);
+    lib_sketch_update(sketch, vals, PER_RANK);
+    lib_sketch_allreduce(MPI_COMM_WORLD, sketch);
+    CU_ASSERT(sketch->count == n);
+
+    /* Same median on every rank. */
+    lib_sketch_quantiles(sketch, &half, 1, &median[0]);
+    median[1] = median[0];
+    MPI_Allreduce(MPI_IN_PLACE, &median[1], 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    CU_ASSERT(median[0] == median[1]);
+
+    /* Splitter tree is a search tree, the root between its children. */
+    lib_sketch_splitters(MPI_COMM_WORLD, 3, vals, PER_RANK, tree);
+    CU_ASSERT(tree[1] <= tree[0] && tree[0] <= tree[2]);
+    CU_ASSERT(tree[3] <= tree[1] && tree[1] <= tree[4] && tree[5] <= tree[2] && tree[2] <= tree[6]);
+
+    free(sketch);
+    free(vals);
+}
+
+/*
+ * Sorted but lopsided layouts, everything on one rank or growing with the rank, end evenly shared.
+ */
+void test_equalize(void) {
+    int *vals = NULL, vals_size = 0, before_first = 0, total = 0;
+    long before[2], after[2], offset = 0, count = 0;
+
+    for (int layout = 0; layout < 3; ++layout) {
+        /* Rank r holds the consecutive values after every lower rank's. */
+        vals_size = layout == 0 ? (id == 0 ? PER_RANK * world : 0) : (layout == 1 ? id * 37 : (id % 2) * PER_RANK);
+        vals = malloc((vals_size > 0 ? vals_size : 1) * sizeof(int));
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+        before_first = 0;
+        MPI_Exscan(&vals_size, &before_first, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(&vals_size, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        for (int i = 0; i < vals_size; ++i)
+            vals[i] = ((id > 0 ? before_first : 0) + i) / 3;
+        global_digest(vals, vals_size, before);
+
+        lib_equalize(MPI_COMM_WORLD, &vals, &vals_size);
+
+        lib_gen_share(total, id, world, &offset, &count);
+        CU_ASSERT(vals_size == count);
+        CU_ASSERT(globally_sorted(vals, vals_size));
+        global_digest(vals, vals_size, after);
+        CU_ASSERT(before[0] == after[0] && before[1] == after[1]);
+        free(vals);
+    }
+}
+
+/*
+ * 64 bit values placed to explicit targets land at their exact global position. Rank r holding r + 1 values
+ * ends with world - r, then everything on rank 0 spreads out to r + 1 each.
+ */
+void test_dist_place(void) {
+    int *sizes = malloc(2 * world * sizeof(int)), *targets = NULL, ok = 1;
+    long total = (long)world * (world + 1) / 2, first = 0;
+    int64_t *vals = malloc(total * sizeof(int64_t)), *out = malloc(total * sizeof(int64_t));
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(sizes, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(out, NULL);
+    targets = sizes + world;
+
+    for (int layout = 0; layout < 2; ++layout) {
+        for (int r = 0; r < world; ++r) {
+            sizes[r] = layout == 0 ? r + 1 : (r == 0 ? (int)total : 0);
+            targets[r] = layout == 0 ? world - r : r + 1;
+        }
+
+        /* Values are their positions in the global order. */
+        first = 0;
+        for (int r = 0; r < id; ++r)
+            first += sizes[r];
+        for (int i = 0; i < sizes[id]; ++i)
+            vals[i] = first + i;
+
+        lib_dist_place(MPI_COMM_WORLD, lib_mpi_type_i64(), sizeof(int64_t), vals, sizes, targets, out);
+
+        first = 0;
+        for (int r = 0; r < id; ++r)
+            first += targets[r];
+        for (int i = 0; i < targets[id]; ++i)
+            ok &= out[i] == first + i;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    CU_ASSERT(ok);
+
+    free(sizes);
+    free(vals);
+    free(out);
+}
+
+/*
+ * Sorted layouts are recognised across empty ranks, a single inversion anywhere is not.
+ */
+void test_dist_sorted(void) {
+    int vals[PER_RANK], size = id % 2 == 1 ? 0 : PER_RANK;
+
+    for (int i = 0; i < PER_RANK; ++i)
+        vals[i] = id * PER_RANK + i / 2;
+    CU_ASSERT(lib_dist_sorted(MPI_COMM_WORLD, vals, size) == 1);
+    CU_ASSERT(lib_dist_sorted(MPI_COMM_WORLD, vals, 0) == 1);
+
+    /* Inside the last rank. */
+    if (id == world - 1) {
+        vals[PER_RANK-2] = vals[PER_RANK-1] + 1;
+        size = PER_RANK;
+    }
+    CU_ASSERT(lib_dist_sorted(MPI_COMM_WORLD, vals, size) == 0);
+
+    /* Across ranks only, each sorted on its own. */
+    for (int i = 0; i < PER_RANK; ++i)
+        vals[i] = (world - id) * PER_RANK + i;
+    CU_ASSERT(lib_dist_sorted(MPI_COMM_WORLD, vals, PER_RANK) == (world == 1));
+}
+
+/*
+ * The digest ignores order and placement, the verifier catches a value lost, repeated or out of place.
+ */
+void test_dist_verify(void) {
+    int vals[PER_RANK], reversed[PER_RANK], *all = malloc((long)PER_RANK * world * sizeof(int));
+    dist_digest_t input, moved;
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(all, NULL);
+    for (int i = 0; i < PER_RANK; ++i) {
+        vals[i] = id * PER_RANK + i;
+        reversed[PER_RANK-1-i] = vals[i];
+    }
+    CU_ASSERT(lib_multiset_hash(vals, PER_RANK) == lib_multiset_hash(reversed, PER_RANK));
+    CU_ASSERT(lib_multiset_hash(vals, 0) == 0);
+    CU_ASSERT(lib_multiset_hash(vals, 2) != lib_multiset_hash(vals+1, 2));
+
+    /* Same values all on rank 0. */
+    lib_dist_digest(MPI_COMM_WORLD, reversed, PER_RANK, &input);
+    CU_ASSERT(input.count == (long)PER_RANK * world);
+    for (int i = 0; i < PER_RANK * world; ++i)
+        all[i] = i;
+    lib_dist_digest(MPI_COMM_WORLD, all, id == 0 ? PER_RANK * world : 0, &moved);
+    CU_ASSERT(moved.count == input.count && moved.hash == input.hash);
+    CU_ASSERT(lib_dist_verify(MPI_COMM_WORLD, vals, PER_RANK, &input) == 1);
+
+    /* One value repeated in place of another keeps the count and the order. */
+    if (id == world - 1)
+        vals[PER_RANK-1] = vals[PER_RANK-2];
+    CU_ASSERT(lib_dist_verify(MPI_COMM_WORLD, vals, PER_RANK, &input) == 0);
+
+    /* One value dropped. */
+    if (id == world - 1)
+        vals[PER_RANK-1] = vals[PER_RANK-2] + 1;
+    CU_ASSERT(lib_dist_verify(MPI_COMM_WORLD, vals, id == 0 ? PER_RANK - 1 : PER_RANK, &input) == 0);
+
+    /* Every value there but two swapped. */
+    lib_swap(vals, vals + 3);
+    CU_ASSERT(lib_dist_verify(MPI_COMM_WORLD, vals, PER_RANK, &input) == 0);
+
+    free(all);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite distSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   distSuite = CU_add_suite("Distributed Sort Suite", suite_init, suite_clean);
+   if (NULL == distSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(distSuite, "Count Sort: Range...........", test_count_range)) ||
+       (NULL == CU_add_test(distSuite, "Count Sort: Few Unique......", test_count_few)) ||
+       (NULL == CU_add_test(distSuite, "Count Sort: Uneven..........", test_count_uneven)) ||
+       (NULL == CU_add_test(distSuite, "Count Sort: Wide Range......", test_count_wide)) ||
+       (NULL == CU_add_test(distSuite, "Count Sort: Sparse Range....", test_count_sparse)) ||
+       (NULL == CU_add_test(distSuite, "Count Sort: Empty...........", test_count_empty)) ||
+       (NULL == CU_add_test(distSuite, "Bucket Exchange.............", test_bucket_exchange)) ||
+       (NULL == CU_add_test(distSuite, "Bitonic.....................", test_bitonic)) ||
+       (NULL == CU_add_test(distSuite, "Top K.......................", test_top_k)) ||
+       (NULL == CU_add_test(distSuite, "Top K: Ties.................", test_top_k_ties)) ||
+       (NULL == CU_add_test(distSuite, "Top K: Edges................", test_top_k_edges)) ||
+       (NULL == CU_add_test(distSuite, "Select......................", test_dist_select)) ||
+       (NULL == CU_add_test(distSuite, "Multiselect.................", test_dist_multiselect)) ||
+       (NULL == CU_add_test(distSuite, "Multiselect: Sparse.........", test_dist_multiselect_sparse)) ||
+       (NULL == CU_add_test(distSuite, "Sketch Splitters............", test_sketch_splitters)) ||
+       (NULL == CU_add_test(distSuite, "Equalize....................", test_equalize)) ||
+       (NULL == CU_add_test(distSuite, "Place.......................", test_dist_place)) ||
+       (NULL == CU_add_test(distSuite, "Sorted......................", test_dist_sorted)) ||
+       (NULL == CU_add_test(distSuite, "Verify......................", test_dist_verify))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
@@ -0,0 +1,251 @@
+/**
+ * Tests for the out of core sort. Run files go to the current directory.
+ * Run under mpirun with a few tasks to exercise the distributed exchange.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "extern_ops.h"
+
+/******************* Constants/Macros *********************/
+#define TEMP_INPUT		"temp.ext.bin"
+#define TEMP_OUTPUT		"temp.ext.%d.bin"
+#define RUN_SIZE		500
+#define NUM_RUNS		7
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+    srand(time(NULL) + id);
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Write several sorted runs, some empty, and check the loser tree merges them in order.
+ */
+void test_merge_runs(void) {
+    ext_runs_t runs;
+    ext_merge_t merge;
+    int vals[RUN_SIZE], out[64], count = 0, total = 0, last = -1, ok = 1;
+
+    lib_ext_runs_init(&runs, ".", "temp.run", id);
+    for (int r = 0; r < NUM_RUNS; ++r) {
+        int size = r == 3 ? 0 : RUN_SIZE - r;
+        for (int i = 0; i < size; ++i)
+            vals[i] = rand() % 100;
+        qsort(vals, size, sizeof(int), lib_compare);
+        lib_ext_runs_add(&runs, vals, size);
+        total -= size;
+    }
+
+    /* Small block size forces many refills. */
+    lib_ext_merge_open(&merge, &runs, 16);
+    while ((count = lib_ext_merge_next(&merge, out, 64)) > 0) {
+        for (int i = 0; i < count; ++i) {
+            ok &= last <= out[i];
+            last = out[i];
+        }
+        total += count;
+    }
+    lib_ext_merge_close(&merge);
+    lib_ext_runs_free(&runs);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(total == 0);
+}
+
+/*
+ * Merging passes of three leave at most three runs holding the same values in order, files renamed per pass.
+ */
+void test_reduce_runs(void) {
+    ext_runs_t runs;
+    ext_merge_t merge;
+    int vals[RUN_SIZE], out[64], count = 0, total = 0, last = -1, ok = 1;
+    long held = 0;
+
+    lib_ext_runs_init(&runs, ".", "temp.red", id);
+    for (int r = 0; r < 4 * NUM_RUNS; ++r) {
+        int size = r % 5 == 3 ? 0 : RUN_SIZE - r;
+        for (int i = 0; i < size; ++i)
+            vals[i] = rand() % 1000;
+        qsort(vals, size, sizeof(int), lib_compare);
+        lib_ext_runs_add(&runs, vals, size);
+        total -= size;
+    }
+
+    lib_ext_runs_reduce(&runs, 3, 60);
+    CU_ASSERT(runs.count <= 3);
+    for (int r = 0; r < runs.count; ++r)
+        held += runs.sizes[r];
+    CU_ASSERT(held == -total);
+
+    lib_ext_merge_open(&merge, &runs, 10);
+    while ((count = lib_ext_merge_next(&merge, out, 64)) > 0) {
+        for (int i = 0; i < count; ++i) {
+            ok &= last <= out[i];
+            last = out[i];
+        }
+        total += count;
+    }
+    lib_ext_merge_close(&merge);
+    lib_ext_runs_free(&runs);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(total == 0);
+}
+
+/*
+ * Appending to a run in pieces gives the same stream back.
+ */
+void test_append_run(void) {
+    ext_runs_t runs;
+    ext_merge_t merge;
+    int vals[] = {1, 2, 3, 4, 5, 6}, out[10], count = 0;
+
+    lib_ext_runs_init(&runs, ".", "temp.app", id);
+    lib_ext_runs_add(&runs, vals, 2);
+    lib_ext_runs_append(&runs, 0, vals+2, 3);
+    lib_ext_runs_append(&runs, 0, vals+5, 1);
+
+    lib_ext_merge_open(&merge, &runs, 4);
+    count = lib_ext_merge_next(&merge, out, 10);
+    lib_ext_merge_close(&merge);
+    lib_ext_runs_free(&runs);
+
+    CU_ASSERT(count == 6);
+    for (int i = 0; i < count; ++i)
+        CU_ASSERT(out[i] == vals[i]);
+}
+
+/*
+ * Whole distributed sort with a budget much smaller than the input.
+ */
+void test_ext_sort(void) {
+    int total = 20000, mem_ints = 1000, *vals = NULL, ok = 1;
+    long written = 0, all = 0, in_sum = 0, out_sum = 0;
+    int my_first = 0, my_last = 0, prev_last = -1;
+    char name[EXT_NAME_SIZE];
+
+    if (id == ROOT) {
+        vals = malloc(total * sizeof(int));
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+        for (int i = 0; i < total; ++i) {
+            vals[i] = rand() % 5000;
+            in_sum += vals[i];
+        }
+        lib_write_binary(TEMP_INPUT, vals, sizeof(int), total, 0);
+        free(vals);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    written = lib_ext_sort(MPI_COMM_WORLD, TEMP_INPUT, TEMP_OUTPUT, mem_ints, ".");
+
+    /* Read back this rank's shard and check it. */
+    snprintf(name, EXT_NAME_SIZE, TEMP_OUTPUT, id);
+    vals = malloc((written > 0 ? written : 1) * sizeof(int));
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(vals, NULL);
+    CU_ASSERT(lib_read_binary(name, vals, sizeof(int), 0, written) == written);
+    for (long i = 0; i < written; ++i) {
+        ok &= i == 0 || vals[i-1] <= vals[i];
+        out_sum += vals[i];
+    }
+    if (written > 0) {
+        my_first = vals[0];
+        my_last = vals[written-1];
+    } else {
+        my_last = -1;
+    }
+    MPI_Exscan(&my_last, &prev_last, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (id > 0 && written > 0)
+        ok &= prev_last <= my_first;
+
+    MPI_Allreduce(MPI_IN_PLACE, &out_sum, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&written, &all, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Bcast(&in_sum, 1, MPI_LONG, ROOT, MPI_COMM_WORLD);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(all == total);
+    CU_ASSERT(out_sum == in_sum);
+
+    free(vals);
+    remove(name);
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (id == ROOT)
+        remove(TEMP_INPUT);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite externSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   externSuite = CU_add_suite("External Suite", suite_init, suite_clean);
+   if (NULL == externSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(externSuite, "Merge Runs..................", test_merge_runs)) ||
+       (NULL == CU_add_test(externSuite, "Reduce Runs.................", test_reduce_runs)) ||
+       (NULL == CU_add_test(externSuite, "Append Run..................", test_append_run)) ||
+       (NULL == CU_add_test(externSuite, "External Sort...............", test_ext_sort))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
@@ -78,6 +78,22 @@ void test_count_file_ints(void) {
     CU_ASSERT(count == expected_count);
 }
 
+/*
+ * Binary write, append and count, then read a slice back from an offset.
+ */
+void test_read_write_binary(void) {
+    int gen[AR_SIZE], read[AR_SIZE];
+
+    lib_generate_numbers(gen, AR_SIZE);
+    lib_write_binary(TEMP_FILE, gen, sizeof(int), AR_SIZE/2, 0);
+    lib_write_binary(TEMP_FILE, gen+AR_SIZE/2, sizeof(int), AR_SIZE - AR_SIZE/2, 1);
+
+    CU_ASSERT(lib_count_binary(TEMP_FILE, sizeof(int)) == AR_SIZE);
+    CU_ASSERT(lib_read_binary(TEMP_FILE, read, sizeof(int), 3, AR_SIZE) == AR_SIZE-3);
+    for (int i = 0; i < AR_SIZE-3; ++i)
+        CU_ASSERT(read[i] == gen[i+3]);
+}
+
 /* The main() function for setting up and running the tests.
  * Returns a CUE_SUCCESS on successful running, another
  * CUnit error code on failure.
@@ -99,7 +115,8 @@ int main() {
    /* Add the tests to the suite. */
    if (
        (NULL == CU_add_test(sharedSuite, "Write/Read", test_read_write_file)) ||
-       (NULL == CU_add_test(sharedSuite, "Simple Log", test_count_file_ints))
+       (NULL == CU_add_test(sharedSuite, "Simple Log", test_count_file_ints)) ||
+       (NULL == CU_add_test(sharedSuite, "Binary Write/Read", test_read_write_binary))
       )
    {
       CU_cleanup_registry();
@@ -0,0 +1,301 @@
+/**
+ * Tests for the parallel input generator. Run under mpirun with a few tasks to exercise the collective write.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+
+/******************* Constants/Macros *********************/
+#define TEMP_INPUT		"temp.gen.bin"
+#define GEN_SIZE		10000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+static int vals[GEN_SIZE], other[GEN_SIZE];
+
+/****************** Static Functions **********************/
+/*
+ * Fill vals with the whole input of dist using the default parameters.
+ */
+static void fill_dist(gen_params_t *params, const gen_dist_t dist) {
+    lib_gen_params(params, dist, GEN_SEED, GEN_SIZE, 4);
+    lib_gen_fill(params, vals, 0, GEN_SIZE);
+}
+
+/*
+ * Every value of vals is in [0, range).
+ */
+static int in_range(const int range) {
+    int ok = 1;
+
+    for (int i = 0; i < GEN_SIZE; ++i)
+        ok &= vals[i] >= 0 && vals[i] < range;
+
+    return ok;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Shares are contiguous, cover the whole input and differ by at most one.
+ */
+void test_share(void) {
+    long offset = 0, count = 0, next = 0;
+
+    for (int r = 0; r < 7; ++r) {
+        lib_gen_share(100, r, 7, &offset, &count);
+        CU_ASSERT(offset == next);
+        CU_ASSERT(count == 14 || count == 15);
+        next = offset + count;
+    }
+    CU_ASSERT(next == 100);
+}
+
+/*
+ * Command line names map to the distributions.
+ */
+void test_parse(void) {
+    CU_ASSERT(lib_gen_parse("uniform") == GEN_UNIFORM);
+    CU_ASSERT(lib_gen_parse("zipf") == GEN_ZIPF);
+    CU_ASSERT(lib_gen_parse("skew") == GEN_SKEWED);
+    CU_ASSERT(lib_gen_parse("bogus") == -1);
+}
+
+/*
+ * Generating in pieces gives the same values as in one go, same seed same input.
+ */
+void test_reproducible(void) {
+    gen_params_t params;
+    int same = 1;
+
+    for (int dist = GEN_UNIFORM; dist <= GEN_SKEWED; ++dist) {
+        fill_dist(&params, dist);
+        lib_gen_fill(&params, other, 0, 3000);
+        lib_gen_fill(&params, other+3000, 3000, GEN_SIZE-3000);
+        same &= memcmp(vals, other, sizeof(vals)) == 0;
+    }
+    CU_ASSERT(same);
+
+    /* A different seed changes the input. */
+    fill_dist(&params, GEN_UNIFORM);
+    params.seed = GEN_SEED + 1;
+    lib_gen_fill(&params, other, 0, GEN_SIZE);
+    CU_ASSERT(memcmp(vals, other, sizeof(vals)) != 0);
+}
+
+/*
+ * Uniform reaches negative and large positive values.
+ */
+void test_uniform(void) {
+    gen_params_t params;
+    int neg = 0, big = 0;
+
+    fill_dist(&params, GEN_UNIFORM);
+    for (int i = 0; i < GEN_SIZE; ++i) {
+        neg += vals[i] < 0;
+        big += vals[i] > MAX_VAL;
+    }
+    CU_ASSERT(neg > GEN_SIZE/4);
+    CU_ASSERT(big > GEN_SIZE/4);
+}
+
+/*
+ * Sorted and reverse are ordered over the whole input and stay in range.
+ */
+void test_sorted_reverse(void) {
+    gen_params_t params;
+    int up = 1, down = 1;
+
+    fill_dist(&params, GEN_SORTED);
+    for (int i = 1; i < GEN_SIZE; ++i)
+        up &= vals[i-1] <= vals[i];
+    CU_ASSERT(up);
+    CU_ASSERT(in_range(MAX_VAL));
+
+    fill_dist(&params, GEN_REVERSE);
+    for (int i = 1; i < GEN_SIZE; ++i)
+        down &= vals[i-1] >= vals[i];
+    CU_ASSERT(down);
+    CU_ASSERT(in_range(MAX_VAL));
+}
+
+/*
+ * Few unique yields no more than unique distinct values.
+ */
+void test_few_unique(void) {
+    gen_params_t params;
+    int distinct = 1;
+
+    fill_dist(&params, GEN_FEW_UNIQUE);
+    CU_ASSERT(in_range(MAX_VAL));
+    qsort(vals, GEN_SIZE, sizeof(int), lib_compare);
+    for (int i = 1; i < GEN_SIZE; ++i)
+        distinct += vals[i] != vals[i-1];
+    CU_ASSERT(distinct == GEN_UNIQUE);
+}
+
+/*
+ * Zipf with s = 1: value 0 is about twice as common as value 1 and far more than the median.
+ */
+void test_zipf(void) {
+    gen_params_t params;
+    int zero = 0, one = 0, below_mid = 0;
+
+    fill_dist(&params, GEN_ZIPF);
+    CU_ASSERT(in_range(MAX_VAL));
+    for (int i = 0; i < GEN_SIZE; ++i) {
+        zero += vals[i] == 0;
+        one += vals[i] == 1;
+        below_mid += vals[i] < MAX_VAL/2;
+    }
+    CU_ASSERT(zero > 1.5 * one && zero < 2.5 * one);
+    CU_ASSERT(below_mid > 0.9 * GEN_SIZE);
+}
+
+/*
+ * Neighbouring zipf values are independent: equal as often as values two apart. A rejected draw that
+ * reused the next index's state made neighbours match about 5% more often.
+ */
+void test_zipf_neighbours(void) {
+    gen_params_t params;
+    long lag1 = 0, lag2 = 0;
+    int *many = malloc(20 * GEN_SIZE * sizeof(int));
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(many, NULL);
+    for (int seed = 1; seed <= 5; ++seed) {
+        lib_gen_params(&params, GEN_ZIPF, seed, 20 * GEN_SIZE, 1);
+        params.unique = params.range = 200;
+        lib_gen_fill(&params, many, 0, 20 * GEN_SIZE);
+        for (int i = 0; i + 2 < 20 * GEN_SIZE; ++i) {
+            lag1 += many[i] == many[i+1];
+            lag2 += many[i] == many[i+2];
+        }
+    }
+    CU_ASSERT(lag1 < 1.025 * lag2 && lag2 < 1.025 * lag1);
+
+    free(many);
+}
+
+/*
+ * Skewed slice k stays below range*(k+1)/world, the first slice far below the last.
+ */
+void test_skewed(void) {
+    gen_params_t params;
+    int first_max = 0, last_max = 0;
+
+    fill_dist(&params, GEN_SKEWED);
+    CU_ASSERT(in_range(MAX_VAL));
+    for (int i = 0; i < GEN_SIZE/4; ++i) {
+        first_max = vals[i] > first_max ? vals[i] : first_max;
+        last_max = vals[GEN_SIZE-1-i] > last_max ? vals[GEN_SIZE-1-i] : last_max;
+    }
+    CU_ASSERT(first_max < MAX_VAL/4);
+    CU_ASSERT(last_max >= MAX_VAL/2);
+}
+
+/*
+ * Collective write matches what lib_gen_fill gives for the whole input, whatever the number of tasks.
+ */
+void test_write(void) {
+    gen_params_t params;
+
+    lib_gen_params(&params, GEN_RANGE, GEN_SEED, GEN_SIZE + 3, world);
+    lib_gen_write(MPI_COMM_WORLD, TEMP_INPUT, &params);
+
+    if (id == ROOT) {
+        int *read = malloc((GEN_SIZE + 3) * sizeof(int)), *expect = malloc((GEN_SIZE + 3) * sizeof(int));
+
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(read, NULL);
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(expect, NULL);
+        CU_ASSERT(lib_count_binary(TEMP_INPUT, sizeof(int)) == GEN_SIZE + 3);
+        CU_ASSERT(lib_read_binary(TEMP_INPUT, read, sizeof(int), 0, GEN_SIZE + 3) == GEN_SIZE + 3);
+        lib_gen_fill(&params, expect, 0, GEN_SIZE + 3);
+        CU_ASSERT(memcmp(read, expect, (GEN_SIZE + 3) * sizeof(int)) == 0);
+
+        free(read);
+        free(expect);
+        remove(TEMP_INPUT);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite genSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   genSuite = CU_add_suite("Generate Suite", suite_init, suite_clean);
+   if (NULL == genSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(genSuite, "Share.......................", test_share)) ||
+       (NULL == CU_add_test(genSuite, "Parse.......................", test_parse)) ||
+       (NULL == CU_add_test(genSuite, "Reproducible................", test_reproducible)) ||
+       (NULL == CU_add_test(genSuite, "Uniform.....................", test_uniform)) ||
+       (NULL == CU_add_test(genSuite, "Sorted And Reverse..........", test_sorted_reverse)) ||
+       (NULL == CU_add_test(genSuite, "Few Unique..................", test_few_unique)) ||
+       (NULL == CU_add_test(genSuite, "Zipf........................", test_zipf)) ||
+       (NULL == CU_add_test(genSuite, "Zipf: Neighbours............", test_zipf_neighbours)) ||
+       (NULL == CU_add_test(genSuite, "Skewed......................", test_skewed)) ||
+       (NULL == CU_add_test(genSuite, "Collective Write............", test_write))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
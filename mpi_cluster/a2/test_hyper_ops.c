@@ -0,0 +1,210 @@
+/**
+ * Tests for the in memory hypercube sort. Run under mpirun with a few tasks, any count works.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "typed_ops.h"
+#include "hyper_ops.h"
+
+/******************* Constants/Macros *********************/
+#define PER_RANK		3000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Key of element i of a type as a double, ranks compare boundaries on it.
+ */
+static double key_at(const void *buf, const hyper_type_t type, const int i) {
+    switch (type) {
+    case HYPER_I32: return ((const int32_t *)buf)[i];
+    case HYPER_I64: return (double)((const int64_t *)buf)[i];
+    case HYPER_U64: return (double)((const uint64_t *)buf)[i];
+    case HYPER_F64: return ((const double *)buf)[i];
+    default: return (double)((const kv64_t *)buf)[i].key;
+    }
+}
+
+/*
+ * Fill n elements of type with pseudo random keys, duplicates when few is set. Records carry three times their key.
+ */
+static void fill(void *buf, const hyper_type_t type, const int n, const int few) {
+    for (int i = 0; i < n; ++i) {
+        const int64_t r = few ? rand() % 5 : (int64_t)rand() * (rand() % 2 ? 1 : -1) * 4099;
+
+        switch (type) {
+        case HYPER_I32: ((int32_t *)buf)[i] = (int32_t)(r % 1000000000); break;
+        case HYPER_I64: ((int64_t *)buf)[i] = r; break;
+        case HYPER_U64: ((uint64_t *)buf)[i] = (uint64_t)r * 2654435761ULL; break;
+        case HYPER_F64: ((double *)buf)[i] = r / 7.0; break;
+        default:
+            ((kv64_t *)buf)[i].key = r;
+            ((kv64_t *)buf)[i].payload = 3 * r;
+            break;
+        }
+    }
+}
+
+/*
+ * Bytes of one element summed, each weighted by its place in a word.
+ */
+static unsigned long byte_sum(const void *buf, const size_t bytes) {
+    unsigned long sum = 0;
+
+    for (size_t b = 0; b < bytes; ++b)
+        sum += ((const unsigned char *)buf)[b] * (b % 8 + 1);
+
+    return sum;
+}
+
+/*
+ * Sort n elements of type per rank over comm and check the counts are kept, every rank is sorted, the ranks
+ * are in order and nothing was lost or duplicated (element wise sums, records keep their payload).
+ */
+static void check_hyper_sort(MPI_Comm comm, const hyper_type_t type, const int n, const int few) {
+    const size_t size = lib_hyper_elem_size(type);
+    unsigned long sums[2] = {0, 0};
+    double last = 0.0, below = 0.0;
+    int rank = 0, ok = 1;
+    void *buf = malloc((n > 0 ? n : 1) * size);
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(buf, NULL);
+    MPI_Comm_rank(comm, &rank);
+    fill(buf, type, n, few);
+
+    /* Bytes weighted by their place in the element, the total doesn't depend on the order of elements. */
+    for (int i = 0; i < n; ++i)
+        sums[0] += byte_sum((const char *)buf + i * size, size);
+    MPI_Allreduce(MPI_IN_PLACE, &sums[0], 1, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+
+    lib_hyper_sort(comm, buf, (size_t)n, type);
+
+    for (int i = 0; i < n; ++i) {
+        sums[1] += byte_sum((const char *)buf + i * size, size);
+        ok &= i == 0 || key_at(buf, type, i-1) <= key_at(buf, type, i);
+        if (type == HYPER_KV64)
+            ok &= ((kv64_t *)buf)[i].payload == 3 * ((kv64_t *)buf)[i].key;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &sums[1], 1, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+
+    /* A later rank's first key must be at least every earlier rank's last, empty ranks count as lowest. */
+    last = n > 0 ? key_at(buf, type, n-1) : -1e300;
+    MPI_Exscan(&last, &below, 1, MPI_DOUBLE, MPI_MAX, comm);
+    if (rank > 0 && n > 0)
+        ok &= below <= key_at(buf, type, 0);
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(sums[0] == sums[1]);
+
+    free(buf);
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Every type over all ranks, the same count on each.
+ */
+void test_hyper_types(void) {
+    srand(id + 1);
+    for (int t = 0; t < HYPER_TYPES; ++t)
+        check_hyper_sort(MPI_COMM_WORLD, t, PER_RANK, 0);
+}
+
+/*
+ * Different counts per rank stay as they were, empty ranks and heavy duplicates included.
+ */
+void test_hyper_uneven(void) {
+    srand(id + 7);
+    check_hyper_sort(MPI_COMM_WORLD, HYPER_I32, id * 1000, 0);
+    check_hyper_sort(MPI_COMM_WORLD, HYPER_KV64, id % 2 == 0 ? PER_RANK : 0, 1);
+    check_hyper_sort(MPI_COMM_WORLD, HYPER_I64, 0, 0);
+}
+
+/*
+ * A communicator other than world with a rank count that isn't a power of two.
+ */
+void test_hyper_comm(void) {
+    MPI_Comm comm;
+
+    srand(id + 13);
+    MPI_Comm_split(MPI_COMM_WORLD, id < 3 ? 0 : 1, world - id, &comm);
+    check_hyper_sort(comm, HYPER_F64, PER_RANK, 0);
+    check_hyper_sort(comm, HYPER_U64, PER_RANK / 2 + id, 1);
+    MPI_Comm_free(&comm);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite hyperSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   hyperSuite = CU_add_suite("In Memory Sort Suite", suite_init, suite_clean);
+   if (NULL == hyperSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(hyperSuite, "Hyper Sort: Types...........", test_hyper_types)) ||
+       (NULL == CU_add_test(hyperSuite, "Hyper Sort: Uneven..........", test_hyper_uneven)) ||
+       (NULL == CU_add_test(hyperSuite, "Hyper Sort: Communicator....", test_hyper_comm))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
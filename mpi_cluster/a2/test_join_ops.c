@@ -0,0 +1,245 @@
+/**
+ * Tests for the distributed join. Run under mpirun with a few tasks, any count works.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "file_ops.h"
+#include "gen_ops.h"
+#include "typed_ops.h"
+#include "dist_ops.h"
+#include "join_ops.h"
+
+/******************* Constants/Macros *********************/
+#define PER_RANK		500
+#define TEST_FILE		"temp.join.bin"
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Size records per rank, keys from dist and the global index as payload.
+ */
+static kv64_t *make_side(const gen_dist_t dist, const uint64_t seed, const int size) {
+    gen_params_t params;
+    kv64_t *side = malloc((size > 0 ? size : 1) * sizeof(kv64_t));
+
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(side, NULL);
+    lib_gen_params(&params, dist, seed, (long)size * world, world);
+    lib_gen_fill_kv64(&params, side, (long)id * size, size);
+
+    return side;
+}
+
+/*
+ * Sum of key, payload pairs over all ranks, a cheap check that no record was lost or made up.
+ */
+static long side_digest(const kv64_t side[], const int size) {
+    long digest = 0;
+
+    for (int i = 0; i < size; ++i)
+        digest += side[i].key * 31 + side[i].payload;
+    MPI_Allreduce(MPI_IN_PLACE, &digest, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    return digest;
+}
+
+/*
+ * Number of matching pairs between two sides, by brute force.
+ */
+static long brute_join(const kv64_t left[], const int left_size, const kv64_t right[], const int right_size) {
+    long rows = 0;
+
+    for (int i = 0; i < left_size; ++i)
+        for (int j = 0; j < right_size; ++j)
+            rows += left[i].key == right[j].key;
+
+    return rows;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Duplicate keys on both sides give their cross product, in key order.
+ */
+void test_merge_join(void) {
+    const kv64_t left[] = {{1, 10}, {2, 20}, {2, 21}, {4, 40}, {7, 70}};
+    const kv64_t right[] = {{0, 0}, {2, 200}, {2, 201}, {2, 202}, {4, 400}, {8, 800}};
+    join_row_t *rows = NULL;
+
+    CU_ASSERT_FATAL(lib_merge_join(left, 5, right, 6, &rows) == 7);
+    CU_ASSERT(rows[0].key == 2 && rows[0].left == 20 && rows[0].right == 200);
+    CU_ASSERT(rows[2].key == 2 && rows[2].left == 20 && rows[2].right == 202);
+    CU_ASSERT(rows[5].key == 2 && rows[5].left == 21 && rows[5].right == 202);
+    CU_ASSERT(rows[6].key == 4 && rows[6].left == 40 && rows[6].right == 400);
+    free(rows);
+
+    /* Nothing matches, or one side is empty. */
+    CU_ASSERT(lib_merge_join(left, 5, right, 1, &rows) == 0);
+    free(rows);
+    CU_ASSERT(lib_merge_join(left, 0, right, 6, &rows) == 0);
+    free(rows);
+}
+
+/*
+ * After partitioning both sides are sorted, in rank order, keep every record and share no key across ranks.
+ */
+void test_join_partition(void) {
+    kv64_t *left = make_side(GEN_FEW_UNIQUE, 3, PER_RANK), *right = make_side(GEN_ZIPF, 4, PER_RANK / 2);
+    int left_size = PER_RANK, right_size = PER_RANK / 2, ok = 1;
+    long before[2] = {side_digest(left, left_size), side_digest(right, right_size)};
+    int64_t bounds[2], prev = INT64_MIN;
+
+    lib_join_partition(MPI_COMM_WORLD, &left, &left_size, &right, &right_size);
+
+    CU_ASSERT(side_digest(left, left_size) == before[0]);
+    CU_ASSERT(side_digest(right, right_size) == before[1]);
+    for (int i = 1; i < left_size; ++i)
+        ok &= left[i-1].key <= left[i].key;
+    for (int i = 1; i < right_size; ++i)
+        ok &= right[i-1].key <= right[i].key;
+
+    /* Smallest and largest key here over both sides, every rank strictly above the ones before it. */
+    bounds[0] = INT64_MAX;
+    bounds[1] = INT64_MIN;
+    if (left_size > 0) {
+        bounds[0] = left[0].key;
+        bounds[1] = left[left_size-1].key;
+    }
+    if (right_size > 0) {
+        bounds[0] = right[0].key < bounds[0] ? right[0].key : bounds[0];
+        bounds[1] = right[right_size-1].key > bounds[1] ? right[right_size-1].key : bounds[1];
+    }
+    MPI_Exscan(&bounds[1], &prev, 1, MPI_INT64_T, MPI_MAX, MPI_COMM_WORLD);
+    if (id > 0 && left_size + right_size > 0)
+        ok &= prev < bounds[0];
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    CU_ASSERT(ok);
+
+    free(left);
+    free(right);
+}
+
+/*
+ * Partition, join and write, the file holds exactly the matches brute force finds on root.
+ */
+void test_join_write(void) {
+    kv64_t *left = make_side(GEN_FEW_UNIQUE, 5, PER_RANK / 4), *right = make_side(GEN_RANGE, 6, PER_RANK);
+    kv64_t *all_left = NULL, *all_right = NULL;
+    int left_size = PER_RANK / 4, right_size = PER_RANK, ok = 1;
+    long rows = 0, total = 0, expect = 0;
+    join_row_t *out = NULL, *back = NULL;
+    MPI_Datatype type = lib_mpi_type_kv64();
+
+    if (id == ROOT) {
+        all_left = malloc(left_size * world * sizeof(kv64_t));
+        all_right = malloc(right_size * world * sizeof(kv64_t));
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(all_left, NULL);
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(all_right, NULL);
+    }
+    MPI_Gather(left, left_size, type, all_left, left_size, type, ROOT, MPI_COMM_WORLD);
+    MPI_Gather(right, right_size, type, all_right, right_size, type, ROOT, MPI_COMM_WORLD);
+
+    lib_join_partition(MPI_COMM_WORLD, &left, &left_size, &right, &right_size);
+    rows = lib_merge_join(left, left_size, right, right_size, &out);
+    total = lib_dist_write(MPI_COMM_WORLD, TEST_FILE, out, sizeof(join_row_t), rows);
+
+    if (id == ROOT) {
+        expect = brute_join(all_left, PER_RANK / 4 * world, all_right, PER_RANK * world);
+        CU_ASSERT(expect > 0);
+        CU_ASSERT(total == expect);
+        CU_ASSERT(lib_count_binary(TEST_FILE, sizeof(join_row_t)) == expect);
+
+        /* Rows are in key order, every one a real match. */
+        back = malloc((expect > 0 ? expect : 1) * sizeof(join_row_t));
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(back, NULL);
+        CU_ASSERT(lib_read_binary(TEST_FILE, back, sizeof(join_row_t), 0, expect) == expect);
+        for (long r = 0; r < expect; ++r) {
+            ok &= r == 0 || back[r-1].key <= back[r].key;
+            ok &= all_left[back[r].left].key == back[r].key && all_right[back[r].right].key == back[r].key;
+        }
+        CU_ASSERT(ok);
+        remove(TEST_FILE);
+    }
+
+    free(left);
+    free(right);
+    free(out);
+    free(all_left);
+    free(all_right);
+    free(back);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite joinSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   joinSuite = CU_add_suite("Distributed Join Suite", suite_init, suite_clean);
+   if (NULL == joinSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(joinSuite, "Merge Join..................", test_merge_join)) ||
+       (NULL == CU_add_test(joinSuite, "Join Partition..............", test_join_partition)) ||
+       (NULL == CU_add_test(joinSuite, "Join Write..................", test_join_write))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
@@ -0,0 +1,171 @@
+/**
+ * Tests for the phase profiler. Run under mpirun with a few tasks to check the reduction.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "prof_ops.h"
+
+/******************* Constants/Macros *********************/
+#define TEMP_REPORT		"temp.profile.json"
+#define REPORT_SIZE		8192
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Spin for at least secs so a lap has something to measure.
+ */
+static void busy_wait(const double secs) {
+    double end = MPI_Wtime() + secs;
+
+    while (MPI_Wtime() < end)
+        ;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Each lap is charged to its own phase only.
+ */
+void test_lap(void) {
+    lib_prof_init();
+    busy_wait(0.002);
+    lib_prof_lap(PROF_READ);
+    lib_prof_lap(PROF_SCATTER);
+    busy_wait(0.001);
+    lib_prof_lap(PROF_LOCAL_SORT);
+
+    CU_ASSERT(lib_prof_time(PROF_READ) >= 0.002);
+    CU_ASSERT(lib_prof_time(PROF_SCATTER) < 0.001);
+    CU_ASSERT(lib_prof_time(PROF_LOCAL_SORT) >= 0.001);
+    CU_ASSERT(lib_prof_time(PROF_WRITE) == 0);
+}
+
+/*
+ * Round phases add up over rounds, init clears everything.
+ */
+void test_rounds(void) {
+    lib_prof_init();
+    for (int r = 0; r < 3; ++r) {
+        lib_prof_round(r);
+        busy_wait(0.001);
+        lib_prof_lap(PROF_PARTITION);
+        lib_prof_bytes(100, 50);
+    }
+
+    CU_ASSERT(lib_prof_time(PROF_PARTITION) >= 0.003);
+
+    lib_prof_init();
+    CU_ASSERT(lib_prof_time(PROF_PARTITION) == 0);
+}
+
+/*
+ * Root writes a report with every phase, rounds and the bytes and wire bytes reduced over all tasks.
+ */
+void test_report(void) {
+    char buf[REPORT_SIZE], expect[64];
+    FILE *f;
+    size_t len = 0;
+
+    lib_prof_init();
+    lib_prof_lap(PROF_READ);
+    for (int r = 0; r < 2; ++r) {
+        lib_prof_round(r);
+        lib_prof_bytes(1000 * (id+1), 10 * (id+1));
+        lib_prof_lap(PROF_EXCHANGE);
+    }
+    lib_prof_report(MPI_COMM_WORLD, TEMP_REPORT, "test");
+
+    if (id == ROOT) {
+        f = fopen(TEMP_REPORT, "r");
+        CU_ASSERT_PTR_NOT_EQUAL_FATAL(f, NULL);
+        len = fread(buf, 1, REPORT_SIZE-1, f);
+        buf[len] = '\0';
+        fclose(f);
+        remove(TEMP_REPORT);
+
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, "\"program\": \"test\""), NULL);
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, "\"rounds\": 2"), NULL);
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, "\"local_sort\""), NULL);
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, "\"round\": 1"), NULL);
+        snprintf(expect, sizeof(expect), "\"bytes\": {\"min\": 1000.000000000, \"max\": %d.000000000", 1000 * world);
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, expect), NULL);
+        snprintf(expect, sizeof(expect), "\"wire\": {\"min\": 10.000000000, \"max\": %d.000000000", 10 * world);
+        CU_ASSERT_PTR_NOT_EQUAL(strstr(buf, expect), NULL);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite profSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   profSuite = CU_add_suite("Profile Suite", suite_init, suite_clean);
+   if (NULL == profSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(profSuite, "Lap.........................", test_lap)) ||
+       (NULL == CU_add_test(profSuite, "Rounds......................", test_rounds)) ||
+       (NULL == CU_add_test(profSuite, "Report......................", test_report))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
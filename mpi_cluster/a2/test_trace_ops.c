@@ -0,0 +1,198 @@
+/**
+ * Tests for the binary tracing and its decoder. Each rank traces into its own file.
+ */
+/* setenv is posix, not c99. */
+#define _POSIX_C_SOURCE 200112L
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "trace_ops.h"
+
+/******************* Constants/Macros *********************/
+#define TEMP_LOG		"temp.log.%d.txt"
+#define NAME_SIZE		64
+#define LOG_BUF_SIZE	8192
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id;
+static char trace_name[NAME_SIZE], log_name[NAME_SIZE];
+static char log_buf[LOG_BUF_SIZE];
+
+/****************** Static Functions **********************/
+/*
+ * Decode this rank's trace and read the text into log_buf. Returns records decoded.
+ */
+static long decode_log(void) {
+    FILE *f;
+    size_t len = 0;
+    long records = lib_trace_decode(trace_name, log_name);
+
+    if ((f = fopen(log_name, "r")) == NULL)
+        return -1;
+    len = fread(log_buf, 1, LOG_BUF_SIZE-1, f);
+    log_buf[len] = '\0';
+    fclose(f);
+
+    remove(trace_name);
+    remove(log_name);
+    return records;
+}
+
+/*
+ * Number of times needle occurs in log_buf.
+ */
+static int count_in_log(const char *needle) {
+    int count = 0;
+
+    for (char *p = strstr(log_buf, needle); p != NULL; p = strstr(p+1, needle))
+        ++count;
+
+    return count;
+}
+
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+    snprintf(trace_name, NAME_SIZE, TRACE_FORMAT, id);
+    snprintf(log_name, NAME_SIZE, TEMP_LOG, id);
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Without QTRACE nothing is recorded and no file is written.
+ */
+void test_off(void) {
+    FILE *f;
+
+    unsetenv(TRACE_ENV);
+    lib_trace_init(id);
+    CU_ASSERT(lib_trace_on == 0);
+    TRACE_EVENT(TRACE_PIVOT, 1, 0, 5, 0);
+    lib_trace_close();
+
+    f = fopen(trace_name, "rb");
+    CU_ASSERT_PTR_EQUAL(f, NULL);
+    if (f != NULL)
+        fclose(f);
+}
+
+/*
+ * Events and arrays decode to the old text log.
+ */
+void test_decode(void) {
+    int vals[45];
+
+    for (int i = 0; i < 45; ++i)
+        vals[i] = 100 + i;
+
+    setenv(TRACE_ENV, "1", 1);
+    lib_trace_init(id);
+    CU_ASSERT(lib_trace_on == 1);
+    TRACE_EVENT(TRACE_INFO, id, 0, 1, 2);
+    TRACE_EVENT(TRACE_PIVOT, 1, 3, 42, 0);
+    TRACE_ARRAY(TRACE_RECV, vals, 45);
+    TRACE_ARRAY(TRACE_UNION, vals, 0);
+    lib_trace_close();
+    CU_ASSERT(lib_trace_on == 0);
+
+    /* Two events, an array of 1 + 7 records and an empty array. */
+    CU_ASSERT(decode_log() == 11);
+    CU_ASSERT(count_in_log("PIVOT: ROUND: 1, GROUP: 3, pivot is: 42.\n") == 1);
+    CU_ASSERT(count_in_log("INFO: World_id, Group, mem, partner.") == 1);
+    CU_ASSERT(count_in_log("RECV: Tracing an array, numbers are:\n") == 1);
+    CU_ASSERT(count_in_log("UNION: Tracing an array, numbers are:\n") == 1);
+    CU_ASSERT(count_in_log("RECV: ") == 4);
+    CU_ASSERT(count_in_log("RECV: 140 141 142 143 144 \n") == 1);
+    CU_ASSERT(count_in_log(" 144 ") == 1);
+}
+
+/*
+ * A small ring keeps only the newest records, a cut off array is skipped.
+ */
+void test_wrap(void) {
+    int vals[30];
+
+    for (int i = 0; i < 30; ++i)
+        vals[i] = i;
+
+    setenv(TRACE_ENV, "4", 1);
+    lib_trace_init(id);
+    TRACE_ARRAY(TRACE_SCATTER, vals, 30);
+    for (int r = 0; r < 3; ++r)
+        TRACE_EVENT(TRACE_PIVOT, r, 0, r*10, 0);
+    lib_trace_close();
+
+    CU_ASSERT(decode_log() == 4);
+    CU_ASSERT(count_in_log("SCATTER") == 0);
+    CU_ASSERT(count_in_log("pivot is: 0.") == 1);
+    CU_ASSERT(count_in_log("pivot is: 20.") == 1);
+    unsetenv(TRACE_ENV);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite traceSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   traceSuite = CU_add_suite("Trace Suite", suite_init, suite_clean);
+   if (NULL == traceSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(traceSuite, "Off.........................", test_off)) ||
+       (NULL == CU_add_test(traceSuite, "Decode......................", test_decode)) ||
+       (NULL == CU_add_test(traceSuite, "Wrap........................", test_wrap))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
@@ -0,0 +1,259 @@
+/**
+ * Tests for the typed array operations. Run under mpirun with a power of two tasks to also
+ * exercise the typed hypercube sort, with one task those tests only check the local side.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Project Headers */
+#include "CUnit/Basic.h"
+#include "mpi.h"
+#include "array_ops.h"
+#include "typed_ops.h"
+
+/******************* Constants/Macros *********************/
+#define BIG_SIZE		3000
+
+/******************* Type Definitions *********************/
+
+
+/**************** Static Data Definitions *****************/
+static int id, world;
+
+/****************** Static Functions **********************/
+/*
+ * Dimension of the cube for world, 0 if world isn't a power of two.
+ */
+static int world_dimension(void) {
+    for (int d = 1; d <= 10; ++d)
+        if (world == lib_power(2, d))
+            return d;
+
+    return 0;
+}
+
+/**************** Global Data Definitions *****************/
+
+
+/****************** Global Functions **********************/
+/*
+ * Suite initialization function run before each test.
+ */
+int suite_init(void) {
+    srand(time(NULL) + id);
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ */
+int suite_clean(void) {
+
+    return 0;
+}
+
+/*
+ * Sort 64 bit keys that don't fit in an int.
+ */
+void test_sort_i64(void) {
+    int64_t vals[BIG_SIZE];
+
+    for (int i = 0; i < BIG_SIZE; ++i)
+        vals[i] = ((int64_t)rand() << 32) - ((int64_t)rand() << 16);
+
+    lib_sort_i64(vals, BIG_SIZE);
+    for (int i = 1; i < BIG_SIZE; ++i)
+        CU_ASSERT_FATAL(vals[i-1] <= vals[i]);
+}
+
+/*
+ * Sort doubles with lots of duplicates, three way partition keeps it from degrading.
+ */
+void test_sort_f64_duplicates(void) {
+    double vals[BIG_SIZE];
+
+    for (int i = 0; i < BIG_SIZE; ++i)
+        vals[i] = (rand() % 5) * 0.5;
+
+    lib_sort_f64(vals, BIG_SIZE);
+    for (int i = 1; i < BIG_SIZE; ++i)
+        CU_ASSERT_FATAL(vals[i-1] <= vals[i]);
+}
+
+/*
+ * Payload has to move with its key.
+ */
+void test_sort_kv64_payload(void) {
+    kv64_t vals[BIG_SIZE];
+
+    for (int i = 0; i < BIG_SIZE; ++i) {
+        vals[i].key = rand() % 1000;
+        vals[i].payload = vals[i].key * 7 + 3;
+    }
+
+    lib_sort_kv64(vals, BIG_SIZE);
+    for (int i = 0; i < BIG_SIZE; ++i) {
+        if (i > 0)
+            CU_ASSERT_FATAL(vals[i-1].key <= vals[i].key);
+        CU_ASSERT_FATAL(vals[i].payload == vals[i].key * 7 + 3);
+    }
+}
+
+/*
+ * Unsigned keys above INT64_MAX must compare as unsigned.
+ */
+void test_partition_u64(void) {
+    uint64_t vals[] = {UINT64_MAX, 1, UINT64_MAX - 5, 0, 42}, pivot = 42;
+    int lt = 0, gt = 0;
+
+    lib_partition_u64(pivot, vals, 5, &lt, &gt);
+
+    CU_ASSERT(lt == 3);
+    CU_ASSERT(gt == 2);
+    for (int i = 0; i < 5; ++i)
+        CU_ASSERT(i < lt ? vals[i] <= pivot : vals[i] > pivot);
+}
+
+/*
+ * Select kth on the typed arrays.
+ */
+void test_select_kth_i32(void) {
+    int32_t vals[] = {62, 58, 41, 85, 39, 10, 64, 69, 41, 5, 98, 27, 2, 97, 30, 22, 39, 94, 56, 21};
+
+    CU_ASSERT(lib_select_kth_i32(vals, 20, 10) == 41);
+    CU_ASSERT(vals[9] == 41);
+    CU_ASSERT(lib_select_kth_i32(vals, 20, 1) == 2);
+    CU_ASSERT(lib_select_kth_i32(vals, 20, 20) == 98);
+}
+
+/*
+ * Derived datatype for records has the extent of the struct.
+ */
+void test_mpi_type_kv64(void) {
+    MPI_Aint lb = 0, extent = 0;
+
+    MPI_Type_get_extent(lib_mpi_type_kv64(), &lb, &extent);
+
+    CU_ASSERT(lb == 0);
+    CU_ASSERT(extent == sizeof(kv64_t));
+}
+
+/*
+ * Typed hypercube sort of records across the world, only runs with 2^d tasks.
+ */
+void test_hyper_quicksort_kv64(void) {
+    int dimension = world_dimension(), local_size = BIG_SIZE, total = 0, ok = 1;
+    int64_t my_min = INT64_MAX, my_max = INT64_MIN, prev_max = INT64_MIN;
+    kv64_t *local = NULL;
+
+    if (dimension == 0)
+        return;
+
+    local = malloc(local_size * sizeof(kv64_t));
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(local, NULL);
+    for (int i = 0; i < local_size; ++i) {
+        local[i].key = rand() % 100000 - 50000;
+        local[i].payload = -local[i].key;
+    }
+
+    lib_hyper_quicksort_kv64(MPI_COMM_WORLD, dimension, &local, &local_size);
+    lib_sort_kv64(local, local_size);
+
+    for (int i = 0; i < local_size; ++i)
+        ok &= (local[i].payload == -local[i].key);
+    if (local_size > 0) {
+        my_min = local[0].key;
+        my_max = local[local_size-1].key;
+    }
+
+    /* Every rank's smallest key must be >= all keys on lower ranks. */
+    MPI_Exscan(&my_max, &prev_max, 1, MPI_INT64_T, MPI_MAX, MPI_COMM_WORLD);
+    if (id > 0 && local_size > 0)
+        ok &= (prev_max <= my_min);
+    MPI_Allreduce(&local_size, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    CU_ASSERT(ok);
+    CU_ASSERT(total == BIG_SIZE * world);
+
+    free(local);
+}
+
+/*
+ * Nearly all keys equal, the equal band must be shared out so no rank ends up with everything.
+ */
+void test_hyper_quicksort_i32_duplicates(void) {
+    int dimension = world_dimension(), local_size = BIG_SIZE, total = 0, min_size = 0, max_size = 0;
+    int32_t *local = NULL;
+
+    if (dimension == 0)
+        return;
+
+    local = malloc(local_size * sizeof(int32_t));
+    CU_ASSERT_PTR_NOT_EQUAL_FATAL(local, NULL);
+    for (int i = 0; i < local_size; ++i)
+        local[i] = rand() % 50 == 0 ? rand() % 10 : 7;
+
+    lib_hyper_quicksort_i32(MPI_COMM_WORLD, dimension, &local, &local_size);
+
+    MPI_Allreduce(&local_size, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&local_size, &min_size, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&local_size, &max_size, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    CU_ASSERT(total == BIG_SIZE * world);
+    CU_ASSERT(min_size > BIG_SIZE / 2);
+    CU_ASSERT(max_size < BIG_SIZE * 3 / 2);
+
+    free(local);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char **argv) {
+   CU_pSuite typedSuite = NULL;
+   int error = 0;
+
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &id);
+   MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+   /* Initialize the CUnit test registry. */
+   if (CUE_SUCCESS != CU_initialize_registry())
+      return CU_get_error();
+
+   /* Add a suite to the registry. */
+   typedSuite = CU_add_suite("Typed Suite", suite_init, suite_clean);
+   if (NULL == typedSuite) {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Add the tests to the suite. */
+   if (
+       (NULL == CU_add_test(typedSuite, "Sort: i64...................", test_sort_i64)) ||
+       (NULL == CU_add_test(typedSuite, "Sort: f64 Duplicates........", test_sort_f64_duplicates)) ||
+       (NULL == CU_add_test(typedSuite, "Sort: kv64 Payload..........", test_sort_kv64_payload)) ||
+       (NULL == CU_add_test(typedSuite, "Partition: u64..............", test_partition_u64)) ||
+       (NULL == CU_add_test(typedSuite, "Select kth: i32.............", test_select_kth_i32)) ||
+       (NULL == CU_add_test(typedSuite, "MPI Type: kv64..............", test_mpi_type_kv64)) ||
+       (NULL == CU_add_test(typedSuite, "Hyper Quicksort: kv64.......", test_hyper_quicksort_kv64)) ||
+       (NULL == CU_add_test(typedSuite, "Hyper Quicksort: Duplicates.", test_hyper_quicksort_i32_duplicates))
+      )
+   {
+      CU_cleanup_registry();
+      return CU_get_error();
+   }
+
+   /* Run all tests using the CUnit Basic interface, only root reports. */
+   CU_basic_set_mode(id == ROOT ? CU_BRM_VERBOSE : CU_BRM_SILENT);
+   CU_basic_run_tests();
+   error = CU_get_number_of_failures();
+   CU_cleanup_registry();
+
+   MPI_Finalize();
+   return error;
+}
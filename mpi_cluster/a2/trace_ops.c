@@ -0,0 +1,242 @@
+/**
+ * Low overhead tracing, replaces the QDEBUG lib_log/lib_trace_array pair. That formatted and flushed text
+ * with localtime on every line, which distorted the timings it was meant to explain.
+ *
+ * Each rank appends fixed size binary records (time, event id, a few ints) to a ring in memory, nothing is
+ * formatted and no I/O happens while the sort runs. Text only exists in the decoder's table of formats.
+ * Tracing is chosen at runtime with QTRACE, when it is off every call site costs a load and a branch.
+ * At exit the ring is written to trace.<rank>.bin and qTrace renders it as the familiar log.<rank>.txt.
+ */
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Project Headers */
+#include "mpi.h"
+#include "array_ops.h"
+#include "trace_ops.h"
+
+/******************* Constants/Macros *********************/
+/* Numbers per line when an array is rendered. */
+#define TRACE_LINE_VALS     20
+#define TRACE_LINE_SIZE     256
+
+/******************* Type Definitions *********************/
+/* How the decoder renders an event, format is NULL for array events. */
+typedef struct trace_fmt_s {
+    const char *tag;
+    const char *format;
+} trace_fmt_t;
+
+/**************** Static Data Definitions *****************/
+/* Decoder table, same order as trace_event_t. */
+static const trace_fmt_t trace_fmts[TRACE_EVENTS] = {
+    {"INFO", "INFO: World_id, Group, mem, partner. %d %d %d %d.\n"},
+    {"PIVOT", "ROUND: %d, GROUP: %d, pivot is: %d.\n"},
+    {"SCATTER", NULL},
+    {"PARTITIONED", NULL},
+    {"RECV", NULL},
+    {"UNION", NULL},
+    {"HYPER", NULL},
+    {"GATHER", NULL}
+};
+
+/* Ring of records, total counts every record ever added so it also gives the next slot. */
+static trace_rec_t *trace_ring;
+static uint64_t trace_capacity, trace_total;
+static trace_header_t trace_header;
+
+/****************** Static Functions **********************/
+/*
+ * Next slot of the ring, overwrites the oldest record once full.
+ */
+static trace_rec_t *trace_next(const trace_event_t event, const int cont) {
+    trace_rec_t *rec = trace_ring + trace_total++ % trace_capacity;
+
+    rec->time = MPI_Wtime();
+    rec->event = event;
+    rec->cont = cont;
+    return rec;
+}
+
+/*
+ * Write the line prefix "(hh:mm:ss) TAG: " for a record.
+ */
+static void trace_prefix(FILE *f, const trace_header_t *header, const trace_rec_t *rec) {
+    time_t when = header->epoch + (time_t)(rec->time - header->wtime);
+    char date[30];
+
+    strftime(date, sizeof(date), "(%T)", localtime(&when));
+    fprintf(f, "%s %s: ", date, trace_fmts[rec->event].tag);
+}
+
+/*
+ * Flush at exit, registered by init.
+ */
+static void trace_atexit(void) {
+    lib_trace_close();
+}
+
+
+/**************** Global Data Definitions *****************/
+int lib_trace_on = 0;
+
+/****************** Global Functions **********************/
+/*
+ * Turn tracing on if TRACE_ENV is set and allocate the ring. The trace is written to TRACE_FORMAT
+ * by lib_trace_close or at exit, so it survives lib_error too.
+ */
+void lib_trace_init(const int rank) {
+    const char *env = getenv(TRACE_ENV);
+    long records = env == NULL ? 0 : atol(env);
+
+    if (records <= 0)
+        return;
+
+    trace_capacity = records == 1 ? TRACE_RECORDS : records;
+    trace_ring = malloc(trace_capacity * sizeof(trace_rec_t));
+    if (trace_ring == NULL)
+        lib_error("TRACE: Can't allocate ring on heap.");
+
+    trace_total = 0;
+    trace_header.magic = TRACE_MAGIC;
+    trace_header.rank = rank;
+    trace_header.epoch = time(NULL);
+    trace_header.wtime = MPI_Wtime();
+    lib_trace_on = 1;
+    atexit(trace_atexit);
+}
+
+/*
+ * Record an event with up to four int arguments. Use TRACE_EVENT instead.
+ */
+void lib_trace_event(const trace_event_t event, const int a, const int b, const int c, const int d) {
+    trace_rec_t *rec = trace_next(event, 0);
+
+    rec->count = 0;
+    rec->args[0] = a;
+    rec->args[1] = b;
+    rec->args[2] = c;
+    rec->args[3] = d;
+}
+
+/*
+ * Record the size and values of an array. Use TRACE_ARRAY instead.
+ */
+void lib_trace_array(const trace_event_t event, const int array[], const int size) {
+    trace_rec_t *rec = trace_next(event, 0);
+    int n = size < TRACE_ARGS ? size : TRACE_ARGS;
+
+    /* First record holds the size and the first values, continuations hold the rest. */
+    rec->count = size;
+    memcpy(rec->args, array, n * sizeof(int));
+    for (int i = n; i < size; i += n) {
+        n = size - i < TRACE_ARGS ? size - i : TRACE_ARGS;
+        rec = trace_next(event, 1);
+        rec->count = n;
+        memcpy(rec->args, array + i, n * sizeof(int));
+    }
+}
+
+/*
+ * Write the ring to the trace file and free it, does nothing if tracing is off.
+ */
+void lib_trace_close(void) {
+    char name[TRACE_LINE_SIZE];
+    uint64_t first = 0;
+    FILE *f;
+
+    if (!lib_trace_on)
+        return;
+    lib_trace_on = 0;
+
+    /* Oldest surviving record first, the ring may have wrapped. */
+    first = trace_total > trace_capacity ? trace_total - trace_capacity : 0;
+    trace_header.count = trace_total - first;
+    trace_header.lost = first;
+
+    snprintf(name, sizeof(name), TRACE_FORMAT, trace_header.rank);
+    if ((f = fopen(name, "wb")) == NULL)
+        lib_error("TRACE: Could not open trace file.");
+
+    fwrite(&trace_header, sizeof(trace_header), 1, f);
+    for (uint64_t i = first; i < trace_total; ++i)
+        fwrite(trace_ring + i % trace_capacity, sizeof(trace_rec_t), 1, f);
+
+    if (fclose(f) != 0)
+        lib_error("TRACE: Failed to close properly.");
+
+    free(trace_ring);
+    trace_ring = NULL;
+}
+
+/*
+ * Render a binary trace as the text log: (time) TAG: message, arrays as lines of numbers.
+ * Returns the number of records decoded.
+ */
+long lib_trace_decode(const char *input, const char *output) {
+    trace_header_t header;
+    trace_rec_t rec, head = {0};
+    FILE *in, *out;
+    long decoded = 0;
+    int left = 0, held = 0, on_line = 0;
+
+    if ((in = fopen(input, "rb")) == NULL)
+        lib_error("DECODE: Failed to open trace file.");
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != TRACE_MAGIC)
+        lib_error("DECODE: Not a trace file.");
+    if ((out = fopen(output, "w")) == NULL)
+        lib_error("DECODE: Failed to open log file.");
+
+    while (fread(&rec, sizeof(rec), 1, in) == 1) {
+        ++decoded;
+        if (rec.event < 0 || rec.event >= TRACE_EVENTS)
+            lib_error("DECODE: Unknown event in trace.");
+
+        /* Continuation whose head was overwritten in the ring, nothing to attach it to. */
+        if (rec.cont && left == 0)
+            continue;
+
+        /* A new event ends any array still open, the ring may have cut it short. */
+        if (!rec.cont && on_line) {
+            fprintf(out, "\n");
+            on_line = 0;
+        }
+
+        if (!rec.cont && trace_fmts[rec.event].format != NULL) {
+            left = 0;
+            trace_prefix(out, &header, &rec);
+            fprintf(out, trace_fmts[rec.event].format, rec.args[0], rec.args[1], rec.args[2], rec.args[3]);
+            continue;
+        }
+
+        /* Array events, header line then TRACE_LINE_VALS numbers per line like the old trace. */
+        if (!rec.cont) {
+            head = rec;
+            left = rec.count;
+            trace_prefix(out, &header, &head);
+            fprintf(out, "Tracing an array, numbers are:\n");
+        }
+        held = rec.cont ? rec.count : (left < TRACE_ARGS ? left : TRACE_ARGS);
+        for (int i = 0; i < held && left > 0; ++i, --left) {
+            if (on_line == 0)
+                trace_prefix(out, &header, &head);
+            fprintf(out, "%d ", rec.args[i]);
+            if (++on_line == TRACE_LINE_VALS || left == 1) {
+                fprintf(out, "\n");
+                on_line = 0;
+            }
+        }
+    }
+
+    if (on_line)
+        fprintf(out, "\n");
+
+    if (fclose(in) != 0 || fclose(out) != 0)
+        lib_error("DECODE: Failed to close properly.");
+
+    return decoded;
+}
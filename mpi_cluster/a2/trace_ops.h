@@ -0,0 +1,93 @@
+#ifndef _TRACE_OPS_H_
+#define _TRACE_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+
+/******************* Constants/Macros *********************/
+/* Environment variable that turns tracing on, 1 for the default ring size or the number of records to keep. */
+#define TRACE_ENV           "QTRACE"
+/* Records kept per rank by default, the oldest are overwritten once full. */
+#define TRACE_RECORDS       (1 << 16)
+/* Ints carried by one record, arrays continue over as many records as needed. */
+#define TRACE_ARGS          6
+/* Binary trace and the decoded text log, both sprinted with the rank. */
+#define TRACE_FORMAT        "trace.%d.bin"
+#define TRACE_LOG_FORMAT    "log.%d.txt"
+/* First word of a trace file. */
+#define TRACE_MAGIC         0x51545243
+
+/* Record an event only when tracing is on, a single load and branch otherwise. */
+#define TRACE_EVENT(event, a, b, c, d) \
+    do { if (lib_trace_on) lib_trace_event(event, a, b, c, d); } while (0)
+#define TRACE_ARRAY(event, array, size) \
+    do { if (lib_trace_on) lib_trace_array(event, array, size); } while (0)
+
+/******************* Type Declarations ********************/
+/* Events, each has a tag and a message format in the decoder's table. */
+typedef enum trace_event_e {
+    TRACE_INFO, /* World id, group, member and partner of a round. */
+    TRACE_PIVOT, /* Round, group and pivot. */
+    TRACE_SCATTER, /* Array events, the values of an array at that point. */
+    TRACE_PARTITIONED,
+    TRACE_RECV,
+    TRACE_UNION,
+    TRACE_HYPER,
+    TRACE_GATHER,
+    TRACE_EVENTS /* Number of events, not an event. */
+} trace_event_t;
+
+/* One fixed size record in the ring. */
+typedef struct trace_rec_s {
+    double time; /* MPI_Wtime when recorded. */
+    int16_t event; /* A trace_event_t. */
+    int16_t cont; /* 0 for the first record of an event, 1 for an array continuation. */
+    int32_t count; /* Array size on the first record, values held on a continuation. */
+    int32_t args[TRACE_ARGS]; /* Event arguments or array values. */
+} trace_rec_t;
+
+/* Start of a trace file, records follow oldest first. */
+typedef struct trace_header_s {
+    uint32_t magic; /* TRACE_MAGIC, rejects other files. */
+    int32_t rank; /* Rank that wrote the trace. */
+    int64_t epoch; /* Wall clock seconds at init. */
+    double wtime; /* MPI_Wtime at init, maps record times to the wall clock. */
+    uint64_t count; /* Records in the file. */
+    uint64_t lost; /* Older records overwritten when the ring wrapped. */
+} trace_header_t;
+
+/********************** Prototypes ************************/
+/* Non zero when tracing, tested by the macros before any call. */
+extern int lib_trace_on;
+
+/*
+ * Turn tracing on if TRACE_ENV is set and allocate the ring. The trace is written to TRACE_FORMAT
+ * by lib_trace_close or at exit, so it survives lib_error too.
+ */
+void lib_trace_init(const int rank);
+
+/*
+ * Record an event with up to four int arguments. Use TRACE_EVENT instead.
+ */
+void lib_trace_event(const trace_event_t event, const int a, const int b, const int c, const int d);
+
+/*
+ * Record the size and values of an array. Use TRACE_ARRAY instead.
+ */
+void lib_trace_array(const trace_event_t event, const int array[], const int size);
+
+/*
+ * Write the ring to the trace file and free it, does nothing if tracing is off.
+ */
+void lib_trace_close(void);
+
+/*
+ * Render a binary trace as the text log: (time) TAG: message, arrays as lines of numbers.
+ * Returns the number of records decoded.
+ */
+long lib_trace_decode(const char *input, const char *output);
+
+#endif /* _TRACE_OPS_H_ */
@@ -0,0 +1,54 @@
+#ifndef _TYPED_OPS_H_
+#define _TYPED_OPS_H_
+
+/********************* Header Files ***********************/
+/* C Headers */
+#include <stdint.h>
+
+/* Project Headers */
+#include "mpi.h"
+
+/******************* Constants/Macros *********************/
+/*
+ * Prototypes for one key type. S is the suffix appended to every name, T the element type
+ * and K the type of the key inside T (same as T unless records carry a payload).
+ * The bodies are generated by typed_ops_tmpl.h, see typed_ops.c for the list of types.
+ */
+#define TYPED_OPS_DECLARE(S, T, K) \
+    int lib_compare_##S(const void *a, const void *b); \
+    MPI_Datatype lib_mpi_type_##S(void); \
+    MPI_Datatype lib_mpi_key_type_##S(void); \
+    void lib_partition_##S(K pivot, T vals[], const int vals_size, int *lt_size, int *gt_size); \
+    K lib_select_kth_##S(T vals[], const int vals_size, const int kth); \
+    void lib_sort_##S(T vals[], const int vals_size); \
+    void lib_array_union_##S(T *a[], int *a_size, const T b[], const int b_size); \
+    void lib_hyper_quicksort_##S(MPI_Comm comm, const int dimension, T *local[], int *local_size);
+
+/******************* Type Declarations ********************/
+/* A 64 bit key with a payload that moves with it, i.e. a row id. */
+typedef struct kv64_s {
+    int64_t key;
+    int64_t payload;
+} kv64_t;
+
+/********************** Prototypes ************************/
+/*
+ * Every type gets the same set of functions:
+ *
+ * lib_compare_S: Increasing comparator on the key for qsort/bsearch.
+ * lib_mpi_type_S: MPI datatype of one element, derived struct type for records.
+ * lib_mpi_key_type_S: MPI datatype of the key alone, used to send pivots.
+ * lib_partition_S: Partition in place, keys <= pivot at front and keys > pivot at back.
+ * lib_select_kth_S: Reorder so the kth smallest key (k = 1..N) is at kth-1 and return the key.
+ * lib_sort_S: Introsort on the key, no function pointer per comparison.
+ * lib_array_union_S: Append b onto the malloced array a, same contract as lib_array_union.
+ * lib_hyper_quicksort_S: Hypercube quicksort over comm, comm size must be 2^dimension.
+ *      Afterwards every rank holds keys <= those of higher ranks and may locally sort.
+ */
+TYPED_OPS_DECLARE(i32, int32_t, int32_t)
+TYPED_OPS_DECLARE(i64, int64_t, int64_t)
+TYPED_OPS_DECLARE(u64, uint64_t, uint64_t)
+TYPED_OPS_DECLARE(f64, double, double)
+TYPED_OPS_DECLARE(kv64, kv64_t, int64_t)
+
+#endif /* _TYPED_OPS_H_ */
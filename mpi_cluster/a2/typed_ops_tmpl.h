@@ -0,0 +1,380 @@
+/**
+ * Template body for the typed array operations, included once per key type by typed_ops.c.
+ * Not a normal header, there is deliberately no include guard. Before including define:
+ *
+ * TY_S: Suffix for the generated names, i.e. i64.
+ * TY_T: Element type stored in the arrays.
+ * TY_K: Key type, the part of TY_T that is compared.
+ * TY_KEY(x): Expression reading the key of element x.
+ * TY_MPI_ELEM: MPI datatype of one element.
+ * TY_MPI_KEY: MPI datatype of one key.
+ *
+ * Keys are compared inline with < and >, so the hot loops have no function pointer per element
+ * the way qsort with lib_compare does. All parameters are undefined at the bottom.
+ */
+/******************* Constants/Macros *********************/
+#ifndef TY_FN
+/* Paste the suffix onto a name, two levels so TY_S is expanded first. */
+#define TY_CAT_(name, suffix)   name##_##suffix
+#define TY_CAT(name, suffix)    TY_CAT_(name, suffix)
+#define TY_FN(name)             TY_CAT(name, TY_S)
+
+/* Offset block size for the branchless partition, must fit in an unsigned char. */
+#define TY_BLOCK                128
+/* Below this size partitions use the plain scan. */
+#define TY_BLOCK_MIN            256
+/* Below this size sorts use insertion sort. */
+#define TY_INSERTION            16
+/* Tags used by the typed hypercube rounds, distinct from those in qParallel.c. */
+#define TY_PIVOT_TAG            10
+#define TY_EXCHANGE_TAG         11
+#define TY_COUNT_TAG            12
+#endif
+
+/****************** Static Functions **********************/
+/*
+ * Simple swap function.
+ */
+static inline void TY_FN(ty_swap)(TY_T *a, TY_T *b) {
+    TY_T temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+/*
+ * Hoare style scan partition, returns number of keys <= pivot now at the front.
+ */
+static int TY_FN(ty_partition_scan)(TY_K pivot, TY_T vals[], const int size) {
+    TY_T *left = vals, *right = vals + size-1;
+    int lt_size = 0;
+
+    if (size <= 0)
+        return 0;
+
+    while (left < right) {
+        while (left < right && TY_KEY(*left) <= pivot) {
+            ++left;
+            ++lt_size;
+        }
+        while (left < right && TY_KEY(*right) > pivot)
+            --right;
+        if (left < right)
+            TY_FN(ty_swap)(left, right);
+    }
+
+    if (TY_KEY(*left) <= pivot)
+        ++lt_size;
+
+    return lt_size;
+}
+
+/*
+ * Branchless block partition, same scheme as partition_block in array_ops.c.
+ */
+static int TY_FN(ty_partition_block)(TY_K pivot, TY_T vals[], const int size) {
+    unsigned char offs_l[TY_BLOCK], offs_r[TY_BLOCK];
+    TY_T *left = vals, *right = vals + size-1;
+    int num_l = 0, num_r = 0, start_l = 0, start_r = 0, num = 0;
+
+    while (right - left + 1 > 2*TY_BLOCK) {
+        if (num_l == 0) {
+            start_l = 0;
+            for (int i = 0; i < TY_BLOCK; ++i) {
+                offs_l[num_l] = i;
+                num_l += (TY_KEY(left[i]) > pivot);
+            }
+        }
+        if (num_r == 0) {
+            start_r = 0;
+            for (int i = 0; i < TY_BLOCK; ++i) {
+                offs_r[num_r] = i;
+                num_r += (TY_KEY(*(right - i)) <= pivot);
+            }
+        }
+
+        num = num_l < num_r ? num_l : num_r;
+        for (int j = 0; j < num; ++j)
+            TY_FN(ty_swap)(left + offs_l[start_l + j], right - offs_r[start_r + j]);
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+
+        if (num_l == 0)
+            left += TY_BLOCK;
+        if (num_r == 0)
+            right -= TY_BLOCK;
+    }
+
+    return (left - vals) + TY_FN(ty_partition_scan)(pivot, left, right - left + 1);
+}
+
+/*
+ * Median key of the first, middle and last elements.
+ */
+static inline TY_K TY_FN(ty_median_of_three)(const TY_T vals[], const int size) {
+    TY_K a = TY_KEY(vals[0]), b = TY_KEY(vals[size/2]), c = TY_KEY(vals[size-1]);
+
+    if (a < b)
+        return b < c ? b : (a < c ? c : a);
+    return a < c ? a : (b < c ? c : b);
+}
+
+/*
+ * Three way partition around pivot (Dijkstra). Afterwards [0, *lt) < pivot, [*lt, *gt) == pivot
+ * and [*gt, size) > pivot. Keeps sorts and selects linear on runs of equal keys.
+ */
+static void TY_FN(ty_partition_three)(TY_K pivot, TY_T vals[], const int size, int *lt, int *gt) {
+    int lo = 0, i = 0, hi = size;
+    TY_K key;
+
+    while (i < hi) {
+        key = TY_KEY(vals[i]);
+        if (key < pivot)
+            TY_FN(ty_swap)(vals + lo++, vals + i++);
+        else if (key > pivot)
+            TY_FN(ty_swap)(vals + i, vals + --hi);
+        else
+            ++i;
+    }
+
+    *lt = lo;
+    *gt = hi;
+}
+
+/*
+ * Insertion sort for the small ranges left by introsort.
+ */
+static void TY_FN(ty_sort_insertion)(TY_T vals[], const int size) {
+    TY_T temp;
+    int j = 0;
+
+    for (int i = 1; i < size; ++i) {
+        temp = vals[i];
+        for (j = i; j > 0 && TY_KEY(vals[j-1]) > TY_KEY(temp); --j)
+            vals[j] = vals[j-1];
+        vals[j] = temp;
+    }
+}
+
+/*
+ * Restore the max heap property below root.
+ */
+static void TY_FN(ty_sift_down)(TY_T vals[], int root, const int size) {
+    int child = 0;
+
+    while ((child = 2*root + 1) < size) {
+        if (child+1 < size && TY_KEY(vals[child]) < TY_KEY(vals[child+1]))
+            ++child;
+        if (!(TY_KEY(vals[root]) < TY_KEY(vals[child])))
+            return;
+        TY_FN(ty_swap)(vals + root, vals + child);
+        root = child;
+    }
+}
+
+/*
+ * Heapsort, fallback when introsort recursion gets too deep.
+ */
+static void TY_FN(ty_sort_heap)(TY_T vals[], const int size) {
+    for (int i = size/2 - 1; i >= 0; --i)
+        TY_FN(ty_sift_down)(vals, i, size);
+
+    for (int i = size-1; i > 0; --i) {
+        TY_FN(ty_swap)(vals, vals + i);
+        TY_FN(ty_sift_down)(vals, 0, i);
+    }
+}
+
+/*
+ * Introsort body, recurse on the smaller side and loop on the larger.
+ */
+static void TY_FN(ty_sort_intro)(TY_T vals[], int size, int depth) {
+    int lt = 0, gt = 0;
+
+    while (size > TY_INSERTION) {
+        if (depth-- == 0) {
+            TY_FN(ty_sort_heap)(vals, size);
+            return;
+        }
+
+        TY_FN(ty_partition_three)(TY_FN(ty_median_of_three)(vals, size), vals, size, &lt, &gt);
+
+        if (lt < size - gt) {
+            TY_FN(ty_sort_intro)(vals, lt, depth);
+            vals += gt;
+            size -= gt;
+        } else {
+            TY_FN(ty_sort_intro)(vals + gt, size - gt, depth);
+            size = lt;
+        }
+    }
+
+    TY_FN(ty_sort_insertion)(vals, size);
+}
+
+/****************** Global Functions **********************/
+/*
+ * Increasing comparator on the key.
+ */
+int TY_FN(lib_compare)(const void *a, const void *b) {
+    TY_K ka = TY_KEY(*(const TY_T *)a), kb = TY_KEY(*(const TY_T *)b);
+
+    return (ka > kb) - (ka < kb);
+}
+
+/*
+ * MPI datatype of one element.
+ */
+MPI_Datatype TY_FN(lib_mpi_type)(void) {
+    return TY_MPI_ELEM;
+}
+
+/*
+ * MPI datatype of one key.
+ */
+MPI_Datatype TY_FN(lib_mpi_key_type)(void) {
+    return TY_MPI_KEY;
+}
+
+/*
+ * Partition in place, keys <= pivot at front and keys > pivot at back.
+ */
+void TY_FN(lib_partition)(TY_K pivot, TY_T vals[], const int vals_size, int *lt_size, int *gt_size) {
+    if (vals_size < TY_BLOCK_MIN)
+        *lt_size = TY_FN(ty_partition_scan)(pivot, vals, vals_size);
+    else
+        *lt_size = TY_FN(ty_partition_block)(pivot, vals, vals_size);
+
+    *gt_size = vals_size - *lt_size;
+}
+
+/*
+ * Reorder so the kth smallest key (k = 1..N) is at kth-1 and return the key.
+ */
+TY_K TY_FN(lib_select_kth)(TY_T vals[], const int vals_size, const int kth) {
+    TY_T *base = vals;
+    int size = vals_size, k = kth-1, lt = 0, gt = 0;
+
+    if (kth < 1 || kth > vals_size)
+        lib_error("SELECT_KTH: kth is outside of the array.");
+
+    while (size > TY_INSERTION) {
+        TY_FN(ty_partition_three)(TY_FN(ty_median_of_three)(base, size), base, size, &lt, &gt);
+
+        if (k < lt) {
+            size = lt;
+        } else if (k >= gt) {
+            base += gt;
+            size -= gt;
+            k -= gt;
+        } else {
+            return TY_KEY(base[k]);
+        }
+    }
+
+    TY_FN(ty_sort_insertion)(base, size);
+    return TY_KEY(base[k]);
+}
+
+/*
+ * Introsort on the key.
+ */
+void TY_FN(lib_sort)(TY_T vals[], const int vals_size) {
+    int depth = 0;
+
+    for (int n = vals_size; n > 1; n >>= 1)
+        depth += 2;
+
+    TY_FN(ty_sort_intro)(vals, vals_size, depth);
+}
+
+/*
+ * Function takes two arrays of passed size and merges them into array a.
+ * Assumes that a is in fact a malloced array that can be freed.
+ */
+void TY_FN(lib_array_union)(TY_T *a[], int *a_size, const TY_T b[], const int b_size) {
+    int new_size = *a_size + b_size;
+    TY_T *temp = NULL;
+
+    if (new_size != 0) {
+        temp = malloc(new_size * sizeof(TY_T));
+        if (temp == NULL)
+            lib_error("UNION: Can't allocate merged array.");
+        memcpy(temp, *a, (*a_size)*sizeof(TY_T));
+        memcpy(temp+(*a_size), b, b_size*sizeof(TY_T));
+
+        if (*a != NULL)
+            free(*a);
+        *a = temp;
+        *a_size = new_size;
+    }
+}
+
+/*
+ * Hypercube quicksort over comm, same rounds as hyper_quicksort in qParallel.c.
+ * The receiver probes for the real count so no padded receive buffer is needed.
+ * Partitions are three way and the keys equal to the pivot are split by load, see lib_split_equal.
+ */
+void TY_FN(lib_hyper_quicksort)(MPI_Comm comm, const int dimension, TY_T *local[], int *local_size) {
+    MPI_Status mpi_status;
+    MPI_Request mpi_request;
+    MPI_Datatype elem_type = TY_MPI_ELEM, key_type = TY_MPI_KEY;
+    subgroup_info_t info = {0, 0, 0, 0, 0};
+    TY_T *recv = NULL, *send = NULL;
+    TY_K pivot = 0;
+    int world = 0, lt_end = 0, gt_start = 0, received = 0, send_from = 0, send_size = 0, keep_from = 0, keep_size = 0;
+    int mine[3] = {0, 0, 0}, theirs[3] = {0, 0, 0};
+
+    MPI_Comm_rank(comm, &info.world_id);
+    MPI_Comm_size(comm, &world);
+    if (dimension < 1 || world != lib_power(2, dimension))
+        lib_error("HYPER: Communicator size must be 2^dimension.");
+
+    for (int d = dimension-1; d >= 0; --d) {
+        lib_subgroup_info(d+1, &info);
+
+        /* Subgroup root picks the median of its keys, an empty root can only guess. */
+        if (info.member_num == 0) {
+            pivot = *local_size > 0 ? TY_FN(lib_select_kth)(*local, *local_size, (*local_size+1)/2) : 0;
+            for (int i = 1; i < info.group_size; ++i)
+                MPI_Send(&pivot, 1, key_type, info.world_id+i, TY_PIVOT_TAG, comm);
+        } else {
+            MPI_Recv(&pivot, 1, key_type, info.world_id - info.member_num, TY_PIVOT_TAG, comm, &mpi_status);
+        }
+
+        TY_FN(ty_partition_three)(pivot, *local, *local_size, &lt_end, &gt_start);
+        mine[0] = lt_end;
+        mine[1] = gt_start - lt_end;
+        mine[2] = *local_size - gt_start;
+
+        /* Upper half of this dimension sends its low part, lower half sends its high part, equal keys by load. */
+        MPI_Sendrecv(mine, 3, MPI_INT, info.partner, TY_COUNT_TAG, theirs, 3, MPI_INT, info.partner, TY_COUNT_TAG,
+                comm, &mpi_status);
+        lib_split_equal(mine, theirs, info.world_id & (1<<d), &keep_from, &keep_size, &send_from, &send_size);
+        send = *local + send_from;
+
+        MPI_Isend(send, send_size, elem_type, info.partner, TY_EXCHANGE_TAG, comm, &mpi_request);
+        MPI_Probe(info.partner, TY_EXCHANGE_TAG, comm, &mpi_status);
+        MPI_Get_count(&mpi_status, elem_type, &received);
+
+        recv = malloc((received > 0 ? received : 1) * sizeof(TY_T));
+        if (recv == NULL)
+            lib_error("HYPER: Can't allocate recv array on heap.");
+        MPI_Recv(recv, received, elem_type, info.partner, TY_EXCHANGE_TAG, comm, &mpi_status);
+        MPI_Wait(&mpi_request, MPI_STATUS_IGNORE);
+
+        /* Send has completed, safe to drop the sent part and append what came back. */
+        memmove(*local, *local + keep_from, keep_size*sizeof(TY_T));
+        *local_size = keep_size;
+        TY_FN(lib_array_union)(local, local_size, recv, received);
+        free(recv);
+    }
+}
+
+#undef TY_S
+#undef TY_T
+#undef TY_K
+#undef TY_KEY
+#undef TY_MPI_ELEM
+#undef TY_MPI_KEY